@@ -0,0 +1,257 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../../../src/subset_sum_solving/dp_bitset_base.hpp"
+#include "../../../src/helper/error_exit.hpp"
+#include "../../../src/sys/fs.hpp"
+
+using dp_bitset_base::num_t, dp_bitset_base::word_t, dp_bitset_base::OnesStrategys, dp_bitset_base::FillDirection;
+
+namespace {
+
+using bench_clock = std::chrono::steady_clock;
+
+constexpr size_t repetitions = 9;
+
+template <typename T>
+[[gnu::always_inline]] inline void do_not_optimize (T& value) {
+    asm volatile("" : "+m"(value) : : "memory");
+}
+
+// Fastest of `repetitions` runs in nanoseconds.
+template <typename F>
+[[nodiscard]] uint64_t measure_ns (F&& f) {
+    uint64_t best = std::numeric_limits<uint64_t>::max();
+    for (size_t i = 0; i < repetitions; i++) {
+        const auto start = bench_clock::now();
+        f();
+        const auto end = bench_clock::now();
+        best = std::min(best, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()));
+    }
+    return best;
+}
+
+
+// ones
+
+constexpr size_t ones_inputs_count = size_t{1} << 16;
+
+template <FillDirection direction, OnesStrategys strategy>
+[[nodiscard]] uint64_t bench_ones_direction (const std::vector<uint16_t>& inputs) {
+    return measure_ns([&inputs] {
+        word_t acc = mmXXX_setzero_siXXX();
+        for (const uint16_t n : inputs) {
+            acc ^= dp_bitset_base::ones<direction, strategy>(n);
+        }
+        do_not_optimize(acc);
+    });
+}
+
+template <OnesStrategys strategy>
+[[nodiscard]] uint64_t bench_ones (const std::vector<uint16_t>& inputs) {
+    return bench_ones_direction<FillDirection::TO, strategy>(inputs)
+         + bench_ones_direction<FillDirection::FROM, strategy>(inputs);
+}
+
+struct OnesCandidate {
+    std::string_view name;
+    uint64_t (*run)(const std::vector<uint16_t>&);
+};
+
+constexpr OnesCandidate ones_candidates[] {
+    {"FULL_LUT", &bench_ones<OnesStrategys::FULL_LUT>},
+    {"HYBRID_LUT_SCALAR", &bench_ones<OnesStrategys::HYBRID_LUT_SCALAR>},
+    {"HYBRID_LUT_VECTOR", &bench_ones<OnesStrategys::HYBRID_LUT_VECTOR>},
+    {"ARITHMETIC_SCALAR", &bench_ones<OnesStrategys::ARITHMETIC_SCALAR>},
+    {"ARITHMETIC_VECTOR", &bench_ones<OnesStrategys::ARITHMETIC_VECTOR>}
+};
+
+
+// apply_num_unsafe / apply_nums_unsafe
+
+struct BitsetCase {
+    num_t target;
+    std::vector<num_t> nums;
+};
+
+// Bitsets from a few cache lines up to well past L2, with mostly small field sizes and a few big ones like in wide variants.
+[[nodiscard]] std::vector<BitsetCase> make_bitset_cases (std::mt19937_64& rng) {
+    constexpr num_t targets[] {num_t{1} << 12, num_t{1} << 15, num_t{1} << 18, num_t{1} << 21};
+    constexpr size_t nums_per_case = 32;
+
+    std::vector<BitsetCase> cases;
+    for (const num_t target : targets) {
+        BitsetCase& bitset_case = cases.emplace_back(target, std::vector<num_t>(nums_per_case));
+        for (num_t& num : bitset_case.nums) {
+            num = (rng() % 4 == 0) ? (rng() % (target / 8)) + 1 : (rng() % 64) + 1;
+        }
+    }
+    return cases;
+}
+
+template <typename Apply>
+[[nodiscard]] uint64_t bench_bitset (const BitsetCase& bitset_case, std::vector<word_t>& words, Apply&& apply) {
+    const num_t word_count = dp_bitset_base::bitset_word_count(bitset_case.target);
+    words.resize(word_count);
+    return measure_ns([&] {
+        dp_bitset_base::init_bits(words.data(), word_count);
+        apply(bitset_case.nums, words.data(), word_count);
+        do_not_optimize(words[word_count - 1]);
+    });
+}
+
+void apply_sequential (const std::span<const num_t> nums, word_t* const words, const num_t word_count) {
+    for (const num_t num : nums) {
+        dp_bitset_base::apply_num_unsafe(num, words, word_count);
+    }
+}
+
+struct BlockingCandidate {
+    uint32_t tile_bytes;
+    uint32_t batch_size;
+    void (*apply)(std::span<const num_t>, word_t*, num_t);
+};
+
+constexpr BlockingCandidate blocking_candidates[] {
+    {1024, 2, &dp_bitset_base::apply_nums_unsafe<1024, 2>},
+    {1024, 4, &dp_bitset_base::apply_nums_unsafe<1024, 4>},
+    {1024, 8, &dp_bitset_base::apply_nums_unsafe<1024, 8>},
+    {2048, 2, &dp_bitset_base::apply_nums_unsafe<2048, 2>},
+    {2048, 4, &dp_bitset_base::apply_nums_unsafe<2048, 4>},
+    {2048, 8, &dp_bitset_base::apply_nums_unsafe<2048, 8>},
+    {4096, 2, &dp_bitset_base::apply_nums_unsafe<4096, 2>},
+    {4096, 4, &dp_bitset_base::apply_nums_unsafe<4096, 4>},
+    {4096, 8, &dp_bitset_base::apply_nums_unsafe<4096, 8>},
+    {8192, 2, &dp_bitset_base::apply_nums_unsafe<8192, 2>},
+    {8192, 4, &dp_bitset_base::apply_nums_unsafe<8192, 4>}
+};
+
+// The lane shift of a num selects the shift path of apply_num_unsafe.
+void report_lane_shift_paths (const std::vector<BitsetCase>& cases, std::vector<word_t>& words) {
+    for (num_t lane_shift = 0; lane_shift < dp_bitset_base::WORD_LANE_COUNT; lane_shift++) {
+        const num_t num = dp_bitset_base::WORD_BITS + (lane_shift * dp_bitset_base::LANE_BITS) + 1;
+        for (const BitsetCase& bitset_case : cases) {
+            const BitsetCase single {bitset_case.target, {num}};
+            const uint64_t ns = bench_bitset(single, words, &apply_sequential);
+            console.info("apply_num_unsafe lane_shift=", lane_shift, " target=", bitset_case.target, ": ", ns, " ns");
+        }
+    }
+}
+
+void write_config (const std::string& path, const std::string_view ones_strategy, const BlockingCandidate& blocking) {
+    std::string config;
+    config += "#pragma once\n\n";
+    config += "// Generated by bench_dp_bitset_base for this host. Re-run the tune target instead of editing.\n\n";
+    config += "#define DP_BITSET_ONES_STRATEGY ";
+    config += ones_strategy;
+    config += "\n#define DP_BITSET_TILE_BYTES ";
+    config += std::to_string(blocking.tile_bytes);
+    config += "\n#define DP_BITSET_APPLY_BATCH_SIZE ";
+    config += std::to_string(blocking.batch_size);
+    config += "\n";
+
+    auto file = fs::File::open(
+        path,
+        estd::variadic_v<
+            fs::OPEN_FLAGS::WRONLY,
+            fs::OPEN_FLAGS::CREAT,
+            fs::OPEN_FLAGS::TRUNC
+        >{},
+        estd::variadic_v<
+            fs::PERMISSION_MODE::IRUSR,
+            fs::PERMISSION_MODE::IWUSR
+        >{},
+        [&path](const sys::OPEN_ERROR) {
+            error_exit("Failed to open config file: ", path);
+        }
+    );
+
+    for (size_t written = 0; written < config.size();) {
+        written += file.write(
+            config.data() + written,
+            config.size() - written,
+            [](const auto e) {
+                error_exit("Failed to write config file: ", std::strerror(e));
+            }
+        );
+    }
+}
+
+} // namespace
+
+int main (const int argc, const char* const* const argv) {
+    constexpr std::string_view emit_config_flag = "--emit-config=";
+
+    std::string config_path;
+    for (int i = 1; i < argc; i++) {
+        const std::string_view arg {argv[i]};
+        if (arg.starts_with(emit_config_flag)) {
+            config_path = arg.substr(emit_config_flag.size());
+        } else {
+            error_exit("Unknown argument: ", arg);
+        }
+    }
+
+    std::mt19937_64 rng {0x5bd1e995};
+
+    std::vector<uint16_t> ones_inputs (ones_inputs_count);
+    for (uint16_t& n : ones_inputs) {
+        n = static_cast<uint16_t>(rng() % dp_bitset_base::WORD_BITS);
+    }
+
+    const OnesCandidate* best_ones = nullptr;
+    uint64_t best_ones_ns = std::numeric_limits<uint64_t>::max();
+    for (const OnesCandidate& candidate : ones_candidates) {
+        const uint64_t ns = candidate.run(ones_inputs);
+        console.info("ones ", candidate.name, ": ", ns, " ns");
+        if (ns < best_ones_ns) {
+            best_ones_ns = ns;
+            best_ones = &candidate;
+        }
+    }
+
+    const std::vector<BitsetCase> cases = make_bitset_cases(rng);
+    std::vector<word_t> words;
+
+    report_lane_shift_paths(cases, words);
+
+    std::vector<uint64_t> sequential_ns;
+    for (const BitsetCase& bitset_case : cases) {
+        const uint64_t ns = bench_bitset(bitset_case, words, &apply_sequential);
+        console.info("apply_num_unsafe x", bitset_case.nums.size(), " target=", bitset_case.target, ": ", ns, " ns");
+        sequential_ns.push_back(ns);
+    }
+
+    // Score relative to the sequential kernel so that the big bitsets don't drown out the small ones.
+    const BlockingCandidate* best_blocking = nullptr;
+    uint64_t best_blocking_score = std::numeric_limits<uint64_t>::max();
+    for (const BlockingCandidate& candidate : blocking_candidates) {
+        uint64_t score = 0;
+        for (size_t i = 0; i < cases.size(); i++) {
+            const uint64_t ns = bench_bitset(cases[i], words, candidate.apply);
+            console.info("apply_nums_unsafe<", candidate.tile_bytes, ", ", candidate.batch_size, "> target=", cases[i].target, ": ", ns, " ns");
+            score += (ns * 1000) / std::max<uint64_t>(sequential_ns[i], 1);
+        }
+        if (score < best_blocking_score) {
+            best_blocking_score = score;
+            best_blocking = &candidate;
+        }
+    }
+
+    console.info("fastest ones strategy: ", best_ones->name);
+    console.info("fastest blocking: tile_bytes=", best_blocking->tile_bytes, ", batch_size=", best_blocking->batch_size);
+
+    if (!config_path.empty()) {
+        write_config(config_path, best_ones->name, *best_blocking);
+        console.info("wrote ", config_path);
+    }
+
+    return 0;
+}
@@ -258,6 +258,20 @@ namespace detail {
             return std::move(self).template as<If<Derived>>();
         }
 
+        template <typename... T>
+        constexpr CodeBlock<Derived>&& _for (this Derived&& self, T&&... head) {
+            self._line("for (", std::forward<T>(head)..., ") {");
+            self.indent++;
+            return std::move(self).template as<CodeBlock<Derived>>();
+        }
+
+        template <typename T>
+        constexpr CodeBlock<Derived>&& _while (this Derived&& self, T&& condition) {
+            self._line("while (", std::forward<T>(condition), ") {");
+            self.indent++;
+            return std::move(self).template as<CodeBlock<Derived>>();
+        }
+
         template <typename T>
         constexpr Switch<Derived>&& _switch (this Derived&& self, T&& key) {
             self._line("switch (", std::forward<T>(key), ") {");
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <algorithm>
+#include <bit>
 #include <cassert>
 #include <chrono>
 #include <cstddef>
@@ -10,12 +11,15 @@
 #include <gsl/pointers>
 #include <gsl/util>
 #include <span>
+#include <string>
 #include <string_view>
+#include <tuple>
 #include <type_traits>
 #include <utility>
 #include <vector>
 
 #include "./codegen.hpp"
+#include "./global.hpp"
 #include "./estd/concepts.hpp"
 #include "./core/SIZE.hpp"
 #include "./core/AlignCounts.hpp"
@@ -29,6 +33,10 @@
 #include "./fast_math/log.hpp"
 #include "./code_generation_static_data.hpp"
 #include "./layout/generation/generate.hpp"
+#include "./layout/LayoutReport.hpp"
+#include "./layout/BitLeaf.hpp"
+#include "./layout/OptionalLeafs.hpp"
+#include "./layout/FieldOrder.hpp"
 #include "./estd/empty.hpp"
 #include "./sys/fs.hpp"
 #include "estd/array.hpp"
@@ -43,6 +51,65 @@ struct SizeLeaf {
     uint16_t idx = static_cast<uint16_t>(-1);
     SIZE size_size;
     SIZE stored_size_size;
+    uint64_t max_byte_size = 0;     // Bytes its variable sized leafs take at most
+};
+
+/**
+ * Start of the variable sized leafs, behind the present optional values.
+ */
+struct VarLeafsStartCodeGenerator {
+    uint64_t offset;
+    bool after_optionals;
+
+    stringify::Dst&& write (stringify::Dst&& dst) const {
+        dst.write(offset);
+        if (after_optionals) {
+            dst.write(" + optionals_size(base)"_sl);
+        }
+        return std::move(dst);
+    }
+
+    [[nodiscard]] size_t get_size () const {
+        const size_t offset_str_size = offset == 0 ? 1 : fast_math::log_unsafe<10>(offset) + 1;
+        return after_optionals ? offset_str_size + " + optionals_size(base)"_sl.size() : offset_str_size;
+    }
+};
+
+/**
+ * The fixed leafs of one variant alternative, `emplace_<alt>()` zeroes them. Leafs in arrays have no single offset, so
+ * alternatives holding any get no emplace.
+ */
+struct AlternativeLeafs {
+    struct Leaf {
+        uint64_t offset;
+        uint64_t size;
+        uint64_t mask;  // Bits of the word for bit packed leafs, 0 for whole leafs
+    };
+
+    std::vector<Leaf> leafs;
+    bool in_array = false;
+};
+
+/**
+ * A string field of the top level, the Editor can resize it.
+ */
+struct ResizableLeaf {
+    std::string_view name;
+    uint16_t size_leaf_idx;
+    uint32_t max_size;                      // The size leaf only bounds the size from below
+    std::span<const uint64_t> size_chain;   // Size leafs of the variable sized leafs in front
+};
+
+/**
+ * An optional field of the top level, the Editor can set and clear it.
+ */
+struct ResizableOptional {
+    std::string_view name;
+    std::string_view value_type;
+    SIZE value_size;
+    uint64_t word_offset;                   // Of the word holding the presence bit
+    layout::BitLeaf bit_leaf;
+    layout::PresenceMasks preceding;        // The presence bits of the values stored in front
 };
 
 struct OffsetsAccessor {
@@ -51,22 +118,41 @@ struct OffsetsAccessor {
         std::span<const std::span<const uint64_t>> var_offsets,
         std::span<const uint16_t> idx_map,
         std::span<const layout::ArrayPackInfo> pack_infos,
+        std::span<const layout::BitLeaf> bit_leafs,
+        const layout::OptionalLeafs& optional_leafs,
+        std::span<const uint16_t> shared_id_bases,
+        const layout::FieldOrder& field_order,
         uint64_t var_leafs_start,
-        gsl::not_null<uint16_t*> current_map_idx
+        gsl::not_null<uint16_t*> current_map_idx,
+        layout::LayoutReport* layout_report
     ) :
     fixed_offsets(fixed_offsets),
     var_offsets(var_offsets),
     idx_map(idx_map),
     pack_infos(pack_infos),
+    bit_leafs(bit_leafs),
+    optional_leafs(&optional_leafs),
+    shared_id_bases(shared_id_bases),
+    field_order(&field_order),
     var_leafs_start(var_leafs_start),
-    current_map_idx(current_map_idx)
+    current_map_idx(current_map_idx),
+    layout_report(layout_report)
     {}
     std::span<const layout::FixedOffset> fixed_offsets;
     std::span<const std::span<const uint64_t>> var_offsets;
     std::span<const uint16_t> idx_map;
     std::span<const layout::ArrayPackInfo> pack_infos;
-    uint64_t var_leafs_start;
+    std::span<const layout::BitLeaf> bit_leafs;     // Indexed by map_idx, empty without bit fields
+    gsl::not_null<const layout::OptionalLeafs*> optional_leafs;
+    std::span<const uint16_t> shared_id_bases;      // Indexed by map_idx, empty without shared variants
+    gsl::not_null<const layout::FieldOrder*> field_order;
+    uint64_t var_leafs_start;                       // The present optional values come first
     gsl::not_null<uint16_t*> current_map_idx;
+    layout::LayoutReport* layout_report;    // Collects every accessed leaf when set
+    AlternativeLeafs* alternative_leafs = nullptr;  // Collects the fixed leafs while visiting a variant alternative
+    std::vector<ResizableLeaf>* resizable_leafs = nullptr;  // Collects the strings of the top level, unset below it
+    std::vector<ResizableOptional>* resizable_optionals = nullptr;  // Collects the optionals of the top level, unset below it
+    uint16_t* message_alignment = nullptr;  // Raised to the alignment of every vector of the top level
 
     [[nodiscard]] uint16_t next_map_idx () const {
         const uint16_t map_idx = (*current_map_idx)++;
@@ -84,14 +170,55 @@ struct OffsetsAccessor {
     [[nodiscard]] layout::FixedOffset next_fixed_leaf () const {
         const layout::FixedOffset offset = fixed_offsets[next_map_idx()];
         assert(offset != layout::FixedOffset::empty());
+        if (layout_report != nullptr) {
+            layout_report->add_fixed_leaf(offset.get_offset(), offset.get_pack_align());
+        }
         return offset;
     }
 
+    [[nodiscard]] bool next_is_bit_leaf () const {
+        return !bit_leafs.empty() && bit_leafs[*current_map_idx].is_packed();
+    }
+
+    // First id of the variant in its group if the next leaf is the id of a shared variant, -1 otherwise.
+    [[nodiscard]] uint16_t next_shared_id_base () const {
+        return shared_id_bases.empty() ? static_cast<uint16_t>(-1) : shared_id_bases[*current_map_idx];
+    }
+
+    [[nodiscard]] std::pair<layout::FixedOffset, layout::BitLeaf> next_bit_leaf () const {
+        const layout::BitLeaf bit_leaf = bit_leafs[*current_map_idx];
+        return {next_fixed_leaf(), bit_leaf};
+    }
+
+    void add_alternative_leaf (const uint64_t offset, const uint64_t size, const uint64_t mask = 0) const {
+        if (alternative_leafs != nullptr) {
+            alternative_leafs->leafs.push_back({offset, size, mask});
+        }
+    }
+
+    void add_alternative_leaf_in_array () const {
+        if (alternative_leafs != nullptr) {
+            alternative_leafs->in_array = true;
+        }
+    }
+
+    [[nodiscard]] VarLeafsStartCodeGenerator var_leafs_start_code () const {
+        return VarLeafsStartCodeGenerator{var_leafs_start, !optional_leafs->empty()};
+    }
+
+    // The present optional values start where the fixed region ends, in front of the other variable sized leafs.
+    [[nodiscard]] VarLeafsStartCodeGenerator optional_values_start_code () const {
+        return VarLeafsStartCodeGenerator{var_leafs_start, false};
+    }
+
     [[nodiscard]] std::span<const uint64_t> next_var_offset () const {
         const uint16_t idx = next_map_idx();
         const std::span<const uint64_t> offset = var_offsets[idx];
         assert(offset.data() != nullptr);
         // console.debug("next_var_offset at: ", idx, ", start_idx: ", offset.start_idx.value, ", length: ", offset.length);
+        if (layout_report != nullptr) {
+            layout_report->add_var_leaf(var_leafs_start, gsl::narrow_cast<uint16_t>(offset.size()));
+        }
         return offset;
     }
 };
@@ -168,6 +295,54 @@ struct SizeChainCodeGenerator {
     }
 };
 
+/**
+ * Sums the sizes of the present optional values selected by the masks, with one popcount of `presence` per value size.
+ */
+struct PresencePopcountCodeGenerator {
+    explicit PresencePopcountCodeGenerator (
+        const layout::PresenceMasks& masks,
+        const bool leading_plus = true
+    ) : masks(masks), leading_plus(leading_plus) {}
+
+    layout::PresenceMasks masks;
+    bool leading_plus;
+
+    stringify::Dst&& write (stringify::Dst&& dst) const {
+        bool first = !leading_plus;
+        SIZE::enums::foreach([&]<SIZE size>() {
+            const uint64_t mask = masks.get<size>();
+            if (mask == 0) return;
+            if (!first) {
+                dst.write(" + "_sl);
+            }
+            first = false;
+            dst.write("static_cast<size_t>(std::popcount(presence & "_sl, mask, "u))"_sl);
+            if constexpr (size != SIZE::SIZE_1) {
+                dst.write(string_literal::concat_v<" * "_sl, string_literal::from<size.byte_size()>>);
+            }
+        });
+        return std::move(dst);
+    }
+
+    [[nodiscard]] size_t get_size () const {
+        size_t str_size = 0;
+        bool first = !leading_plus;
+        SIZE::enums::foreach([&]<SIZE size>() {
+            const uint64_t mask = masks.get<size>();
+            if (mask == 0) return;
+            if (!first) {
+                str_size += " + "_sl.size();
+            }
+            first = false;
+            str_size += "static_cast<size_t>(std::popcount(presence & "_sl.size() + fast_math::log_unsafe<10>(mask) + 1 + "u))"_sl.size();
+            if constexpr (size != SIZE::SIZE_1) {
+                str_size += string_literal::concat_v<" * "_sl, string_literal::from<size.byte_size()>>.size();
+            }
+        });
+        return str_size;
+    }
+};
+
 template <bool no_multiply, bool last_is_direct = false>
 struct IdxCalcCodeGenerator {
 private:
@@ -269,9 +444,12 @@ struct GenVariantLeafArgsBase {
 };
 
 struct GenFixedVariantLeafArgs : GenVariantLeafArgsBase {
-    constexpr explicit GenFixedVariantLeafArgs (GenVariantLeafArgsBase base)
-    : GenVariantLeafArgsBase(base)
+    static constexpr uint16_t no_group_id = static_cast<uint16_t>(-1);
+
+    constexpr explicit GenFixedVariantLeafArgs (GenVariantLeafArgsBase base, uint16_t group_id = no_group_id)
+    : GenVariantLeafArgsBase(base), group_id(group_id)
     {}
+    uint16_t group_id;      // Group id of the alternative if the variant shares its storage, no_group_id otherwise
 };
 
 struct GenDynamicVariantLeafArgs : GenVariantLeafArgsBase {
@@ -284,6 +462,7 @@ struct GenDynamicVariantLeafArgs : GenVariantLeafArgsBase {
 struct GenStructLeafArgs {
     std::string_view name;
     uint16_t depth;
+    std::string_view struct_name;   // Name of the struct definition declaring the field
 };
 
 template<typename T>
@@ -378,17 +557,595 @@ template <typename Name>
     return std::forward<Name>(name);
 }
 
+/**
+ * Counts the calls of a field accessor in the calling thread (--layout-instrument).
+ */
+template <typename ArgsT>
+[[nodiscard]] inline codegen::Method<codegen::UnknownStructBase>&& add_profile_counter (
+    codegen::Method<codegen::UnknownStructBase>&& method,
+    const ArgsT& name_providing_args
+) {
+    if constexpr (std::is_same_v<std::remove_cvref_t<ArgsT>, GenStructLeafArgs>) {
+        if (global::options::layout_instrument) {
+            return std::move(method)
+                .line("static thread_local layout_profile::Counter profile_counter {\"", name_providing_args.struct_name, ".", name_providing_args.name, "\"};")
+                .line("profile_counter.hit();");
+        }
+    }
+    return std::move(method);
+}
+
+/**
+ * Starts the getter of a field. The getters of the alternatives of a shared variant assert that the group id holds
+ * their alternative, since a member which is not live overlays the bytes of another one.
+ */
+template <typename ArgsT>
+[[nodiscard]] inline codegen::Method<codegen::UnknownStructBase>&& begin_accessor (
+    codegen::Method<codegen::UnknownStructBase>&& method,
+    const ArgsT& name_providing_args
+) {
+    if constexpr (std::is_same_v<std::remove_cvref_t<ArgsT>, GenFixedVariantLeafArgs>) {
+        if (name_providing_args.group_id != GenFixedVariantLeafArgs::no_group_id) {
+            return add_profile_counter(std::move(method)
+                .line("assert(group_id() == ", name_providing_args.group_id, ");"), name_providing_args);
+        }
+    }
+    return add_profile_counter(std::move(method), name_providing_args);
+}
+
+/**
+ * Counters behind the instrumented accessors, shared by every generated header.
+ * Every counter also tracks which accessors were called right after its own, keeping the most frequent followers by
+ * replacing the rarest one (space saving), which the layout profile uses to place fields read together next to each other.
+ */
+template <typename Code>
+[[nodiscard]] inline Code&& add_profile_runtime (Code&& code) {
+    if (!global::options::layout_instrument) return std::move(code);
+    return std::move(code)
+        .line("#include <cstdio>")
+        .line()
+        .line("#ifndef STATIC_PROTO_LAYOUT_PROFILE")
+        .line("#define STATIC_PROTO_LAYOUT_PROFILE")
+        .line("namespace layout_profile {")
+        .line("struct Counter;")
+        .line("inline thread_local Counter* counters = nullptr;")
+        .line("inline thread_local Counter* last_hit = nullptr;")
+        .line("// Lives in a static thread_local of its accessor and links itself into the counters of its thread.")
+        .line("struct Counter {")
+        .line("    struct Follower {")
+        .line("        const Counter* counter;")
+        .line("        uint64_t count;")
+        .line("    };")
+        .line("    const char* name;")
+        .line("    uint64_t count = 0;")
+        .line("    Follower followers[4] {};")
+        .line("    Counter* next;")
+        .line("    explicit Counter (const char* name) : name(name), next(counters) { counters = this; }")
+        .line("    Counter (const Counter&) = delete;")
+        .line("    Counter& operator= (const Counter&) = delete;")
+        .line("    void hit () {")
+        .line("        count++;")
+        .line("        if (last_hit != nullptr && last_hit != this) last_hit->follow(this);")
+        .line("        last_hit = this;")
+        .line("    }")
+        .line("    void follow (const Counter* counter) {")
+        .line("        Follower* rarest = &followers[0];")
+        .line("        for (Follower& follower : followers) {")
+        .line("            if (follower.counter == counter) {")
+        .line("                follower.count++;")
+        .line("                return;")
+        .line("            }")
+        .line("            if (follower.count < rarest->count) rarest = &follower;")
+        .line("        }")
+        .line("        *rarest = {counter, rarest->count + 1};")
+        .line("    }")
+        .line("};")
+        .line("// Appends the counts of the calling thread to the profile, call it from every thread before it exits.")
+        .line("inline bool dump (const char* path) {")
+        .line("    std::FILE* file = std::fopen(path, \"a\");")
+        .line("    if (file == nullptr) return false;")
+        .line("    for (const Counter* counter = counters; counter != nullptr; counter = counter->next) {")
+        .line("        std::fprintf(file, \"%s %llu\\n\", counter->name, static_cast<unsigned long long>(counter->count));")
+        .line("        for (const Counter::Follower& follower : counter->followers) {")
+        .line("            if (follower.counter == nullptr) continue;")
+        .line("            std::fprintf(file, \"%s>%s %llu\\n\", counter->name, follower.counter->name, static_cast<unsigned long long>(follower.count));")
+        .line("        }")
+        .line("    }")
+        .line("    return std::fclose(file) == 0;")
+        .line("}")
+        .line("} // namespace layout_profile")
+        .line("#endif");
+}
+
+/**
+ * The accessors of --atomic-accessors and the Seqlock of --seqlock need <atomic>.
+ */
+template <typename Code>
+[[nodiscard]] inline Code&& add_atomic_include (Code&& code) {
+    if (!global::options::atomic_accessors && !global::options::seqlock) return std::move(code);
+    return std::move(code)
+        .line("#include <atomic>");
+}
+
+/**
+ * Single and multi producer rings of fixed size slots in shared memory (--ring-runtime). Slots are sized by
+ * T::max_byte_size, producers build messages in place and consumers read them through views without copying.
+ */
+template <typename Code>
+[[nodiscard]] inline Code&& add_ring_runtime (Code&& code) {
+    if (!global::options::ring_runtime) return std::move(code);
+    return std::move(code)
+        .line()
+        .line("#include <atomic>")
+        .line("#include <new>")
+        .line("#include <sys/mman.h>")
+        .line("#include <unistd.h>")
+        .line()
+        .line("#ifndef STATIC_PROTO_RING")
+        .line("#define STATIC_PROTO_RING")
+        .line("namespace ring {")
+        .line("static_assert(std::atomic<uint64_t>::is_always_lock_free, \"Rings shared between processes need lock free atomics\");")
+        .line("constexpr size_t cache_line = 64;")
+        .line("// Every slot holds one message of at most T::max_byte_size bytes, padded to whole cache lines. Slots start on a")
+        .line("// cache line, which covers T::alignment.")
+        .line("template <typename T>")
+        .line("constexpr size_t slot_size = (T::max_byte_size + cache_line - 1) / cache_line * cache_line;")
+        .line("// Single producer, single consumer. Each side caches the index of the other one and only reloads it when the ring")
+        .line("// looks full or empty.")
+        .line("template <typename T, size_t slot_count>")
+        .line("struct Spsc {")
+        .line("    static_assert(slot_count != 0 && (slot_count & (slot_count - 1)) == 0, \"slot_count has to be a power of 2\");")
+        .line("    static_assert(T::alignment <= cache_line, \"Messages are aligned to cache lines at most\");")
+        .line("    // Producer: the slot to build the next message in, nullptr while the ring is full.")
+        .line("    std::byte* try_claim () {")
+        .line("        const uint64_t head_idx = head.load(std::memory_order_relaxed);")
+        .line("        if (head_idx - cached_tail == slot_count) {")
+        .line("            cached_tail = tail.load(std::memory_order_acquire);")
+        .line("            if (head_idx - cached_tail == slot_count) return nullptr;")
+        .line("        }")
+        .line("        return slots[head_idx & (slot_count - 1)];")
+        .line("    }")
+        .line("    // Producer: makes the claimed slot visible to the consumer.")
+        .line("    void publish () { head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release); }")
+        .line("    // Consumer: the oldest message, nullptr while the ring is empty.")
+        .line("    const std::byte* try_peek () {")
+        .line("        const uint64_t tail_idx = tail.load(std::memory_order_relaxed);")
+        .line("        if (tail_idx == cached_head) {")
+        .line("            cached_head = head.load(std::memory_order_acquire);")
+        .line("            if (tail_idx == cached_head) return nullptr;")
+        .line("        }")
+        .line("        return slots[tail_idx & (slot_count - 1)];")
+        .line("    }")
+        .line("    // Consumer: hands the peeked slot back to the producer.")
+        .line("    void consume () { tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release); }")
+        .line("private:")
+        .line("    alignas(cache_line) std::atomic<uint64_t> head {0};")
+        .line("    uint64_t cached_tail = 0;")
+        .line("    alignas(cache_line) std::atomic<uint64_t> tail {0};")
+        .line("    uint64_t cached_head = 0;")
+        .line("    alignas(cache_line) std::byte slots[slot_count][slot_size<T>];")
+        .line("};")
+        .line("// Any number of producers, single consumer. Every slot carries a sequence number telling whose turn it is, producers")
+        .line("// claim slots by advancing the head.")
+        .line("template <typename T, size_t slot_count>")
+        .line("struct Mpsc {")
+        .line("    static_assert(slot_count != 0 && (slot_count & (slot_count - 1)) == 0, \"slot_count has to be a power of 2\");")
+        .line("    static_assert(T::alignment <= cache_line, \"Messages are aligned to cache lines at most\");")
+        .line("    Mpsc () {")
+        .line("        for (size_t i = 0; i < slot_count; i++) slots[i].sequence.store(i, std::memory_order_relaxed);")
+        .line("    }")
+        .line("    // Producer: the slot to build the next message in and its ticket for publish, nullptr while the ring is full.")
+        .line("    std::byte* try_claim (uint64_t& ticket) {")
+        .line("        uint64_t head_idx = head.load(std::memory_order_relaxed);")
+        .line("        while (true) {")
+        .line("            Slot& slot = slots[head_idx & (slot_count - 1)];")
+        .line("            const uint64_t sequence = slot.sequence.load(std::memory_order_acquire);")
+        .line("            if (sequence == head_idx) {")
+        .line("                if (head.compare_exchange_weak(head_idx, head_idx + 1, std::memory_order_relaxed)) {")
+        .line("                    ticket = head_idx;")
+        .line("                    return slot.message;")
+        .line("                }")
+        .line("            } else if (sequence < head_idx) {")
+        .line("                return nullptr;")
+        .line("            } else {")
+        .line("                head_idx = head.load(std::memory_order_relaxed);")
+        .line("            }")
+        .line("        }")
+        .line("    }")
+        .line("    void publish (uint64_t ticket) { slots[ticket & (slot_count - 1)].sequence.store(ticket + 1, std::memory_order_release); }")
+        .line("    // Consumer: the oldest message, nullptr while it is not published yet.")
+        .line("    const std::byte* try_peek () {")
+        .line("        Slot& slot = slots[tail & (slot_count - 1)];")
+        .line("        if (slot.sequence.load(std::memory_order_acquire) != tail + 1) return nullptr;")
+        .line("        return slot.message;")
+        .line("    }")
+        .line("    void consume () {")
+        .line("        slots[tail & (slot_count - 1)].sequence.store(tail + slot_count, std::memory_order_release);")
+        .line("        tail++;")
+        .line("    }")
+        .line("private:")
+        .line("    // The sequence and the message start on cache lines of their own, so producers polling the sequence do not")
+        .line("    // take the line the consumer reads the message from or the line the producer before them writes it to.")
+        .line("    struct Slot {")
+        .line("        alignas(cache_line) std::atomic<uint64_t> sequence;")
+        .line("        alignas(cache_line) std::byte message[slot_size<T>];")
+        .line("    };")
+        .line("    alignas(cache_line) std::atomic<uint64_t> head {0};")
+        .line("    alignas(cache_line) uint64_t tail = 0;")
+        .line("    Slot slots[slot_count];")
+        .line("};")
+        .line("// Maps a ring in a memfd region. Pass the fd to the other process, which maps the same ring with attach.")
+        .line("template <typename Ring>")
+        .line("inline Ring* create (const char* name, int& fd) {")
+        .line("    fd = ::memfd_create(name, MFD_CLOEXEC);")
+        .line("    if (fd < 0) return nullptr;")
+        .line("    if (::ftruncate(fd, sizeof(Ring)) == 0) {")
+        .line("        void* const mapped = ::mmap(nullptr, sizeof(Ring), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);")
+        .line("        if (mapped != MAP_FAILED) return ::new (mapped) Ring();")
+        .line("    }")
+        .line("    ::close(fd);")
+        .line("    fd = -1;")
+        .line("    return nullptr;")
+        .line("}")
+        .line("template <typename Ring>")
+        .line("inline Ring* attach (int fd) {")
+        .line("    void* const mapped = ::mmap(nullptr, sizeof(Ring), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);")
+        .line("    return mapped == MAP_FAILED ? nullptr : static_cast<Ring*>(mapped);")
+        .line("}")
+        .line("template <typename Ring>")
+        .line("inline void detach (Ring* ring) { ::munmap(ring, sizeof(Ring)); }")
+        .line("} // namespace ring")
+        .line("#endif");
+}
+
+/**
+ * Reader and writer for files of back to back messages, shared by every generated header.
+ */
+template <typename Code>
+[[nodiscard]] inline Code&& add_stream_runtime (Code&& code) {
+    if (!global::options::stream_runtime) return std::move(code);
+    return std::move(code)
+        .line()
+        .line("#include <cerrno>")
+        .line("#include <fcntl.h>")
+        .line("#include <sys/mman.h>")
+        .line("#include <sys/stat.h>")
+        .line("#include <sys/uio.h>")
+        .line("#include <type_traits>")
+        .line("#include <unistd.h>")
+        .line("#include <vector>")
+        .line()
+        .line("#ifndef STATIC_PROTO_STREAM")
+        .line("#define STATIC_PROTO_STREAM")
+        .line("namespace stream {")
+        .line("// A stream is an optional header followed by back to back messages, each padded to a multiple of T::alignment bytes,")
+        .line("// so messages in a mapped file stay aligned for their vector accessors.")
+        .line("// With LENGTH_PREFIX every message is preceded by its size as uint64_t, otherwise T::byte_size reads it from the")
+        .line("// fixed region, which has to lie in the stream as a whole.")
+        .line("enum class Framing : uint8_t { BYTE_SIZE, LENGTH_PREFIX };")
+        .line("constexpr size_t padded (size_t size, size_t alignment = 8) { return (size + alignment - 1) & ~(alignment - 1); }")
+        .line("// The length prefix is padded as well, the message behind it starts aligned.")
+        .line("template <typename T>")
+        .line("constexpr size_t prefix_size = padded(sizeof(uint64_t), T::alignment);")
+        .line("// Maps a stream file and hands out views of its messages without copying them.")
+        .line("template <typename T>")
+        .line("class Reader {")
+        .line("public:")
+        .line("    explicit Reader (const char* path, size_t header_size = 0, Framing framing = Framing::BYTE_SIZE)")
+        .line("        : header_size(padded(header_size, T::alignment)), offset(padded(header_size, T::alignment)), framing(framing) {")
+        .line("        const int fd = ::open(path, O_RDONLY | O_CLOEXEC);")
+        .line("        if (fd < 0) return;")
+        .line("        struct stat file_stat;")
+        .line("        if (::fstat(fd, &file_stat) == 0 && file_stat.st_size > 0) {")
+        .line("            void* const mapped = ::mmap(nullptr, static_cast<size_t>(file_stat.st_size), PROT_READ, MAP_PRIVATE, fd, 0);")
+        .line("            if (mapped != MAP_FAILED) {")
+        .line("                data = static_cast<const std::byte*>(mapped);")
+        .line("                size = static_cast<size_t>(file_stat.st_size);")
+        .line("                end = size;")
+        .line("                ::madvise(mapped, size, MADV_SEQUENTIAL);")
+        .line("            }")
+        .line("        }")
+        .line("        ::close(fd);")
+        .line("    }")
+        .line("    Reader (const Reader&) = delete;")
+        .line("    Reader& operator = (const Reader&) = delete;")
+        .line("    ~Reader () {")
+        .line("        if (data != nullptr) ::munmap(const_cast<std::byte*>(data), size);")
+        .line("    }")
+        .line("    size_t position () const { return offset; }")
+        .line("    bool ok () const { return data != nullptr && header_size <= size; }")
+        .line("    std::span<const std::byte> header () const { return {data, header_size}; }")
+        .line("    // Returns the start of the next message, nullptr at the end of the stream or before a truncated message.")
+        .line("    const std::byte* next () {")
+        .line("        if (!ok() || offset >= end) return nullptr;")
+        .line("        const std::byte* message = data + offset;")
+        .line("        size_t frame_size;")
+        .line("        if (framing == Framing::LENGTH_PREFIX) {")
+        .line("            if (end - offset < prefix_size<T>) return nullptr;")
+        .line("            uint64_t length;")
+        .line("            std::memcpy(&length, message, sizeof(length));")
+        .line("            if (length > end - offset - prefix_size<T>) return nullptr;")
+        .line("            message += prefix_size<T>;")
+        .line("            frame_size = prefix_size<T> + static_cast<size_t>(length);")
+        .line("        } else {")
+        .line("            if (end - offset < T::fixed_byte_size) return nullptr;")
+        .line("            frame_size = T::byte_size(message);")
+        .line("        }")
+        .line("        if (frame_size > end - offset) return nullptr;")
+        .line("        offset += padded(frame_size, T::alignment);")
+        .line("        return message;")
+        .line("    }")
+        .line("    // Calls f(T) for every message. The fixed region of the following one is prefetched before f runs and its size")
+        .line("    // only read after, so the load overlaps f instead of stalling in front of it.")
+        .line("    template <typename F>")
+        .line("    size_t for_each (F&& f) {")
+        .line("        size_t count = 0;")
+        .line("        for (const std::byte* message = next(); message != nullptr; message = next()) {")
+        .line("            if (offset < end) T::prefetch(data + offset + (framing == Framing::LENGTH_PREFIX ? prefix_size<T> : 0));")
+        .line("            f(T{reinterpret_cast<size_t>(message)});")
+        .line("            count++;")
+        .line("        }")
+        .line("        return count;")
+        .line("    }")
+        .line("protected:")
+        .line("    const std::byte* data = nullptr;")
+        .line("    size_t size = 0;")
+        .line("    size_t end = 0;     // Messages stop here, an indexed file continues with its index")
+        .line("    size_t header_size;")
+        .line("    size_t offset;")
+        .line("    Framing framing;")
+        .line("};")
+        .line("// Batches messages into few writev calls. The memory of a message has to stay valid until the next flush.")
+        .line("template <typename T>")
+        .line("class Writer {")
+        .line("public:")
+        .line("    static constexpr size_t max_batch = 256;")
+        .line("    explicit Writer (int fd, Framing framing = Framing::BYTE_SIZE) : fd(fd), framing(framing) {}")
+        .line("    Writer (const Writer&) = delete;")
+        .line("    Writer& operator = (const Writer&) = delete;")
+        .line("    ~Writer () { static_cast<void>(flush()); }")
+        .line("    // Writes the header right away, call it before the first message.")
+        .line("    bool write_header (const void* header, size_t header_size) { return write_bytes(header, header_size, T::alignment); }")
+        .line("    // Flushes the batch and writes the bytes padded to alignment right away.")
+        .line("    bool write_bytes (const void* bytes, size_t byte_count, size_t alignment = 8) {")
+        .line("        if (!flush()) return false;")
+        .line("        add(bytes, byte_count);")
+        .line("        add(zeros, padded(byte_count, alignment) - byte_count);")
+        .line("        return flush();")
+        .line("    }")
+        .line("    bool write (const std::byte* message) { return write(message, T::byte_size(message)); }")
+        .line("    bool write (const std::byte* message, size_t message_size) {")
+        .line("        if (message_count == max_batch && !flush()) return false;")
+        .line("        size_t frame_size = message_size;")
+        .line("        if (framing == Framing::LENGTH_PREFIX) {")
+        .line("            prefixes[message_count] = message_size;")
+        .line("            add(&prefixes[message_count], sizeof(uint64_t));")
+        .line("            add(zeros, prefix_size<T> - sizeof(uint64_t));")
+        .line("            frame_size += prefix_size<T>;")
+        .line("        }")
+        .line("        message_count++;")
+        .line("        add(message, message_size);")
+        .line("        add(zeros, padded(frame_size, T::alignment) - frame_size);")
+        .line("        return true;")
+        .line("    }")
+        .line("    // Writes the batched messages, resuming partial writes.")
+        .line("    bool flush () {")
+        .line("        size_t first = 0;")
+        .line("        while (first < iov_count) {")
+        .line("            const ssize_t written = ::writev(fd, iov + first, static_cast<int>(iov_count - first));")
+        .line("            if (written < 0) {")
+        .line("                if (errno == EINTR) continue;")
+        .line("                return false;")
+        .line("            }")
+        .line("            size_t left = static_cast<size_t>(written);")
+        .line("            while (first < iov_count && left >= iov[first].iov_len) left -= iov[first++].iov_len;")
+        .line("            if (left != 0) {")
+        .line("                iov[first].iov_base = static_cast<char*>(iov[first].iov_base) + left;")
+        .line("                iov[first].iov_len -= left;")
+        .line("            }")
+        .line("        }")
+        .line("        iov_count = 0;")
+        .line("        message_count = 0;")
+        .line("        return true;")
+        .line("    }")
+        .line("private:")
+        .line("    void add (const void* bytes, size_t byte_count) {")
+        .line("        if (byte_count != 0) iov[iov_count++] = {const_cast<void*>(bytes), byte_count};")
+        .line("    }")
+        .line("    static constexpr std::byte zeros[T::alignment] {};")
+        .line("    int fd;")
+        .line("    Framing framing;")
+        .line("    size_t iov_count = 0;")
+        .line("    size_t message_count = 0;")
+        .line("    uint64_t prefixes[max_batch];")
+        .line("    iovec iov[max_batch * 4];")
+        .line("};")
+        .line("// An indexed file is a stream followed by a sparse index and a footer. Every interval messages the index holds the")
+        .line("// offset of the message and the smallest and biggest key of the messages up to the next entry. The footer records")
+        .line("// whether the keys were written in order, range queries then binary search the index.")
+        .line("template <typename Key>")
+        .line("struct IndexEntry {")
+        .line("    uint64_t offset;")
+        .line("    Key min_key;")
+        .line("    Key max_key;")
+        .line("};")
+        .line("struct IndexFooter {")
+        .line("    static constexpr uint64_t magic_value = 0x5844495F43505321;")
+        .line("    uint64_t index_offset;")
+        .line("    uint64_t entry_count;")
+        .line("    uint64_t interval;")
+        .line("    uint64_t message_count;")
+        .line("    uint64_t key_ordered;")
+        .line("    uint64_t magic;")
+        .line("};")
+        .line("// Writes an indexed file, the key of a message is whatever the caller passes along with it.")
+        .line("template <typename T, typename Key = uint64_t>")
+        .line("class IndexedWriter {")
+        .line("public:")
+        .line("    using Entry = IndexEntry<Key>;")
+        .line("    explicit IndexedWriter (int fd, uint64_t interval = 1024, Framing framing = Framing::BYTE_SIZE)")
+        .line("        : writer(fd, framing), interval(interval == 0 ? 1 : interval), framing(framing) {}")
+        .line("    ~IndexedWriter () {")
+        .line("        if (!finished) static_cast<void>(finish());")
+        .line("    }")
+        .line("    bool write_header (const void* header, size_t header_size) {")
+        .line("        offset += padded(header_size, T::alignment);")
+        .line("        return writer.write_header(header, header_size);")
+        .line("    }")
+        .line("    bool write (const std::byte* message, Key key = {}) { return write(message, T::byte_size(message), key); }")
+        .line("    // Takes the key of the message from key_of(T).")
+        .line("    template <typename KeyOf>")
+        .line("    bool write_with_key (const std::byte* message, KeyOf&& key_of) {")
+        .line("        return write(message, key_of(T{reinterpret_cast<size_t>(message)}));")
+        .line("    }")
+        .line("    // The key has no default here, with uint64_t keys write(message, key) would be ambiguous otherwise.")
+        .line("    bool write (const std::byte* message, size_t message_size, Key key) {")
+        .line("        if (message_count != 0 && key < last_key) key_ordered = false;")
+        .line("        last_key = key;")
+        .line("        if (message_count % interval == 0) {")
+        .line("            entries.push_back({offset, key, key});")
+        .line("        } else {")
+        .line("            Entry& entry = entries.back();")
+        .line("            if (key < entry.min_key) entry.min_key = key;")
+        .line("            if (entry.max_key < key) entry.max_key = key;")
+        .line("        }")
+        .line("        message_count++;")
+        .line("        offset += padded(framing == Framing::LENGTH_PREFIX ? prefix_size<T> + message_size : message_size, T::alignment);")
+        .line("        return writer.write(message, message_size);")
+        .line("    }")
+        .line("    // Writes the index and the footer behind the messages, nothing may be written afterwards.")
+        .line("    bool finish () {")
+        .line("        finished = true;")
+        .line("        const IndexFooter footer {offset, entries.size(), interval, message_count, key_ordered ? 1u : 0u, IndexFooter::magic_value};")
+        .line("        return writer.write_bytes(entries.data(), entries.size() * sizeof(Entry))")
+        .line("            && writer.write_bytes(&footer, sizeof(footer));")
+        .line("    }")
+        .line("private:")
+        .line("    Writer<T> writer;")
+        .line("    std::vector<Entry> entries;")
+        .line("    uint64_t interval;")
+        .line("    uint64_t offset = 0;")
+        .line("    uint64_t message_count = 0;")
+        .line("    Key last_key {};")
+        .line("    Framing framing;")
+        .line("    bool key_ordered = true;")
+        .line("    bool finished = false;")
+        .line("};")
+        .line("// Seeks in an indexed file by message number or key with a binary search over the mapped index.")
+        .line("template <typename T, typename Key = uint64_t>")
+        .line("class IndexedReader : public Reader<T> {")
+        .line("public:")
+        .line("    using Entry = IndexEntry<Key>;")
+        .line("    explicit IndexedReader (const char* path, size_t header_size = 0, Framing framing = Framing::BYTE_SIZE)")
+        .line("        : Reader<T>(path, header_size, framing) {")
+        .line("        this->end = 0;")
+        .line("        if (!Reader<T>::ok() || this->size < sizeof(IndexFooter)) return;")
+        .line("        std::memcpy(&footer, this->data + this->size - sizeof(IndexFooter), sizeof(IndexFooter));")
+        .line("        const uint64_t index_size = footer.entry_count * sizeof(Entry);")
+        .line("        if (footer.magic != IndexFooter::magic_value || footer.interval == 0")
+        .line("            || footer.entry_count != (footer.message_count + footer.interval - 1) / footer.interval")
+        .line("            || footer.index_offset < this->header_size")
+        .line("            || footer.index_offset + index_size + sizeof(IndexFooter) != this->size) return;")
+        .line("        entries = reinterpret_cast<const Entry*>(reinterpret_cast<size_t>(this->data) + footer.index_offset);")
+        .line("        this->end = footer.index_offset;")
+        .line("    }")
+        .line("    bool ok () const { return entries != nullptr; }")
+        .line("    uint64_t message_count () const { return footer.message_count; }")
+        .line("    std::span<const Entry> index () const { return {entries, footer.entry_count}; }")
+        .line("    // Moves to message idx, next() returns it. Skips at most interval - 1 messages behind the closest entry.")
+        .line("    bool seek (uint64_t idx) {")
+        .line("        if (idx >= footer.message_count) return false;")
+        .line("        seek_entry(idx / footer.interval);")
+        .line("        for (uint64_t skip = idx % footer.interval; skip != 0; skip--) static_cast<void>(this->next());")
+        .line("        return true;")
+        .line("    }")
+        .line("    // Moves to the first entry that can hold a key not less than key, for files written in key order.")
+        .line("    // Returns the number of the message next() returns, message_count() if every key is less.")
+        .line("    uint64_t seek_key (Key key) {")
+        .line("        const uint64_t entry_idx = first_entry_reaching(key);")
+        .line("        if (entry_idx == footer.entry_count) {")
+        .line("            this->offset = this->end;")
+        .line("            return footer.message_count;")
+        .line("        }")
+        .line("        seek_entry(entry_idx);")
+        .line("        return entry_idx * footer.interval;")
+        .line("    }")
+        .line("    bool key_ordered () const { return footer.key_ordered != 0; }")
+        .line("    // Calls f(T) for the messages of every entry whose keys overlap [low, high]. In key ordered files the entries")
+        .line("    // start at a binary search for low and end at the first one above high, other files check every entry.")
+        .line("    // With key_of only messages whose key_of(T) lies in [low, high] reach f, otherwise the caller filters them.")
+        .line("    template <typename F, typename KeyOf = std::nullptr_t>")
+        .line("    size_t for_each_in_range (Key low, Key high, F&& f, KeyOf&& key_of = nullptr) {")
+        .line("        size_t count = 0;")
+        .line("        for (uint64_t i = key_ordered() ? first_entry_reaching(low) : 0; i < footer.entry_count; i++) {")
+        .line("            if (high < entries[i].min_key) {")
+        .line("                if (key_ordered()) break;")
+        .line("                continue;")
+        .line("            }")
+        .line("            if (entries[i].max_key < low) continue;")
+        .line("            seek_entry(i);")
+        .line("            const uint64_t first = i * footer.interval;")
+        .line("            const uint64_t last = first + footer.interval < footer.message_count ? first + footer.interval : footer.message_count;")
+        .line("            for (uint64_t idx = first; idx < last; idx++) {")
+        .line("                const std::byte* const message = this->next();")
+        .line("                if (message == nullptr) return count;")
+        .line("                const T view {reinterpret_cast<size_t>(message)};")
+        .line("                if constexpr (!std::is_same_v<std::remove_cvref_t<KeyOf>, std::nullptr_t>) {")
+        .line("                    const Key key = key_of(view);")
+        .line("                    if (key < low || high < key) continue;")
+        .line("                }")
+        .line("                f(view);")
+        .line("                count++;")
+        .line("            }")
+        .line("        }")
+        .line("        return count;")
+        .line("    }")
+        .line("private:")
+        .line("    // The first entry whose biggest key is not less than key, entry_count if there is none.")
+        .line("    uint64_t first_entry_reaching (Key key) const {")
+        .line("        const Entry* first = entries;")
+        .line("        uint64_t length = footer.entry_count;")
+        .line("        while (length > 0) {")
+        .line("            const uint64_t half = length / 2;")
+        .line("            if (first[half].max_key < key) {")
+        .line("                first += half + 1;")
+        .line("                length -= half + 1;")
+        .line("            } else {")
+        .line("                length = half;")
+        .line("            }")
+        .line("        }")
+        .line("        return static_cast<uint64_t>(first - entries);")
+        .line("    }")
+        .line("    void seek_entry (uint64_t entry_idx) {")
+        .line("        this->offset = entries[entry_idx].offset;")
+        .line("        __builtin_prefetch(this->data + this->offset);")
+        .line("    }")
+        .line("    IndexFooter footer {};")
+        .line("    const Entry* entries = nullptr;")
+        .line("};")
+        .line("} // namespace stream")
+        .line("#endif");
+}
+
 [[nodiscard]] inline codegen::UnknownStructBase&& add_size_leafs (
     const std::span<SizeLeaf> level_size_leafs,
     const std::span<const layout::FixedOffset> fixed_offsets,
     codegen::UnknownStructBase&& struct_code
 ) {
     for (size_t i = 0; i < level_size_leafs.size(); i++) {
-        auto [min_size, idx, size_size, stored_size_size] = level_size_leafs[i];
+        auto [min_size, idx, size_size, stored_size_size, max_byte_size] = level_size_leafs[i];
         const layout::FixedOffset& offset = fixed_offsets[idx];
-        struct_code = std::move(struct_code)
-            .method(codegen::Attributes{"static"}, SizeTypeStrs::get(size_size), codegen::StringParts{"size", i}, codegen::Args{"size_t base"})
-                .line("return *reinterpret_cast<", SizeTypeStrs::get(stored_size_size), "*>(base + ", offset.get_offset(), ");")
+        auto&& size_method = std::move(struct_code)
+            .method(codegen::Attributes{"static"}, SizeTypeStrs::get(size_size), codegen::StringParts{"size", i}, codegen::Args{"size_t base"});
+        // Sizes are stored relative to their minimum.
+        if (min_size == 0) {
+            size_method = std::move(size_method)
+                .line("return *reinterpret_cast<", SizeTypeStrs::get(stored_size_size), "*>(base + ", offset.get_offset(), ");");
+        } else {
+            size_method = std::move(size_method)
+                .line("return static_cast<", SizeTypeStrs::get(size_size), ">(", min_size, " + *reinterpret_cast<", SizeTypeStrs::get(stored_size_size), "*>(base + ", offset.get_offset(), "));");
+        }
+        struct_code = std::move(size_method)
             .end();
     }
     return std::move(struct_code);
@@ -407,6 +1164,489 @@ template <estd::conceptify<estd::is_not<std::is_reference>::type> Code>
     ).template as<Code>();
 }
 
+/**
+ * Size of the present optional values, padded to the alignment of the variable sized leafs behind them.
+ */
+[[nodiscard]] inline codegen::UnknownStructBase&& add_optionals_size (
+    const OffsetsAccessor& offsets_accessor,
+    codegen::UnknownStructBase&& struct_code
+) {
+    const layout::OptionalLeafs& optional_leafs = *offsets_accessor.optional_leafs;
+    if (optional_leafs.empty()) return std::move(struct_code);
+
+    const uint16_t first_map_idx = optional_leafs.first_map_idx;
+    const layout::FixedOffset& offset = offsets_accessor.fixed_offsets[offsets_accessor.idx_map[first_map_idx]];
+    const SIZE word_size = offsets_accessor.bit_leafs[first_map_idx].word_size;
+    const uint64_t alignment_mask = uint64_t{optional_leafs.end_alignment.byte_size()} - 1;
+
+    auto&& size_method = std::move(struct_code)
+        .method(codegen::Attributes{"static"}, "size_t", "optionals_size", codegen::Args{"size_t base"})
+            .line("const uint64_t presence = *reinterpret_cast<const ", SizeTypeStrs::get(word_size), "*>(base + ", offset.get_offset(), ");");
+    if (alignment_mask == 0) {
+        return std::move(size_method)
+            .line("return ", PresencePopcountCodeGenerator{optional_leafs.all, false}, ";")
+            .end();
+    }
+    return std::move(size_method)
+        .line("return (", PresencePopcountCodeGenerator{optional_leafs.all, false}, " + ", alignment_mask, ") & ~size_t{", alignment_mask, "};")
+        .end();
+}
+
+template <estd::conceptify<estd::is_not<std::is_reference>::type> Code>
+[[nodiscard]] inline Code&& add_optionals_size (
+    const OffsetsAccessor& offsets_accessor,
+    Code&& struct_code
+) {
+    return add_optionals_size(
+        offsets_accessor,
+        std::move(struct_code).template as<codegen::UnknownStructBase>()
+    ).template as<Code>();
+}
+
+/**
+ * Total size of a message, the start of the variable sized leafs plus the byte size of each of them. The size leafs are
+ * loaded independently of each other, so the loads can overlap. Without variable sized leafs the size is a constant.
+ * max_byte_size is the size with every optional value present and every variable sized leaf at its maximum, it sizes
+ * buffers ahead of time. byte_size only reads the first fixed_byte_size bytes, readers of untrusted input check for
+ * those first.
+ * Added behind the private size leafs, so it opens a public section.
+ */
+[[nodiscard]] inline codegen::UnknownStructBase&& add_byte_size (
+    const OffsetsAccessor& offsets_accessor,
+    const std::span<const SizeLeaf> level_size_leafs,
+    codegen::UnknownStructBase&& struct_code
+) {
+    const layout::OptionalLeafs& optional_leafs = *offsets_accessor.optional_leafs;
+    if (level_size_leafs.empty() && optional_leafs.empty()) {
+        return std::move(struct_code)
+            ._public()
+            .field("static constexpr size_t", codegen::StringParts{"fixed_byte_size = "_sl, offsets_accessor.var_leafs_start})
+            .field("static constexpr size_t", codegen::StringParts{"max_byte_size = "_sl, offsets_accessor.var_leafs_start})
+            .method(codegen::Attributes{"static", "constexpr"}, "size_t", "byte_size", codegen::Args{"const std::byte* /*unused*/"})
+                .line("return ", offsets_accessor.var_leafs_start, ";")
+            .end();
+    }
+
+    // Every size leaf of the top level holds the byte size of its leaf.
+    const std::vector<uint64_t> size_chain(level_size_leafs.size(), 1);
+    // The optional values are padded like optionals_size() pads them.
+    uint64_t optional_values_size = 0;
+    if (!optional_leafs.empty()) {
+        SIZE::enums::foreach([&]<SIZE size>() {
+            optional_values_size += uint64_t{static_cast<uint32_t>(std::popcount(optional_leafs.all.get<size>()))} * size.byte_size();
+        });
+        const uint64_t alignment_mask = uint64_t{optional_leafs.end_alignment.byte_size()} - 1;
+        optional_values_size = (optional_values_size + alignment_mask) & ~alignment_mask;
+    }
+    uint64_t byte_size_bound = offsets_accessor.var_leafs_start + optional_values_size;
+    for (const SizeLeaf& size_leaf : level_size_leafs) {
+        byte_size_bound += size_leaf.max_byte_size;
+    }
+    return std::move(struct_code)
+        ._public()
+        .field("static constexpr size_t", codegen::StringParts{"fixed_byte_size = "_sl, offsets_accessor.var_leafs_start})
+        .field("static constexpr size_t", codegen::StringParts{"max_byte_size = "_sl, byte_size_bound})
+        .method(codegen::Attributes{"static"}, "size_t", "byte_size", codegen::Args{"const std::byte* data"})
+            .line("const size_t base = reinterpret_cast<size_t>(data);")
+            .line("return ", offsets_accessor.var_leafs_start_code(), SizeChainCodeGenerator{size_chain}, ";")
+        .end();
+}
+
+template <estd::conceptify<estd::is_not<std::is_reference>::type> Code>
+[[nodiscard]] inline Code&& add_byte_size (
+    const OffsetsAccessor& offsets_accessor,
+    const std::span<const SizeLeaf> level_size_leafs,
+    Code&& struct_code
+) {
+    return add_byte_size(
+        offsets_accessor,
+        level_size_leafs,
+        std::move(struct_code).template as<codegen::UnknownStructBase>()
+    ).template as<Code>();
+}
+
+/**
+ * Collects a message from fragments. The buffer grows to the fixed region first and then once to the byte size the
+ * size leafs of that region give, so bytes_needed() is exact as soon as the fixed region has arrived. It is made of
+ * AlignedWords, so view() is aligned for the vector accessors.
+ * Added behind byte_size, in its public section.
+ */
+[[nodiscard]] inline codegen::UnknownStructBase&& add_decoder (
+    const OffsetsAccessor& offsets_accessor,
+    const size_t size_leafs_count,
+    const std::string_view struct_name,
+    codegen::UnknownStructBase&& struct_code
+) {
+    const uint64_t fixed_size = offsets_accessor.var_leafs_start;
+    const std::string_view is_sized = size_leafs_count == 0 && offsets_accessor.optional_leafs->empty() ? "true" : "false";
+    return std::move(struct_code)
+        ._struct("Decoder")
+        .strip_name()
+        .method("size_t", "bytes_needed")
+            .line("return needed - received;")
+        .end()
+        .method("bool", "done")
+            .line("return sized && received == needed;")
+        .end()
+        .method("size_t", "feed", codegen::Args{"std::span<const std::byte> bytes"})
+            .line("size_t taken = 0;")
+            ._while("received < needed && taken < bytes.size()")
+                .line("const size_t count = needed - received < bytes.size() - taken ? needed - received : bytes.size() - taken;")
+                .line("reserve(needed);")
+                .line("std::memcpy(reinterpret_cast<std::byte*>(buffer.get()) + received, bytes.data() + taken, count);")
+                .line("received += count;")
+                .line("taken += count;")
+                ._if("received == needed && !sized")
+                    .line("sized = true;")
+                    .line("needed = byte_size(data());")
+                .end()
+            .end()
+            .line("return taken;")
+        .end()
+        .method("const std::byte*", "data")
+            .line("return reinterpret_cast<const std::byte*>(buffer.get());")
+        .end()
+        .method(struct_name, "view")
+            .line("return ", struct_name, "{reinterpret_cast<size_t>(buffer.get())};")
+        .end()
+        .method("void", "reset")
+            .line("received = 0;")
+            .line("needed = ", fixed_size, ";")
+            .line("sized = ", is_sized, ";")
+        .end()
+        ._private()
+        .method("void", "reserve", codegen::Args{"size_t size"})
+            ._if("size <= capacity")
+                .line("return;")
+            .end()
+            .line("const size_t words = (size + alignment - 1) / alignment;")
+            .line("std::unique_ptr<AlignedWord[]> grown {new AlignedWord[words]};")
+            ._if("received != 0")
+                .line("std::memcpy(grown.get(), buffer.get(), received);")
+            .end()
+            .line("buffer = std::move(grown);")
+            .line("capacity = words * alignment;")
+        .end()
+        .field("std::unique_ptr<AlignedWord[]>", "buffer")
+        .field("size_t", "capacity = 0")
+        .field("size_t", "received = 0")
+        .field("size_t", codegen::StringParts{"needed = ", fixed_size})
+        .field("bool", codegen::StringParts{"sized = ", is_sized})
+        .end();
+}
+
+template <estd::conceptify<estd::is_not<std::is_reference>::type> Code>
+[[nodiscard]] inline Code&& add_decoder (
+    const OffsetsAccessor& offsets_accessor,
+    const size_t size_leafs_count,
+    const std::string_view struct_name,
+    Code&& struct_code
+) {
+    return add_decoder(
+        offsets_accessor,
+        size_leafs_count,
+        struct_name,
+        std::move(struct_code).template as<codegen::UnknownStructBase>()
+    ).template as<Code>();
+}
+
+/**
+ * Resizes the strings of the top level in place. Variable sized leafs are ordered by alignment and strings come last,
+ * so the bytes behind a string move with one memmove and keep their alignment. An Editor either works on a buffer of
+ * fixed capacity, aligned to the alignment of the message, or on its own copy with slack, which grows by half when a
+ * resize needs more.
+ * set_<name>(value) and clear_<name>() insert and remove the value of an optional of the top level. The values behind
+ * it move by its size, the variable sized leafs behind all values by the change of the padded optionals_size.
+ * Added behind the Decoder, in the public section.
+ */
+[[nodiscard]] inline codegen::UnknownStructBase&& add_editor (
+    const OffsetsAccessor& offsets_accessor,
+    const std::span<const ResizableLeaf> resizable_leafs,
+    const std::span<const ResizableOptional> resizable_optionals,
+    const std::span<const SizeLeaf> level_size_leafs,
+    const std::string_view struct_name,
+    codegen::UnknownStructBase&& struct_code
+) {
+    if (resizable_leafs.empty() && resizable_optionals.empty()) return std::move(struct_code);
+
+    auto&& editor_struct = std::move(struct_code)
+        ._struct("Editor")
+        .ctor("std::byte* message, size_t capacity", "message(message), capacity(capacity)")
+        .end()
+        .method(codegen::Attributes{"static"}, "Editor", "with_slack", codegen::Args{"const std::byte* data", "size_t slack"})
+            .line("Editor editor {nullptr, 0};")
+            .line("editor.growable = true;")
+            .line("const size_t size = byte_size(data);")
+            .line("static_cast<void>(editor.reserve(size + slack, 0));")
+            .line("std::memcpy(editor.message, data, size);")
+            .line("return editor;")
+        .end()
+        .method("const std::byte*", "data")
+            .line("return message;")
+        .end()
+        .method("size_t", "size")
+            .line("return byte_size(message);")
+        .end()
+        .method(struct_name, "view")
+            .line("return ", struct_name, "{reinterpret_cast<size_t>(message)};")
+        .end();
+
+    for (const ResizableLeaf& leaf : resizable_leafs) {
+        const SizeLeaf& size_leaf = level_size_leafs[leaf.size_leaf_idx];
+        const uint64_t size_leaf_offset = offsets_accessor.fixed_offsets[size_leaf.idx].get_offset();
+        const std::string_view stored_type_str = SizeTypeStrs::get(size_leaf.stored_size_size);
+        editor_struct = std::move(editor_struct)
+            .method("char*", codegen::StringParts{"data_"_sl, leaf.name})
+                .line("const size_t base = reinterpret_cast<size_t>(message);")
+                .line("return reinterpret_cast<char*>(base + ", offsets_accessor.var_leafs_start_code(), SizeChainCodeGenerator{leaf.size_chain}, ");")
+            .end()
+            // Returns the new byte size of the message, 0 if the size is out of range or does not fit.
+            .method("size_t", codegen::StringParts{"resize_"_sl, leaf.name}, codegen::Args{"size_t new_size"})
+                .line("const size_t base = reinterpret_cast<size_t>(message);")
+                .line("const size_t start = ", offsets_accessor.var_leafs_start_code(), SizeChainCodeGenerator{leaf.size_chain}, ";")
+                .line("const size_t old_size = size", leaf.size_leaf_idx, "(base);")
+                .line("const size_t total = byte_size(message);")
+                .line("const size_t resized = total - old_size + new_size;")
+                ._if(codegen::StringParts{"new_size < "_sl, size_leaf.min_size, " || new_size > "_sl, leaf.max_size, " || !reserve(resized, total)"_sl})
+                    .line("return 0;")
+                .end()
+                .line("std::memmove(message + start + new_size, message + start + old_size, total - start - old_size);")
+                // reserve() may have moved the message, base is stale.
+                .line("*reinterpret_cast<", stored_type_str, "*>(reinterpret_cast<size_t>(message) + ", size_leaf_offset, ") = static_cast<", stored_type_str, ">(new_size - ", size_leaf.min_size, ");")
+                .line("return resized;")
+            .end()
+            .method("size_t", codegen::StringParts{"assign_"_sl, leaf.name}, codegen::Args{"const char* chars", "size_t length"})
+                .line("const size_t resized = resize_", leaf.name, "(length + 1);")
+                ._if("resized == 0")
+                    .line("return 0;")
+                .end()
+                .line("char* dst = data_", leaf.name, "();")
+                .line("std::memcpy(dst, chars, length);")
+                .line("dst[length] = '\\0';")
+                .line("return resized;")
+            .end();
+    }
+
+    const layout::OptionalLeafs& optional_leafs = *offsets_accessor.optional_leafs;
+    const uint64_t values_start = offsets_accessor.var_leafs_start;
+    for (const ResizableOptional& optional : resizable_optionals) {
+        const std::string_view word_type_str = SizeTypeStrs::get(optional.bit_leaf.word_size);
+        const uint64_t value_size = optional.value_size.byte_size();
+        const uint16_t shift = optional.bit_leaf.shift;
+        editor_struct = std::move(editor_struct)
+            // Returns the new byte size of the message, 0 if an inserted value does not fit.
+            .method("size_t", codegen::StringParts{"set_"_sl, optional.name}, codegen::Args{codegen::StringParts{optional.value_type, " value"_sl}})
+                .line("const size_t base = reinterpret_cast<size_t>(message);")
+                .line("const uint64_t presence = *reinterpret_cast<const ", word_type_str, "*>(base + ", optional.word_offset, ");")
+                .line("const size_t start = ", values_start, PresencePopcountCodeGenerator{optional.preceding}, ";")
+                .line("size_t total = byte_size(message);")
+                ._if(codegen::StringParts{"((presence >> "_sl, shift, ") & 1) == 0"_sl})
+                    .line("const size_t values_size = ", PresencePopcountCodeGenerator{optional_leafs.all, false}, ";")
+                    .line("const size_t leafs_start = ", values_start, " + padded_optionals_size(values_size);")
+                    .line("const size_t grown_leafs_start = ", values_start, " + padded_optionals_size(values_size + ", value_size, ");")
+                    .line("const size_t resized = total - leafs_start + grown_leafs_start;")
+                    ._if("!reserve(resized, total)")
+                        .line("return 0;")
+                    .end()
+                    .line("std::memmove(message + grown_leafs_start, message + leafs_start, total - leafs_start);")
+                    .line("std::memmove(message + start + ", value_size, ", message + start, ", values_start, " + values_size - start);")
+                    .line("*reinterpret_cast<", word_type_str, "*>(reinterpret_cast<size_t>(message) + ", optional.word_offset, ") = static_cast<", word_type_str, ">(presence | (uint64_t{1} << ", shift, "));")
+                    .line("total = resized;")
+                .end()
+                .line("std::memcpy(message + start, &value, ", value_size, ");")
+                .line("return total;")
+            .end()
+            // Returns the new byte size of the message.
+            .method("size_t", codegen::StringParts{"clear_"_sl, optional.name})
+                .line("const size_t base = reinterpret_cast<size_t>(message);")
+                .line("const uint64_t presence = *reinterpret_cast<const ", word_type_str, "*>(base + ", optional.word_offset, ");")
+                .line("const size_t total = byte_size(message);")
+                ._if(codegen::StringParts{"((presence >> "_sl, shift, ") & 1) == 0"_sl})
+                    .line("return total;")
+                .end()
+                .line("const size_t start = ", values_start, PresencePopcountCodeGenerator{optional.preceding}, ";")
+                .line("const size_t values_size = ", PresencePopcountCodeGenerator{optional_leafs.all, false}, ";")
+                .line("const size_t leafs_start = ", values_start, " + padded_optionals_size(values_size);")
+                .line("const size_t shrunk_leafs_start = ", values_start, " + padded_optionals_size(values_size - ", value_size, ");")
+                .line("std::memmove(message + start, message + start + ", value_size, ", ", values_start, " + values_size - start - ", value_size, ");")
+                .line("std::memmove(message + shrunk_leafs_start, message + leafs_start, total - leafs_start);")
+                .line("*reinterpret_cast<", word_type_str, "*>(base + ", optional.word_offset, ") = static_cast<", word_type_str, ">(presence & ~(uint64_t{1} << ", shift, "));")
+                .line("return total - leafs_start + shrunk_leafs_start;")
+            .end();
+    }
+    if (!resizable_optionals.empty()) {
+        const uint64_t alignment_mask = uint64_t{optional_leafs.end_alignment.byte_size()} - 1;
+        editor_struct = std::move(editor_struct)
+            ._private()
+            .method(codegen::Attributes{"static", "constexpr"}, "size_t", "padded_optionals_size", codegen::Args{"size_t values_size"})
+                .line("return (values_size + ", alignment_mask, ") & ~size_t{", alignment_mask, "};")
+            .end()
+            ._public();
+    }
+
+    return std::move(editor_struct)
+        ._private()
+        .method("bool", "reserve", codegen::Args{"size_t size", "size_t used"})
+            ._if("size <= capacity")
+                .line("return true;")
+            .end()
+            ._if("!growable")
+                .line("return false;")
+            .end()
+            .line("const size_t grown = size > capacity + (capacity / 2) ? size : capacity + (capacity / 2);")
+            .line("const size_t words = (grown + alignment - 1) / alignment;")
+            .line("std::unique_ptr<AlignedWord[]> buffer {new AlignedWord[words]};")
+            ._if("used != 0")
+                .line("std::memcpy(buffer.get(), message, used);")
+            .end()
+            .line("owned = std::move(buffer);")
+            .line("message = reinterpret_cast<std::byte*>(owned.get());")
+            .line("capacity = words * alignment;")
+            .line("return true;")
+        .end()
+        .field("std::unique_ptr<AlignedWord[]>", "owned")
+        .field("std::byte*", "message")
+        .field("size_t", "capacity")
+        .field("bool", "growable = false")
+        .end();
+}
+
+template <estd::conceptify<estd::is_not<std::is_reference>::type> Code>
+[[nodiscard]] inline Code&& add_editor (
+    const OffsetsAccessor& offsets_accessor,
+    const std::span<const ResizableLeaf> resizable_leafs,
+    const std::span<const ResizableOptional> resizable_optionals,
+    const std::span<const SizeLeaf> level_size_leafs,
+    const std::string_view struct_name,
+    Code&& struct_code
+) {
+    return add_editor(
+        offsets_accessor,
+        resizable_leafs,
+        resizable_optionals,
+        level_size_leafs,
+        struct_name,
+        std::move(struct_code).template as<codegen::UnknownStructBase>()
+    ).template as<Code>();
+}
+
+/**
+ * A copy of the fixed region guarded by a sequence counter for one writer and any number of readers (--seqlock).
+ * Both sides copy the region word by word through relaxed atomic_refs, so a torn read is only detected, never a race.
+ * write(f) lets f change a private copy through the setters and publishes it between two bumps of the counter,
+ * try_read(f) hands f a consistent copy or gives up after a number of torn reads. Views of the copies only reach the
+ * fixed leafs. Added behind the Editor, in the public section.
+ */
+[[nodiscard]] inline codegen::UnknownStructBase&& add_seqlock (
+    const OffsetsAccessor& offsets_accessor,
+    const std::string_view struct_name,
+    codegen::UnknownStructBase&& struct_code
+) {
+    const uint64_t word_count = (offsets_accessor.var_leafs_start + 7) / 8;
+    if (!global::options::seqlock || word_count == 0) return std::move(struct_code);
+
+    return std::move(struct_code)
+        ._struct("Seqlock")
+        .strip_name()
+        .method(codegen::Attributes{"template <typename F>"}, "void", "write", codegen::Args{"F&& f"})
+            .line("alignas(alignment) uint64_t copy[", word_count, "];")
+            .line("for (size_t i = 0; i < ", word_count, "; i++) copy[i] = std::atomic_ref<uint64_t>(words[i]).load(std::memory_order_relaxed);")
+            .line("f(", struct_name, "{reinterpret_cast<size_t>(copy)});")
+            .line("const uint64_t seq = sequence.load(std::memory_order_relaxed);")
+            .line("sequence.store(seq + 1, std::memory_order_relaxed);")
+            .line("std::atomic_thread_fence(std::memory_order_release);")
+            .line("for (size_t i = 0; i < ", word_count, "; i++) std::atomic_ref<uint64_t>(words[i]).store(copy[i], std::memory_order_relaxed);")
+            .line("sequence.store(seq + 2, std::memory_order_release);")
+        .end()
+        .method(codegen::Attributes{"template <typename F>"}, "bool", "try_read", codegen::Args{"F&& f", "uint32_t tries = 64"})
+            .line("alignas(alignment) uint64_t copy[", word_count, "];")
+            ._for("uint32_t attempt = 0; attempt < tries; attempt++")
+                .line("const uint64_t before = sequence.load(std::memory_order_acquire);")
+                ._if("(before & 1) != 0")
+                    .line("continue;")
+                .end()
+                .line("for (size_t i = 0; i < ", word_count, "; i++) copy[i] = std::atomic_ref<uint64_t>(words[i]).load(std::memory_order_relaxed);")
+                .line("std::atomic_thread_fence(std::memory_order_acquire);")
+                ._if("sequence.load(std::memory_order_relaxed) == before")
+                    .line("f(", struct_name, "{reinterpret_cast<size_t>(copy)});")
+                    .line("return true;")
+                .end()
+            .end()
+            .line("return false;")
+        .end()
+        ._private()
+        .field("std::atomic<uint64_t>", "sequence {0}")
+        .field("alignas(alignment) uint64_t", codegen::StringParts{"words["_sl, word_count, "] {}"_sl})
+        .end();
+}
+
+template <estd::conceptify<estd::is_not<std::is_reference>::type> Code>
+[[nodiscard]] inline Code&& add_seqlock (
+    const OffsetsAccessor& offsets_accessor,
+    const std::string_view struct_name,
+    Code&& struct_code
+) {
+    return add_seqlock(
+        offsets_accessor,
+        struct_name,
+        std::move(struct_code).template as<codegen::UnknownStructBase>()
+    ).template as<Code>();
+}
+
+/**
+ * Every fixed leaf and size leaf lies in the fixed region in front of the variable sized leafs, prefetch(data) touches
+ * each of its cache lines so the first accessors called on a message do not miss. Messages need not start on a cache
+ * line, the last byte of the region is prefetched too. Big regions stop after max_prefetch_lines lines.
+ * for_each hands f a view of every message and prefetches the one distance messages ahead of it.
+ * Added behind the Seqlock, in the public section.
+ */
+[[nodiscard]] inline codegen::UnknownStructBase&& add_prefetch (
+    const OffsetsAccessor& offsets_accessor,
+    const std::string_view struct_name,
+    codegen::UnknownStructBase&& struct_code
+) {
+    constexpr uint64_t cache_line = 64;
+    constexpr uint64_t max_prefetch_lines = 8;
+    const uint64_t fixed_size = offsets_accessor.var_leafs_start;
+    const uint64_t line_count = std::clamp<uint64_t>((fixed_size + cache_line - 1) / cache_line, 1, max_prefetch_lines);
+
+    auto&& method = std::move(struct_code)
+        .method(codegen::Attributes{"static"}, "void", "prefetch", codegen::Args{"const std::byte* data"});
+    for (uint64_t i = 0; i < line_count; i++) {
+        method = std::move(method)
+            .line("__builtin_prefetch(data + ", i * cache_line, ");");
+    }
+    if (fixed_size > 1 && fixed_size <= line_count * cache_line) {
+        method = std::move(method)
+            .line("__builtin_prefetch(data + ", fixed_size - 1, ");");
+    }
+    return std::move(method)
+        .end()
+        .method(codegen::Attributes{"template <typename F>", "static"}, "void", "for_each", codegen::Args{"std::span<const std::byte* const> messages", "F&& f", "size_t distance = 8"})
+            .line("const size_t count = messages.size();")
+            .line("for (size_t i = 0; i < distance && i < count; i++) prefetch(messages[i]);")
+            ._for("size_t i = 0; i < count; i++")
+                ._if("i + distance < count")
+                    .line("prefetch(messages[i + distance]);")
+                .end()
+                .line("f(", struct_name, "{reinterpret_cast<size_t>(messages[i])});")
+            .end()
+        .end();
+}
+
+template <estd::conceptify<estd::is_not<std::is_reference>::type> Code>
+[[nodiscard]] inline Code&& add_prefetch (
+    const OffsetsAccessor& offsets_accessor,
+    const std::string_view struct_name,
+    Code&& struct_code
+) {
+    return add_prefetch(
+        offsets_accessor,
+        struct_name,
+        std::move(struct_code).template as<codegen::UnknownStructBase>()
+    ).template as<Code>();
+}
+
 template <StringLiteral type_name, char target>
 consteval bool is_last_non_whitespace_ () {
     size_t i = type_name.size();
@@ -432,53 +1672,134 @@ constexpr auto first_return_line_part = first_return_line_part_<type_name, postf
 template <bool is_direct_pack>
 using direct_pack_legnth_arg_t = std::conditional_t<is_direct_pack, const uint32_t, estd::empty>;
 
-template <bool is_array_element, StringLiteral type_name, SIZE type_size, bool is_direct_pack>
+/**
+ * Adds `load_`, `store_` and for integers `fetch_add_` accessors going through std::atomic_ref (--atomic-accessors).
+ * Leafs are aligned to their size and messages to 8 bytes, which is all atomic_ref asks for. Array elements get
+ * `load(idx)`, `store(idx, value)` and `fetch_add(idx, value)`. line(method, head, tail) puts the address of the leaf
+ * between head and tail and ends the method.
+ */
+template <StringLiteral type_name, bool is_array_element, typename Name, typename Line>
+[[nodiscard]] inline codegen::UnknownStructBase&& add_atomic_accessors (codegen::UnknownStructBase&& code, const Name& name, const Line& line) {
+    if (!global::options::atomic_accessors) return std::move(code);
+
+    constexpr auto ref_head = string_literal::concat_v<"std::atomic_ref<"_sl, type_name, ">(*reinterpret_cast<"_sl, type_name, "*>(base"_sl>;
+    constexpr auto return_ref_head = string_literal::concat_v<"return "_sl, ref_head>;
+    constexpr auto value_arg = string_literal::concat_v<type_name, " value"_sl>;
+    constexpr bool is_integer = !(type_name == "bool"_sl || type_name == "float"_sl || type_name == "double"_sl);
+    constexpr auto order_arg = "std::memory_order order = std::memory_order_seq_cst"_sl;
+
+    if constexpr (is_array_element) {
+        codegen::UnknownStructBase&& with_store = line(
+            line(
+                std::move(code).method(type_name, "load", codegen::Args{"uint32_t idx", order_arg}),
+                return_ref_head,
+                ")).load(order);"_sl
+            ).method("void", "store", codegen::Args{"uint32_t idx", value_arg, order_arg}),
+            ref_head,
+            ")).store(value, order);"_sl
+        );
+        if constexpr (!is_integer) return std::move(with_store);
+        return line(
+            std::move(with_store).method(type_name, "fetch_add", codegen::Args{"uint32_t idx", value_arg, order_arg}),
+            return_ref_head,
+            ")).fetch_add(value, order);"_sl
+        );
+    } else {
+        codegen::UnknownStructBase&& with_store = line(
+            line(
+                std::move(code).method(type_name, codegen::StringParts{"load_"_sl, name}, codegen::Args{order_arg}),
+                return_ref_head,
+                ")).load(order);"_sl
+            ).method("void", codegen::StringParts{"store_"_sl, name}, codegen::Args{value_arg, order_arg}),
+            ref_head,
+            ")).store(value, order);"_sl
+        );
+        if constexpr (!is_integer) return std::move(with_store);
+        return line(
+            std::move(with_store).method(type_name, codegen::StringParts{"fetch_add_"_sl, name}, codegen::Args{value_arg, order_arg}),
+            return_ref_head,
+            ")).fetch_add(value, order);"_sl
+        );
+    }
+}
+
+template <bool is_array_element, StringLiteral type_name, SIZE type_size, bool is_direct_pack, typename Name>
 [[nodiscard]] inline codegen::UnknownStructBase&& gen_fixed_value_leaf_in_array (
     codegen::UnknownMethod&& get_method,
     const OffsetsAccessor& offsets_accessor,
     const uint16_t pack_info_idx,
     const uint8_t array_depth,
-    direct_pack_legnth_arg_t<is_direct_pack> direct_pack_length
+    direct_pack_legnth_arg_t<is_direct_pack> direct_pack_length,
+    const Name& name
 ) {
     const layout::FixedOffset fo = offsets_accessor.next_fixed_leaf();
     const uint64_t offset = fo.get_offset();
-    if constexpr (type_size == SIZE::SIZE_1 && !is_direct_pack) {
-        if (offset == 0) {
-            return std::move(get_method)
-            .line(first_return_line_part<type_name, "">, IdxCalcCodeGenerator<true, is_array_element>{offsets_accessor.pack_infos, pack_info_idx, array_depth}, ");")
-            .end();
-        } else {
-            return std::move(get_method)
-            .line(first_return_line_part<type_name>, offset, IdxCalcCodeGenerator<true, is_array_element>{offsets_accessor.pack_infos, pack_info_idx, array_depth}, ");")
-            .end();
-        }
-    } else {
-        if constexpr (is_direct_pack) {
-            constexpr auto type_byte_size = type_size.byte_size();
+    offsets_accessor.add_alternative_leaf_in_array();
+
+    // The getter and the setter address the leaf alike, they only differ in what surrounds the address.
+    const auto line = [&] (codegen::UnknownMethod&& method, const auto& head, const auto& tail) -> codegen::UnknownStructBase&& {
+        if constexpr (type_size == SIZE::SIZE_1 && !is_direct_pack) {
             if (offset == 0) {
-                return std::move(get_method)
-                .line(first_return_line_part<type_name, "">, IdxCalcCodeGenerator<false, is_array_element>{offsets_accessor.pack_infos, pack_info_idx, array_depth}, " * ", type_byte_size * direct_pack_length, ");")
+                return std::move(method)
+                .line(head, IdxCalcCodeGenerator<true, is_array_element>{offsets_accessor.pack_infos, pack_info_idx, array_depth}, tail)
                 .end();
             } else {
-                return std::move(get_method)
-                .line(first_return_line_part<type_name>, offset, IdxCalcCodeGenerator<false, is_array_element>{offsets_accessor.pack_infos, pack_info_idx, array_depth}, " * ", type_byte_size * direct_pack_length, ");")
+                return std::move(method)
+                .line(head, " + ", offset, IdxCalcCodeGenerator<true, is_array_element>{offsets_accessor.pack_infos, pack_info_idx, array_depth}, tail)
                 .end();
             }
         } else {
-            constexpr auto type_size_str = string_literal::from<type_size.byte_size()>;
-            if (offset == 0) {
-                return std::move(get_method)
-                .line(first_return_line_part<type_name, "">, IdxCalcCodeGenerator<false, is_array_element>{offsets_accessor.pack_infos, pack_info_idx, array_depth}, string_literal::concat_v<" * "_sl, type_size_str, ");"_sl>)
-                .end();
+            if constexpr (is_direct_pack) {
+                constexpr auto type_byte_size = type_size.byte_size();
+                if (offset == 0) {
+                    return std::move(method)
+                    .line(head, IdxCalcCodeGenerator<false, is_array_element>{offsets_accessor.pack_infos, pack_info_idx, array_depth}, " * ", type_byte_size * direct_pack_length, tail)
+                    .end();
+                } else {
+                    return std::move(method)
+                    .line(head, " + ", offset, IdxCalcCodeGenerator<false, is_array_element>{offsets_accessor.pack_infos, pack_info_idx, array_depth}, " * ", type_byte_size * direct_pack_length, tail)
+                    .end();
+                }
             } else {
-                return std::move(get_method)
-                .line(first_return_line_part<type_name>, offset, IdxCalcCodeGenerator<false, is_array_element>{offsets_accessor.pack_infos, pack_info_idx, array_depth}, string_literal::concat_v<" * "_sl, type_size_str, ");"_sl>)
-                .end();
+                constexpr auto type_size_str = string_literal::from<type_size.byte_size()>;
+                if (offset == 0) {
+                    return std::move(method)
+                    .line(head, IdxCalcCodeGenerator<false, is_array_element>{offsets_accessor.pack_infos, pack_info_idx, array_depth}, string_literal::concat_v<" * "_sl, type_size_str>, tail)
+                    .end();
+                } else {
+                    return std::move(method)
+                    .line(head, " + ", offset, IdxCalcCodeGenerator<false, is_array_element>{offsets_accessor.pack_infos, pack_info_idx, array_depth}, string_literal::concat_v<" * "_sl, type_size_str>, tail)
+                    .end();
+                }
             }
         }
+    };
+
+    codegen::UnknownStructBase&& with_getter = line(std::move(get_method), first_return_line_part<type_name, "">, ");"_sl);
+    if constexpr (is_last_non_whitespace<type_name, '*'>) {
+        return std::move(with_getter);
+    } else {
+        constexpr auto setter_head = string_literal::concat_v<"*reinterpret_cast<"_sl, type_name, "*>(base"_sl>;
+        if constexpr (is_array_element) {
+            return add_atomic_accessors<type_name, true>(line(
+                std::move(with_getter).method("void", "set", codegen::Args{"uint32_t idx", codegen::StringParts{type_name, " value"_sl}}),
+                setter_head,
+                ") = value;"_sl
+            ), name, line);
+        } else {
+            return add_atomic_accessors<type_name, false>(line(
+                std::move(with_getter).method("void", codegen::StringParts{"set_"_sl, name}, codegen::Args{codegen::StringParts{type_name, " value"_sl}}),
+                setter_head,
+                ") = value;"_sl
+            ), name, line);
+        }
     }
 }
 
+/**
+ * Emits the getter of a fixed size leaf and, unless it hands out a pointer, a setter writing the leaf in place.
+ * Array elements get `get(idx)` and `set(idx, value)`, other leafs `name()` and `set_name(value)`.
+ */
 template <
     bool is_array_element,
     bool in_array,
@@ -501,11 +1822,12 @@ template <
             offsets_accessor,
             pack_info_idx,
             array_depth,
-            direct_pack_length
+            direct_pack_length,
+            estd::empty{}
         );
     } else {
-        codegen::Method<codegen::UnknownStructBase>&& get_method = std::move(code)
-            .method(type_name, get_name(std::forward<ArgsT>(name_providing_args)));
+        codegen::Method<codegen::UnknownStructBase>&& get_method = begin_accessor(std::move(code)
+            .method(type_name, get_name(std::forward<ArgsT>(name_providing_args))), name_providing_args);
 
         if constexpr (in_array) {
             return gen_fixed_value_leaf_in_array<false, type_name, type_size, is_direct_pack>(
@@ -513,20 +1835,37 @@ template <
                 offsets_accessor,
                 pack_info_idx,
                 array_depth,
-                direct_pack_length
+                direct_pack_length,
+                get_name(name_providing_args)
             );
         } else {
             // console.warn("direct_pack_length not used. is that fine?");
             // _gen_fixed_value_leaf_default
             const uint64_t offset = offsets_accessor.next_fixed_offset();
-            if (offset == 0) {
-                return std::move(get_method)
-                    .line(first_return_line_part<type_name, ");">)
-                    .end();
+            if constexpr (is_direct_pack) {
+                offsets_accessor.add_alternative_leaf(offset, type_size.byte_size() * direct_pack_length);
             } else {
-                return std::move(get_method)
+                offsets_accessor.add_alternative_leaf(offset, type_size.byte_size());
+            }
+            codegen::UnknownStructBase&& with_getter = offset == 0
+                ? std::move(get_method)
+                    .line(first_return_line_part<type_name, ");">)
+                    .end()
+                : std::move(get_method)
                     .line(first_return_line_part<type_name>, offset, ");")
                     .end();
+            if constexpr (is_last_non_whitespace<type_name, '*'>) {
+                return std::move(with_getter);
+            } else {
+                const auto line = [offset] (codegen::UnknownMethod&& method, const auto& head, const auto& tail) -> codegen::UnknownStructBase&& {
+                    return std::move(method)
+                        .line(head, " + ", offset, tail)
+                        .end();
+                };
+                return add_atomic_accessors<type_name, false>(std::move(with_getter)
+                    .method("void", codegen::StringParts{"set_"_sl, get_name(name_providing_args)}, codegen::Args{codegen::StringParts{type_name, " value"_sl}})
+                        .line("*reinterpret_cast<", type_name, "*>(base + ", offset, ") = value;")
+                    .end(), get_name(name_providing_args), line);
             }
         }
     }
@@ -568,7 +1907,7 @@ template <bool is_array_element, StringLiteral type_name, SIZE type_size, bool i
     const uint8_t array_depth,
     direct_pack_legnth_arg_t<is_direct_pack> direct_pack_length
 ) {
-    const uint64_t& var_leafs_start = offsets_accessor.var_leafs_start;
+    const VarLeafsStartCodeGenerator var_leafs_start = offsets_accessor.var_leafs_start_code();
     const auto size_chain = offsets_accessor.next_var_offset();
 
     if constexpr (type_size == SIZE::SIZE_1 && !is_direct_pack) {
@@ -633,8 +1972,8 @@ template <
             direct_pack_length
         );
     } else {
-        codegen::Method<codegen::UnknownStructBase>&& get_method = std::move(code)
-            .method(type_name, get_name(std::forward<ArgsT>(name_providing_args)));
+        codegen::Method<codegen::UnknownStructBase>&& get_method = begin_accessor(std::move(code)
+            .method(type_name, get_name(std::forward<ArgsT>(name_providing_args))), name_providing_args);
 
         if constexpr (in_array) {
             return gen_var_value_leaf_in_array<false, type_name, type_size, is_direct_pack>(
@@ -642,7 +1981,7 @@ template <
         } else {
             static_assert(!is_direct_pack);
             // _gen_var_value_leaf_default
-            const uint64_t& var_leafs_start = offsets_accessor.var_leafs_start;
+            const VarLeafsStartCodeGenerator var_leafs_start = offsets_accessor.var_leafs_start_code();
             const auto size_chain = offsets_accessor.next_var_offset();
 
             if (size_chain.empty()) {
@@ -693,8 +2032,8 @@ template <typename ArgsT, typename UniqueNameT>
     const std::string_view& ctor_used,
     const UniqueNameT& unique_name
 ) {
-    codegen::Method<codegen::UnknownStructBase>&& field_method = std::move(code)
-        .method(unique_name, get_name(additional_args));
+    codegen::Method<codegen::UnknownStructBase>&& field_method = begin_accessor(std::move(code)
+        .method(unique_name, get_name(additional_args)), additional_args);
 
     if constexpr (is_dynamic_variant_element<ArgsT>) {
         if (additional_args.offset.empty()) {
@@ -730,6 +2069,242 @@ template <typename ArgsT, typename UniqueNameT, estd::conceptify<estd::is_not<st
 
 using code_generation_static_data::ArrayCtorStrs;
 
+[[nodiscard]] constexpr std::string_view scalar_type_name (const lexer::FIELD_TYPE type) {
+    switch (type) {
+        case lexer::FIELD_TYPE::BOOL:       return "bool";
+        case lexer::FIELD_TYPE::UINT8:      return "uint8_t";
+        case lexer::FIELD_TYPE::UINT16:     return "uint16_t";
+        case lexer::FIELD_TYPE::UINT32:     return "uint32_t";
+        case lexer::FIELD_TYPE::UINT64:     return "uint64_t";
+        case lexer::FIELD_TYPE::INT8:       return "int8_t";
+        case lexer::FIELD_TYPE::INT16:      return "int16_t";
+        case lexer::FIELD_TYPE::INT32:      return "int32_t";
+        case lexer::FIELD_TYPE::INT64:      return "int64_t";
+        case lexer::FIELD_TYPE::FLOAT32:    return "float";
+        case lexer::FIELD_TYPE::FLOAT64:    return "double";
+        default:
+            std::unreachable();
+    }
+}
+
+/**
+ * Adds branchless `lower_bound(key)` and `find(key)` to a `[[sorted(key=field)]]` array, both return the length if
+ * there is no match. In Eytzinger order the children of the element at k - 1 are at 2k - 1 and 2k, so the first levels
+ * of the search share cache lines. When the keys lie back to back at key_column_offset, every step prefetches the
+ * descendants a cache line of keys below, the ones at k * keys_per_line - 1 and behind.
+ */
+template <estd::conceptify<estd::is_not<std::is_reference>::type> Code>
+[[nodiscard]] inline Code&& add_sorted_search (Code&& code, const lexer::ArrayType& array_type, const uint64_t key_column_offset) {
+    const uint32_t length = array_type.length;
+    const std::string_view key = array_type.sort_key;
+    const std::string_view key_type_str = scalar_type_name(array_type.sort_key_type);
+
+    auto&& lower_bound_method = std::move(code)
+        .method("uint32_t", "lower_bound", codegen::Args{codegen::StringParts{key_type_str, " key"_sl}});
+    if (array_type.eytzinger && key_column_offset != static_cast<uint64_t>(-1)) {
+        lower_bound_method = std::move(lower_bound_method)
+            .line("constexpr uint32_t keys_per_line = 64 / sizeof(", key_type_str, ");")
+            .line("uint32_t k = 1;")
+            ._while(codegen::StringParts{"k <= "_sl, length})
+                .line("__builtin_prefetch(reinterpret_cast<const void*>(base + ", key_column_offset, " + (((k * keys_per_line) - 1) * sizeof(", key_type_str, "))));")
+                .line("k = (2 * k) + (get(k - 1).", key, "() < key ? 1 : 0);")
+            .end()
+            .line("k >>= std::countr_one(k) + 1;")
+            .line("return k == 0 ? ", length, " : k - 1;");
+    } else if (array_type.eytzinger) {
+        lower_bound_method = std::move(lower_bound_method)
+            .line("uint32_t k = 1;")
+            .line("while (k <= ", length, ") k = (2 * k) + (get(k - 1).", key, "() < key ? 1 : 0);")
+            .line("k >>= std::countr_one(k) + 1;")
+            .line("return k == 0 ? ", length, " : k - 1;");
+    } else {
+        lower_bound_method = std::move(lower_bound_method)
+            .line("uint32_t first = 0;")
+            .line("uint32_t count = ", length, ";")
+            ._while("count > 1")
+                .line("const uint32_t half = count / 2;")
+                .line("first = get(first + half).", key, "() < key ? first + half : first;")
+                .line("count -= half;")
+            .end()
+            .line("return first + (get(first).", key, "() < key ? 1 : 0);");
+    }
+
+    return std::move(lower_bound_method)
+        .end()
+        .method("uint32_t", "find", codegen::Args{codegen::StringParts{key_type_str, " key"_sl}})
+            .line("const uint32_t idx = lower_bound(key);")
+            .line("return idx != ", length, " && get(idx).", key, "() == key ? idx : ", length, ";")
+        .end();
+}
+
+/**
+ * Adds `emplace_<alt>()` to a fixed variant, which sets the id and zeroes the leafs of the alternative. Adjacent leafs
+ * are cleared by one memset, bit packed leafs keep the other bits of their word.
+ */
+[[nodiscard]] inline codegen::UnknownStructBase&& add_emplace (
+    codegen::UnknownStructBase&& code,
+    const AlternativeLeafs& alternative_leafs,
+    const uint16_t variant_id
+) {
+    if (alternative_leafs.in_array) return std::move(code);
+
+    std::vector<AlternativeLeafs::Leaf> leafs = alternative_leafs.leafs;
+    std::ranges::sort(leafs, {}, &AlternativeLeafs::Leaf::offset);
+    std::vector<AlternativeLeafs::Leaf> merged;
+    for (const AlternativeLeafs::Leaf& leaf : leafs) {
+        if (!merged.empty()) {
+            AlternativeLeafs::Leaf& last = merged.back();
+            if (leaf.mask == 0 && last.mask == 0 && last.offset + last.size >= leaf.offset) {
+                last.size = std::max(last.size, leaf.offset + leaf.size - last.offset);
+                continue;
+            }
+            if (leaf.mask != 0 && last.mask != 0 && last.offset == leaf.offset) {
+                last.mask |= leaf.mask;
+                continue;
+            }
+        }
+        merged.push_back(leaf);
+    }
+
+    auto&& method = std::move(code)
+        .method("void", codegen::StringParts{"emplace_"_sl, variant_id})
+            .line("set_id(", variant_id, ");");
+    for (const AlternativeLeafs::Leaf& leaf : merged) {
+        if (leaf.mask == 0) {
+            method = std::move(method)
+                .line("std::memset(reinterpret_cast<void*>(base + ", leaf.offset, "), 0, ", leaf.size, ");");
+        } else {
+            const uint64_t word_bits = leaf.size * 8;
+            method = std::move(method)
+                .line("*reinterpret_cast<uint", word_bits, "_t*>(base + ", leaf.offset, ") &= static_cast<uint", word_bits, "_t>(~", leaf.mask, "ULL);");
+        }
+    }
+    return std::move(method)
+        .end();
+}
+
+/**
+ * Adds a `column_<leaf>()` span to a soa array for every leaf of its elements.
+ * Replays the map indices the element visit used, so it has to visit the leafs in the same order.
+ */
+template <typename NextType, typename Code>
+struct SoaColumnVisitor {
+    using next_type_t = NextType;
+    using result_t = lexer::Type::VisitResult<next_type_t>;
+
+    Code& code;
+    const OffsetsAccessor& offsets_accessor;
+    uint16_t& map_idx;
+    std::string& name;
+    uint32_t length;
+
+    void on_scalar (const lexer::FIELD_TYPE type) const {
+        const std::string_view type_name = scalar_type_name(type);
+        const uint64_t offset = offsets_accessor.fixed_offsets[offsets_accessor.idx_map[map_idx++]].get_offset();
+        code = std::move(code)
+            .method(codegen::StringParts{"std::span<const "_sl, type_name, ", "_sl, length, ">"_sl}, codegen::StringParts{"column"_sl, std::string_view{name}})
+                .line("return {reinterpret_cast<const ", type_name, "*>(base + ", offset, "), ", length, "};")
+            .end();
+    }
+
+    void on_bool     () const { on_scalar(lexer::FIELD_TYPE::BOOL   ); }
+    void on_uint8    () const { on_scalar(lexer::FIELD_TYPE::UINT8  ); }
+    void on_uint16   () const { on_scalar(lexer::FIELD_TYPE::UINT16 ); }
+    void on_uint32   () const { on_scalar(lexer::FIELD_TYPE::UINT32 ); }
+    void on_uint64   () const { on_scalar(lexer::FIELD_TYPE::UINT64 ); }
+    void on_int8     () const { on_scalar(lexer::FIELD_TYPE::INT8   ); }
+    void on_int16    () const { on_scalar(lexer::FIELD_TYPE::INT16  ); }
+    void on_int32    () const { on_scalar(lexer::FIELD_TYPE::INT32  ); }
+    void on_int64    () const { on_scalar(lexer::FIELD_TYPE::INT64  ); }
+    void on_float32  () const { on_scalar(lexer::FIELD_TYPE::FLOAT32); }
+    void on_float64  () const { on_scalar(lexer::FIELD_TYPE::FLOAT64); }
+
+    // The layout generation only accepts scalars and structs of them as soa elements.
+    void on_ranged_uint (const lexer::RangedUintType& /*unused*/) const { std::unreachable(); }
+    void on_fixed_string (const lexer::FixedStringType& /*unused*/) const { std::unreachable(); }
+    void on_string (const lexer::StringType& /*unused*/) const { std::unreachable(); }
+    void on_vector (const lexer::VectorType& /*unused*/) const { std::unreachable(); }
+
+    void on_optional (const lexer::OptionalType& /*unused*/) const { std::unreachable(); }
+    void on_map (const lexer::MapType& /*unused*/) const { std::unreachable(); }
+    [[nodiscard]] result_t on_fixed_array (const lexer::ArrayType& /*unused*/) const { std::unreachable(); }
+    [[nodiscard]] result_t on_array (const lexer::ArrayType& /*unused*/) const { std::unreachable(); }
+    void on_fixed_variant (const lexer::FixedVariantType& /*unused*/) const { std::unreachable(); }
+    void on_packed_variant (const lexer::PackedVariantType& /*unused*/) const { std::unreachable(); }
+    void on_dynamic_variant (const lexer::DynamicVariantType& /*unused*/) const { std::unreachable(); }
+    void on_enum (const lexer::EnumDefinition& /*unused*/) const { std::unreachable(); }
+
+    void on_struct (const lexer::StructDefinition& struct_definition) const {
+        offsets_accessor.field_order->visit(struct_definition, [this](const lexer::StructField& field_data) -> const std::byte& {
+            const size_t name_size = name.size();
+            name.append("_").append(field_data.name);
+            const std::byte& next = field_data.type().visit(SoaColumnVisitor<std::byte, Code>{code, offsets_accessor, map_idx, name, length}).next_type;
+            name.resize(name_size);
+            return next;
+        });
+    }
+};
+
+/**
+ * Finds the key column of a sorted array that is not nested in another array. Each leaf of its elements is a column of
+ * length values, so the keys lie back to back. Replays the map indices like SoaColumnVisitor and gives up on anything
+ * but scalars and structs of them, key_offset then stays -1.
+ */
+template <typename NextType>
+struct SortKeyColumnVisitor {
+    using next_type_t = NextType;
+    using result_t = lexer::Type::VisitResult<next_type_t>;
+
+    const OffsetsAccessor& offsets_accessor;
+    uint16_t& map_idx;
+    std::string_view key;       // Only set for the fields of the element struct
+    uint64_t& key_offset;
+    bool& supported;
+
+    void on_scalar () const { map_idx++; }
+    void unsupported () const { supported = false; }
+
+    void on_bool     () const { on_scalar(); }
+    void on_uint8    () const { on_scalar(); }
+    void on_uint16   () const { on_scalar(); }
+    void on_uint32   () const { on_scalar(); }
+    void on_uint64   () const { on_scalar(); }
+    void on_int8     () const { on_scalar(); }
+    void on_int16    () const { on_scalar(); }
+    void on_int32    () const { on_scalar(); }
+    void on_int64    () const { on_scalar(); }
+    void on_float32  () const { on_scalar(); }
+    void on_float64  () const { on_scalar(); }
+
+    void on_ranged_uint (const lexer::RangedUintType& /*unused*/) const { unsupported(); }
+    void on_fixed_string (const lexer::FixedStringType& /*unused*/) const { unsupported(); }
+    void on_string (const lexer::StringType& /*unused*/) const { unsupported(); }
+    void on_vector (const lexer::VectorType& /*unused*/) const { unsupported(); }
+    void on_optional (const lexer::OptionalType& /*unused*/) const { unsupported(); }
+    void on_map (const lexer::MapType& /*unused*/) const { unsupported(); }
+    [[nodiscard]] result_t on_fixed_array (const lexer::ArrayType& array_type) const {
+        unsupported();
+        return result_t{array_type.inner_type().template skip<const next_type_t>()};
+    }
+    [[nodiscard]] result_t on_array (const lexer::ArrayType& array_type) const {
+        unsupported();
+        return result_t{array_type.inner_type().template skip<const next_type_t>()};
+    }
+    void on_fixed_variant (const lexer::FixedVariantType& /*unused*/) const { unsupported(); }
+    void on_packed_variant (const lexer::PackedVariantType& /*unused*/) const { unsupported(); }
+    void on_dynamic_variant (const lexer::DynamicVariantType& /*unused*/) const { unsupported(); }
+    void on_enum (const lexer::EnumDefinition& /*unused*/) const { unsupported(); }
+
+    void on_struct (const lexer::StructDefinition& struct_definition) const {
+        offsets_accessor.field_order->visit(struct_definition, [this](const lexer::StructField& field_data) -> const std::byte& {
+            if (supported && key_offset == static_cast<uint64_t>(-1) && !key.empty() && field_data.name == key) {
+                key_offset = offsets_accessor.fixed_offsets[offsets_accessor.idx_map[map_idx]].get_offset();
+            }
+            return field_data.type().visit(SortKeyColumnVisitor<std::byte>{offsets_accessor, map_idx, {}, key_offset, supported}).next_type;
+        });
+    }
+};
+
 template <typename NextTypeT, bool is_fixed, bool in_array, typename Args, typename BaseNameArg>
 struct TypeVisitor {
     constexpr TypeVisitor (
@@ -768,7 +2343,6 @@ struct TypeVisitor {
        
     }
 
-    [[nodiscard]] codegen::UnknownStructBase&& on_bool    (codegen::UnknownStructBase&& code) const { return on_simple<lexer::FIELD_TYPE::BOOL   , "bool"    >(std::move(code)); }
     [[nodiscard]] codegen::UnknownStructBase&& on_uint8   (codegen::UnknownStructBase&& code) const { return on_simple<lexer::FIELD_TYPE::UINT8  , "uint8_t" >(std::move(code)); }
     [[nodiscard]] codegen::UnknownStructBase&& on_uint16  (codegen::UnknownStructBase&& code) const { return on_simple<lexer::FIELD_TYPE::UINT16 , "uint16_t">(std::move(code)); }
     [[nodiscard]] codegen::UnknownStructBase&& on_uint32  (codegen::UnknownStructBase&& code) const { return on_simple<lexer::FIELD_TYPE::UINT32 , "uint32_t">(std::move(code)); }
@@ -780,6 +2354,289 @@ struct TypeVisitor {
     [[nodiscard]] codegen::UnknownStructBase&& on_float32 (codegen::UnknownStructBase&& code) const { return on_simple<lexer::FIELD_TYPE::FLOAT32, "float"   >(std::move(code)); }
     [[nodiscard]] codegen::UnknownStructBase&& on_float64 (codegen::UnknownStructBase&& code) const { return on_simple<lexer::FIELD_TYPE::FLOAT64, "double"  >(std::move(code)); }
 
+    /**
+     * Loads the whole word of a bit packed leaf and extracts it with shift and mask.
+     * The setter replaces the bits of the leaf and keeps the others of the word, a value outside [min, max] fails an
+     * assert and is cut to the bits of the leaf otherwise.
+     * With --atomic-accessors `load_` and `store_` go through a std::atomic_ref on the containing word, so leafs sharing
+     * it can be stored concurrently. Bools set or clear their bit with fetch_or and fetch_and, ranged integers replace
+     * their bits in a compare exchange loop.
+     */
+    [[nodiscard]] codegen::UnknownStructBase&& on_bit_leaf (codegen::UnknownStructBase&& code, const std::string_view value_type_str, const uint32_t min, const uint32_t max) const {
+        const auto [fixed_offset, bit_leaf] = offsets_accessor.next_bit_leaf();
+        // width is 1 to 64, shifting a 1 by 64 would be undefined.
+        const uint64_t mask = ~uint64_t{0} >> (64 - bit_leaf.width);
+        const std::string_view word_type_str = SizeTypeStrs::get(bit_leaf.word_size);
+        offsets_accessor.add_alternative_leaf(fixed_offset.get_offset(), bit_leaf.word_size.byte_size(), mask << bit_leaf.shift);
+        auto&& method = begin_accessor(std::move(code)
+            .method(value_type_str, get_name(additional_args)), additional_args)
+            .line("const ", word_type_str, " word = *reinterpret_cast<const ", word_type_str, "*>(base + ", fixed_offset.get_offset(), ");");
+        const bool is_flag = bit_leaf.width == 1 && min == 0;
+        auto&& with_getter = is_flag
+            ? std::move(method)
+                .line("return ((word >> ", uint16_t{bit_leaf.shift}, ") & 1) != 0;")
+                .end()
+            : std::move(method)
+                .line("return static_cast<", value_type_str, ">(", min, " + ((word >> ", uint16_t{bit_leaf.shift}, ") & ", mask, "ULL));")
+                .end();
+        auto&& set_method = std::move(with_getter)
+            .method("void", codegen::StringParts{"set_"_sl, get_name(additional_args)}, codegen::Args{codegen::StringParts{value_type_str, " value"_sl}})
+                .line(word_type_str, "& word = *reinterpret_cast<", word_type_str, "*>(base + ", fixed_offset.get_offset(), ");");
+        if (value_type_str != "bool") {
+            set_method = std::move(set_method)
+                .line("assert(static_cast<uint64_t>(value) - ", min, " <= ", max - min, ");");
+        }
+        codegen::UnknownStructBase&& with_setter = min == 0
+            ? std::move(set_method)
+                .line("word = static_cast<", word_type_str, ">((word & ~", mask << bit_leaf.shift, "ULL) | ((static_cast<uint64_t>(value) & ", mask, "ULL) << ", uint16_t{bit_leaf.shift}, "));")
+                .end()
+            : std::move(set_method)
+                .line("word = static_cast<", word_type_str, ">((word & ~", mask << bit_leaf.shift, "ULL) | (((static_cast<uint64_t>(value) - ", min, ") & ", mask, "ULL) << ", uint16_t{bit_leaf.shift}, "));")
+                .end();
+        if (!global::options::atomic_accessors) return std::move(with_setter);
+
+        constexpr auto order_arg = "std::memory_order order = std::memory_order_seq_cst"_sl;
+        auto&& load_method = std::move(with_setter)
+            .method(value_type_str, codegen::StringParts{"load_"_sl, get_name(additional_args)}, codegen::Args{order_arg})
+                .line("const ", word_type_str, " word = std::atomic_ref<", word_type_str, ">(*reinterpret_cast<", word_type_str, "*>(base + ", fixed_offset.get_offset(), ")).load(order);");
+        auto&& store_method = (is_flag
+            ? std::move(load_method)
+                .line("return ((word >> ", uint16_t{bit_leaf.shift}, ") & 1) != 0;")
+                .end()
+            : std::move(load_method)
+                .line("return static_cast<", value_type_str, ">(", min, " + ((word >> ", uint16_t{bit_leaf.shift}, ") & ", mask, "ULL));")
+                .end())
+            .method("void", codegen::StringParts{"store_"_sl, get_name(additional_args)}, codegen::Args{codegen::StringParts{value_type_str, " value"_sl}, order_arg})
+                .line("std::atomic_ref<", word_type_str, "> word (*reinterpret_cast<", word_type_str, "*>(base + ", fixed_offset.get_offset(), "));");
+        if (value_type_str == "bool") {
+            return std::move(store_method)
+                .line("if (value) word.fetch_or(static_cast<", word_type_str, ">(", uint64_t{1} << bit_leaf.shift, "ULL), order);")
+                .line("else word.fetch_and(static_cast<", word_type_str, ">(~", uint64_t{1} << bit_leaf.shift, "ULL), order);")
+                .end();
+        }
+        return std::move(store_method)
+            .line("assert(static_cast<uint64_t>(value) - ", min, " <= ", max - min, ");")
+            .line("const uint64_t bits = ((static_cast<uint64_t>(value) - ", min, ") & ", mask, "ULL) << ", uint16_t{bit_leaf.shift}, ";")
+            .line(word_type_str, " expected = word.load(std::memory_order_relaxed);")
+            .line("while (!word.compare_exchange_weak(expected, static_cast<", word_type_str, ">((expected & ~", mask << bit_leaf.shift, "ULL) | bits), order, std::memory_order_relaxed)) {}")
+            .end();
+    }
+
+    [[nodiscard]] codegen::UnknownStructBase&& on_bool (codegen::UnknownStructBase&& code) const {
+        if constexpr (!in_array) {
+            if (offsets_accessor.next_is_bit_leaf()) {
+                return on_bit_leaf(std::move(code), "bool", 0, 1);
+            }
+        }
+        return on_simple<lexer::FIELD_TYPE::BOOL, "bool">(std::move(code));
+    }
+
+    [[nodiscard]] codegen::UnknownStructBase&& on_ranged_uint (const lexer::RangedUintType& ranged_uint_type, codegen::UnknownStructBase&& code) const {
+        if constexpr (in_array) {
+            error_exit("Ranged integers are only supported outside of arrays and variants");
+        } else {
+            return on_bit_leaf(std::move(code), SizeTypeStrs::get(ranged_uint_type.value_size()), ranged_uint_type.min, ranged_uint_type.max);
+        }
+    }
+
+    /**
+     * The value of an optional is stored behind the values of bigger size and the present values of the same size
+     * declared before it, so its offset takes one popcount of the presence word per value size. The lexer only accepts
+     * scalar values, a value of variable size would need its size leaf to be optional too. Optionals of the top level
+     * are set and cleared through the Editor, which moves the bytes behind the value.
+     */
+    [[nodiscard]] codegen::UnknownStructBase&& on_optional (const lexer::OptionalType& optional_type, codegen::UnknownStructBase&& code) const {
+        if constexpr (in_array || !std::is_same_v<std::remove_cvref_t<Args>, GenStructLeafArgs>) {
+            error_exit("Optionals are only supported outside of arrays and variants");
+        } else {
+            const std::string_view value_type_str = scalar_type_name(optional_type.value_type);
+            const layout::PresenceMasks& preceding = offsets_accessor.optional_leafs->preceding[*offsets_accessor.current_map_idx];
+            const auto [fixed_offset, bit_leaf] = offsets_accessor.next_bit_leaf();
+            const std::string_view word_type_str = SizeTypeStrs::get(bit_leaf.word_size);
+            if (offsets_accessor.resizable_optionals != nullptr) {
+                offsets_accessor.resizable_optionals->push_back({
+                    get_name(additional_args),
+                    value_type_str,
+                    optional_type.value_size,
+                    fixed_offset.get_offset(),
+                    bit_leaf,
+                    preceding
+                });
+            }
+
+            auto&& value_method = begin_accessor(std::move(code)
+                .method(value_type_str, get_name(additional_args)), additional_args);
+            if (preceding.empty()) {
+                value_method = std::move(value_method)
+                    .line("return *reinterpret_cast<const ", value_type_str, "*>(base + ", offsets_accessor.optional_values_start_code(), ");");
+            } else {
+                value_method = std::move(value_method)
+                    .line("const uint64_t presence = *reinterpret_cast<const ", word_type_str, "*>(base + ", fixed_offset.get_offset(), ");")
+                    .line("return *reinterpret_cast<const ", value_type_str, "*>(base + ", offsets_accessor.optional_values_start_code(), PresencePopcountCodeGenerator{preceding}, ");");
+            }
+
+            return std::move(value_method)
+                .end()
+                .method("bool", codegen::StringParts{"has_"_sl, get_name(additional_args)})
+                    .line("return ((*reinterpret_cast<const ", word_type_str, "*>(base + ", fixed_offset.get_offset(), ") >> ", uint16_t{bit_leaf.shift}, ") & 1) != 0;")
+                .end();
+        }
+    }
+
+    /**
+     * Maps are open addressing tables with linear probing over groups of 8 slots. A used slot has the tag 0x80 | the top
+     * 7 bits of the hash, an empty one 0. The tags of a group are compared at once in one little endian word, a group
+     * with an empty slot ends the probe sequence. insert() overwrites the value of a present key or takes the first
+     * empty slot of the probe sequence, there are no deletions, so find() never stops before a present key.
+     */
+    [[nodiscard]] codegen::UnknownStructBase&& on_map (const lexer::MapType& map_type, codegen::UnknownStructBase&& code) const {
+        if constexpr (in_array || !std::is_same_v<std::remove_cvref_t<Args>, GenStructLeafArgs>) {
+            error_exit("Maps are only supported outside of arrays and variants");
+        } else {
+            const bool string_keys = map_type.key_type == lexer::FIELD_TYPE::STRING_FIXED;
+            const std::string_view key_type_str = string_keys ? "std::string_view" : scalar_type_name(map_type.key_type);
+            const std::string_view key_element_str = string_keys ? "char" : key_type_str;
+            const std::string_view value_type_str = scalar_type_name(map_type.value_type);
+            const uint32_t slot_count = map_type.slot_count;
+            const uint32_t group_count = slot_count / lexer::MapType::group_size;
+            const uint16_t key_length = map_type.key_byte_size;
+            const uint64_t keys_offset = offsets_accessor.next_fixed_offset();
+            const uint64_t values_offset = keys_offset + (uint64_t{slot_count} * key_length);
+            const uint64_t tags_offset = values_offset + (uint64_t{slot_count} * map_type.value_size.byte_size());
+
+            const ArrayCtorStrs array_ctor_strs = ArrayCtorStrs::make(0);
+
+            auto unique_name = get_unique_name(additional_args);
+
+            auto&& hash_method = std::move(code)
+                ._struct(unique_name)
+                .ctor(array_ctor_strs.ctor_args, array_ctor_strs.ctor_inits).end()
+                .method(codegen::Attributes{"static", "constexpr"}, "uint32_t", "capacity")
+                    .line("return ", map_type.capacity, ";")
+                .end()
+                .method(codegen::Attributes{"static", "constexpr"}, "uint32_t", "slot_count")
+                    .line("return ", slot_count, ";")
+                .end()
+                .method(codegen::Attributes{"static", "constexpr"}, "uint64_t", "hash", codegen::Args{codegen::StringParts{key_type_str, " key"_sl}});
+            // String keys are hashed with FNV-1a, the final multiply spreads the bytes into the bits tag and group use.
+            if (string_keys) {
+                hash_method = std::move(hash_method)
+                    .line("uint64_t key_hash = 0xCBF29CE484222325ULL;")
+                    .line("for (const char c : key) key_hash = (key_hash ^ static_cast<uint8_t>(c)) * 0x100000001B3ULL;")
+                    .line("return key_hash * 0x9E3779B97F4A7C15ULL;");
+            } else {
+                hash_method = std::move(hash_method)
+                    .line("return static_cast<uint64_t>(key) * 0x9E3779B97F4A7C15ULL;");
+            }
+
+            auto&& find_method = std::move(hash_method)
+                .end()
+                .method(codegen::Attributes{"static", "constexpr"}, "uint8_t", "tag", codegen::Args{"uint64_t hash"})
+                    .line("return static_cast<uint8_t>(0x80 | (hash >> 57));")
+                .end()
+                .method(codegen::Attributes{"static", "constexpr"}, "uint32_t", "group", codegen::Args{"uint64_t hash"})
+                    .line("return static_cast<uint32_t>(hash >> 32) & ", group_count - 1, ";")
+                .end()
+                .method(codegen::StringParts{"const "_sl, value_type_str, "*"_sl}, "find", codegen::Args{codegen::StringParts{key_type_str, " key"_sl}});
+            if (string_keys) {
+                find_method = std::move(find_method)
+                    ._if(codegen::StringParts{"key.size() > "_sl, key_length})
+                        .line("return nullptr;")
+                    .end();
+            }
+            find_method = std::move(find_method)
+                .line("const uint64_t key_hash = hash(key);")
+                .line("const uint64_t tag_pattern = uint64_t{tag(key_hash)} * 0x0101010101010101ULL;")
+                .line("const ", key_element_str, "* keys = reinterpret_cast<const ", key_element_str, "*>(base + ", keys_offset, ");")
+                .line("uint32_t g = group(key_hash);");
+
+            auto&& probe_loop = std::move(find_method)
+                ._for("uint32_t probes = 0; probes < ", group_count, "; probes++")
+                    .line("uint64_t tags;")
+                    .line("std::memcpy(&tags, reinterpret_cast<const void*>(base + ", tags_offset, " + (g * 8)), sizeof(tags));")
+                    .line("const uint64_t diff = tags ^ tag_pattern;")
+                    .line("uint64_t matches = (diff - 0x0101010101010101ULL) & ~diff & 0x8080808080808080ULL;")
+                    ._while("matches != 0")
+                        .line("const uint32_t slot = (g * 8) + (static_cast<uint32_t>(std::countr_zero(matches)) / 8);");
+            if (string_keys) {
+                probe_loop = std::move(probe_loop)
+                        .line("const char* const slot_key = keys + (slot * ", key_length, ");")
+                        .line("if (std::memcmp(slot_key, key.data(), key.size()) == 0 && (key.size() == ", key_length, " || slot_key[key.size()] == '\\0')) return reinterpret_cast<const ", value_type_str, "*>(base + ", values_offset, ") + slot;");
+            } else {
+                probe_loop = std::move(probe_loop)
+                        .line("if (keys[slot] == key) return reinterpret_cast<const ", value_type_str, "*>(base + ", values_offset, ") + slot;");
+            }
+
+            auto&& insert_method = std::move(probe_loop)
+                            .line("matches &= matches - 1;")
+                        .end()
+                        .line("if (((tags - 0x0101010101010101ULL) & ~tags & 0x8080808080808080ULL) != 0) return nullptr;")
+                        .line("g = (g + 1) & ", group_count - 1, ";")
+                    .end()
+                    .line("return nullptr;")
+                    .end()
+                    .method("bool", "contains", codegen::Args{codegen::StringParts{key_type_str, " key"_sl}})
+                        .line("return find(key) != nullptr;")
+                    .end()
+                    .method("bool", "insert", codegen::Args{codegen::StringParts{key_type_str, " key"_sl}, codegen::StringParts{value_type_str, " value"_sl}})
+                        ._if(codegen::StringParts{"const "_sl, value_type_str, "* const existing = find(key); existing != nullptr"_sl})
+                            .line("reinterpret_cast<", value_type_str, "*>(base + ", values_offset, ")[existing - reinterpret_cast<const ", value_type_str, "*>(base + ", values_offset, ")] = value;")
+                            .line("return true;")
+                        .end();
+            if (string_keys) {
+                insert_method = std::move(insert_method)
+                        .line("if (key.size() > ", key_length, ") return false;");
+            }
+
+            auto&& empty_slot = std::move(insert_method)
+                        .line("if (size() >= ", map_type.capacity, ") return false;")
+                        .line("const uint64_t key_hash = hash(key);")
+                        .line("uint32_t g = group(key_hash);")
+                        ._for("uint32_t probes = 0; probes < ", group_count, "; probes++")
+                            .line("uint64_t tags;")
+                            .line("std::memcpy(&tags, reinterpret_cast<const void*>(base + ", tags_offset, " + (g * 8)), sizeof(tags));")
+                            .line("const uint64_t empty = (tags - 0x0101010101010101ULL) & ~tags & 0x8080808080808080ULL;")
+                            ._if("empty != 0")
+                                .line("const uint32_t slot = (g * 8) + (static_cast<uint32_t>(std::countr_zero(empty)) / 8);");
+            if (string_keys) {
+                empty_slot = std::move(empty_slot)
+                                .line("char* const slot_key = reinterpret_cast<char*>(base + ", keys_offset, ") + (slot * ", key_length, ");")
+                                .line("std::memcpy(slot_key, key.data(), key.size());")
+                                .line("std::memset(slot_key + key.size(), 0, ", key_length, " - key.size());");
+            } else {
+                empty_slot = std::move(empty_slot)
+                                .line("reinterpret_cast<", key_type_str, "*>(base + ", keys_offset, ")[slot] = key;");
+            }
+
+            return gen_field_access_method_no_array(
+                std::move(empty_slot)
+                                .line("reinterpret_cast<", value_type_str, "*>(base + ", values_offset, ")[slot] = value;")
+                                .line("*reinterpret_cast<uint8_t*>(base + ", tags_offset, " + slot) = tag(key_hash);")
+                                .line("return true;")
+                            .end()
+                            .line("g = (g + 1) & ", group_count - 1, ";")
+                        .end()
+                        .line("return false;")
+                    .end()
+                    .method("uint32_t", "size")
+                        .line("uint32_t count = 0;")
+                        ._for("uint32_t g = 0; g < ", group_count, "; g++")
+                            .line("uint64_t tags;")
+                            .line("std::memcpy(&tags, reinterpret_cast<const void*>(base + ", tags_offset, " + (g * 8)), sizeof(tags));")
+                            .line("count += static_cast<uint32_t>(std::popcount(tags & 0x8080808080808080ULL));")
+                        .end()
+                        .line("return count;")
+                    .end()
+                    ._private()
+                    .field("size_t", "base")
+                    .end(),
+                additional_args,
+                array_ctor_strs.ctor_used,
+                unique_name
+            );
+        }
+    }
+
     [[nodiscard]] codegen::UnknownStructBase&& on_fixed_string (const lexer::FixedStringType& fixed_string_type, codegen::UnknownStructBase&& code) const {
         const uint32_t length = fixed_string_type.length;
         const std::string_view size_type_str =  SizeTypeStrs::get(fixed_string_type.length_size);
@@ -832,6 +2689,35 @@ struct TypeVisitor {
         }
     }
 
+    /**
+     * The vector offset is a multiple of its alignment from the start of the message, which raises the alignment of the
+     * message to it. The pointers are aligned as long as base is aligned to T::alignment, which the Decoder, the Editor,
+     * the Seqlock and the stream and ring runtimes keep for the messages they hold. data_<name>() is the pointer to
+     * write the elements through.
+     * SIZE and the leaf counts stop at 8 bytes, so only the top level, which places a vector right away, can align it
+     * further. Vectors in arrays and variants are rejected.
+     */
+    [[nodiscard]] codegen::UnknownStructBase&& on_vector (const lexer::VectorType& vector_type, codegen::UnknownStructBase&& code) const {
+        if constexpr (in_array || !std::is_same_v<std::remove_cvref_t<Args>, GenStructLeafArgs>) {
+            error_exit("Vectors are only supported outside of arrays and variants, only the top level aligns them beyond 8 bytes");
+        } else {
+            const std::string_view element_type_str = scalar_type_name(vector_type.element_type);
+            const uint64_t offset = offsets_accessor.next_fixed_offset();
+            uint16_t& message_alignment = *offsets_accessor.message_alignment;
+            message_alignment = std::max<uint16_t>(message_alignment, vector_type.alignment);
+            return begin_accessor(std::move(code)
+                .method(codegen::StringParts{"const "_sl, element_type_str, "*"_sl}, get_name(additional_args)), additional_args)
+                    .line("return std::assume_aligned<", uint16_t{vector_type.alignment}, ">(reinterpret_cast<const ", element_type_str, "*>(base + ", offset, "));")
+                .end()
+                .method(codegen::StringParts{element_type_str, "*"_sl}, codegen::StringParts{"data_"_sl, get_name(additional_args)})
+                    .line("return std::assume_aligned<", uint16_t{vector_type.alignment}, ">(reinterpret_cast<", element_type_str, "*>(base + ", offset, "));")
+                .end()
+                .method(codegen::Attributes{"static", "constexpr"}, "uint16_t", codegen::StringParts{get_name(additional_args), "_length"_sl})
+                    .line("return ", vector_type.length, ";")
+                .end();
+        }
+    }
+
     [[nodiscard]] codegen::UnknownStructBase on_string (const lexer::StringType& string_type, codegen::UnknownStructBase&& code) const {
         if constexpr (in_array) {
             error_exit("Variable length strings in arrays are not supported");
@@ -855,10 +2741,10 @@ struct TypeVisitor {
 
             if (size_chain.empty()) {
                 string_data_method = std::move(string_data_method)
-                    .line("return reinterpret_cast<const char*>(base + ", offsets_accessor.var_leafs_start, ");");
+                    .line("return reinterpret_cast<const char*>(base + ", offsets_accessor.var_leafs_start_code(), ");");
             } else {
                 string_data_method = std::move(string_data_method)
-                    .line("return reinterpret_cast<const char*>(base + ", offsets_accessor.var_leafs_start, SizeChainCodeGenerator{size_chain}, ");");
+                    .line("return reinterpret_cast<const char*>(base + ", offsets_accessor.var_leafs_start_code(), SizeChainCodeGenerator{size_chain}, ");");
             }
 
             auto&& string_size_method = std::move(string_data_method)
@@ -874,10 +2760,16 @@ struct TypeVisitor {
                     string_type.min_length,
                     offsets_accessor.next_map_idx(),
                     size_size,
-                    stored_size_size
+                    stored_size_size,
+                    string_type.max_length
                 };
                 string_size_method = std::move(string_size_method)
                     .line("return size", size_leaf_idx, "(base);");
+                if constexpr (std::is_same_v<Args, GenStructLeafArgs>) {
+                    if (offsets_accessor.resizable_leafs != nullptr) {
+                        offsets_accessor.resizable_leafs->push_back({additional_args.name, size_leaf_idx, string_type.max_length, size_chain});
+                    }
+                }
             }
 
             return gen_field_access_method_no_array(
@@ -896,7 +2788,163 @@ struct TypeVisitor {
         }
     }
 
+    /**
+     * Encoded arrays store the reference value followed by the narrow differences. Delta encoded elements are a prefix
+     * sum, decode() widens 8 differences at once into a vector register and sums them in three shift and add steps
+     * before adding the carry. The vector extensions of GCC and Clang keep the header free of target intrinsics.
+     * encode() writes all elements at once and returns false without writing if a difference does not fit the narrow
+     * type, delta encoded elements have to be non decreasing.
+     */
+    [[nodiscard]] result_t on_encoded_array (const lexer::ArrayType& array_type, codegen::UnknownStructBase&& code) const {
+        if constexpr (in_array || !std::is_same_v<std::remove_cvref_t<Args>, GenStructLeafArgs>) {
+            error_exit("Delta and frame of reference encoded arrays are only supported outside of arrays and variants");
+        } else {
+            const uint32_t length = array_type.length;
+            const std::string_view size_type_str = SizeTypeStrs::get(array_type.size_size);
+            const std::string_view element_type_str = scalar_type_name(array_type.element_type);
+            const std::string_view narrow_type_str = SizeTypeStrs::get(array_type.narrow_size);
+            const uint64_t offset = offsets_accessor.next_fixed_offset();
+            const uint64_t narrow_offset = offset + array_type.element_size.byte_size();
+            const std::string_view unsigned_type_str = SizeTypeStrs::get(array_type.element_size);
+            const uint64_t narrow_max = (uint64_t{1} << (array_type.narrow_size.byte_size() * 8)) - 1;
+
+            const ArrayCtorStrs array_ctor_strs = ArrayCtorStrs::make(0);
+
+            auto unique_name = get_unique_name(additional_args);
+
+            auto&& iterator_struct = std::move(code)
+                ._struct(unique_name)
+                .ctor(array_ctor_strs.ctor_args, array_ctor_strs.ctor_inits).end()
+                ._struct("iterator")
+                .ctor(
+                    codegen::StringParts{"const "_sl, narrow_type_str, "* narrow, "_sl, element_type_str, " value, uint32_t idx"_sl},
+                    "narrow(narrow), value(value), idx(idx)"
+                ).end();
+
+            if (array_type.encoding == lexer::ARRAY_ENCODING::DELTA) {
+                iterator_struct = std::move(iterator_struct)
+                    .method(element_type_str, "operator*")
+                        .line("return value;")
+                    .end()
+                    .method("iterator&", "operator++")
+                        .line("if (++idx < ", length, ") value = static_cast<", element_type_str, ">(value + narrow[idx - 1]);")
+                        .line("return *this;")
+                    .end();
+            } else {
+                iterator_struct = std::move(iterator_struct)
+                    .method(element_type_str, "operator*")
+                        .line("return static_cast<", element_type_str, ">(value + narrow[idx]);")
+                    .end()
+                    .method("iterator&", "operator++")
+                        .line("++idx;")
+                        .line("return *this;")
+                    .end();
+            }
+
+            auto&& array_struct = std::move(iterator_struct)
+                .method("bool", "operator!=", codegen::Args{"const iterator& other"})
+                    .line("return idx != other.idx;")
+                .end()
+                ._private()
+                .field(codegen::StringParts{"const "_sl, narrow_type_str, "*"_sl}, "narrow")
+                .field(element_type_str, "value")
+                .field("uint32_t", "idx")
+                .end()
+                .method(codegen::Attributes{"constexpr"}, size_type_str, "length")
+                    .line("return ", length, ";")
+                .end();
+
+            if (array_type.encoding == lexer::ARRAY_ENCODING::DELTA) {
+                array_struct = std::move(array_struct)
+                    .method(element_type_str, "get", codegen::Args{"uint32_t idx"})
+                        .line("const ", narrow_type_str, "* narrow = reinterpret_cast<const ", narrow_type_str, "*>(base + ", narrow_offset, ");")
+                        .line(element_type_str, " value = *reinterpret_cast<const ", element_type_str, "*>(base + ", offset, ");")
+                        .line("for (uint32_t i = 0; i < idx; i++) value = static_cast<", element_type_str, ">(value + narrow[i]);")
+                        .line("return value;")
+                    .end()
+                    .method("void", "decode", codegen::Args{codegen::StringParts{element_type_str, "* out"_sl}})
+                        .line("typedef ", element_type_str, " block_t __attribute__((vector_size(8 * sizeof(", element_type_str, "))));")
+                        .line("typedef ", narrow_type_str, " narrow_block_t __attribute__((vector_size(8 * sizeof(", narrow_type_str, "))));")
+                        .line("const ", narrow_type_str, "* narrow = reinterpret_cast<const ", narrow_type_str, "*>(base + ", narrow_offset, ");")
+                        .line(element_type_str, " carry = *reinterpret_cast<const ", element_type_str, "*>(base + ", offset, ");")
+                        .line("out[0] = carry;")
+                        .line("uint32_t i = 1;")
+                        ._for("; i + 8 <= ", length, "; i += 8")
+                            .line("narrow_block_t narrow_block;")
+                            .line("std::memcpy(&narrow_block, narrow + i - 1, sizeof(narrow_block));")
+                            .line("block_t block = __builtin_convertvector(narrow_block, block_t);")
+                            .line("const block_t zero {};")
+                            .line("block += __builtin_shufflevector(block, zero, 8, 0, 1, 2, 3, 4, 5, 6);")
+                            .line("block += __builtin_shufflevector(block, zero, 8, 8, 0, 1, 2, 3, 4, 5);")
+                            .line("block += __builtin_shufflevector(block, zero, 8, 8, 8, 8, 0, 1, 2, 3);")
+                            .line("block += carry;")
+                            .line("std::memcpy(out + i, &block, sizeof(block));")
+                            .line("carry = block[7];")
+                        .end()
+                        .line("for (; i < ", length, "; i++) out[i] = carry = static_cast<", element_type_str, ">(carry + narrow[i - 1]);")
+                    .end()
+                    .method("bool", "encode", codegen::Args{codegen::StringParts{"const "_sl, element_type_str, "* values"_sl}})
+                        ._for("uint32_t i = 1; i < ", length, "; i++")
+                            .line("if (values[i] < values[i - 1]) return false;")
+                            .line("if (static_cast<", unsigned_type_str, ">(static_cast<", unsigned_type_str, ">(values[i]) - static_cast<", unsigned_type_str, ">(values[i - 1])) > ", narrow_max, ") return false;")
+                        .end()
+                        .line("*reinterpret_cast<", element_type_str, "*>(base + ", offset, ") = values[0];")
+                        .line(narrow_type_str, "* narrow = reinterpret_cast<", narrow_type_str, "*>(base + ", narrow_offset, ");")
+                        .line("for (uint32_t i = 1; i < ", length, "; i++) narrow[i - 1] = static_cast<", narrow_type_str, ">(static_cast<", unsigned_type_str, ">(values[i]) - static_cast<", unsigned_type_str, ">(values[i - 1]));")
+                        .line("return true;")
+                    .end();
+            } else {
+                array_struct = std::move(array_struct)
+                    .method(element_type_str, "get", codegen::Args{"uint32_t idx"})
+                        .line("const ", narrow_type_str, "* narrow = reinterpret_cast<const ", narrow_type_str, "*>(base + ", narrow_offset, ");")
+                        .line("return static_cast<", element_type_str, ">(*reinterpret_cast<const ", element_type_str, "*>(base + ", offset, ") + narrow[idx]);")
+                    .end()
+                    .method("void", "decode", codegen::Args{codegen::StringParts{element_type_str, "* out"_sl}})
+                        .line("const ", narrow_type_str, "* narrow = reinterpret_cast<const ", narrow_type_str, "*>(base + ", narrow_offset, ");")
+                        .line("const ", element_type_str, " reference = *reinterpret_cast<const ", element_type_str, "*>(base + ", offset, ");")
+                        .line("for (uint32_t i = 0; i < ", length, "; i++) out[i] = static_cast<", element_type_str, ">(reference + narrow[i]);")
+                    .end()
+                    .method("bool", "encode", codegen::Args{codegen::StringParts{"const "_sl, element_type_str, "* values"_sl}})
+                        .line(element_type_str, " reference = values[0];")
+                        .line("for (uint32_t i = 1; i < ", length, "; i++) if (values[i] < reference) reference = values[i];")
+                        ._for("uint32_t i = 0; i < ", length, "; i++")
+                            .line("if (static_cast<", unsigned_type_str, ">(static_cast<", unsigned_type_str, ">(values[i]) - static_cast<", unsigned_type_str, ">(reference)) > ", narrow_max, ") return false;")
+                        .end()
+                        .line("*reinterpret_cast<", element_type_str, "*>(base + ", offset, ") = reference;")
+                        .line(narrow_type_str, "* narrow = reinterpret_cast<", narrow_type_str, "*>(base + ", narrow_offset, ");")
+                        .line("for (uint32_t i = 0; i < ", length, "; i++) narrow[i] = static_cast<", narrow_type_str, ">(static_cast<", unsigned_type_str, ">(values[i]) - static_cast<", unsigned_type_str, ">(reference));")
+                        .line("return true;")
+                    .end();
+            }
+
+            code = gen_field_access_method_no_array(
+                std::move(array_struct)
+                    .method("iterator", "begin")
+                        .line("return {reinterpret_cast<const ", narrow_type_str, "*>(base + ", narrow_offset, "), *reinterpret_cast<const ", element_type_str, "*>(base + ", offset, "), 0};")
+                    .end()
+                    .method("iterator", "end")
+                        .line("return {nullptr, 0, ", length, "};")
+                    .end()
+                    ._private()
+                    .field("size_t", "base")
+                    .end(),
+                additional_args,
+                array_ctor_strs.ctor_used,
+                unique_name
+            );
+
+            return {
+                array_type.inner_type().template skip<const next_type_t>(),
+                std::move(code)
+            };
+        }
+    }
+
     [[nodiscard]] result_t on_fixed_array (const lexer::ArrayType& fixed_array_type, codegen::UnknownStructBase&& code) const {
+        if (fixed_array_type.encoding != lexer::ARRAY_ENCODING::NONE) {
+            return on_encoded_array(fixed_array_type, std::move(code));
+        }
+
         const uint32_t length = fixed_array_type.length;
         const std::string_view size_type_str = SizeTypeStrs::get(fixed_array_type.size_size);
 
@@ -912,6 +2960,8 @@ struct TypeVisitor {
         }();
 
         auto unique_name = get_unique_name(additional_args, [depth]() { return codegen::StringParts{"Array_", depth}; });
+        const uint16_t element_map_idx_begin = *offsets_accessor.current_map_idx;
+        const auto report_scope = layout::LayoutReport::enter_element(offsets_accessor.layout_report);
         result_t result = fixed_array_type.inner_type().visit(
             TypeVisitor<
                 next_type_t,
@@ -937,7 +2987,38 @@ struct TypeVisitor {
         auto&& array_struct = std::move(result.value).template as<codegen::NestedStruct<codegen::UnknownStructBase>>()
             .method(codegen::Attributes{"constexpr"}, size_type_str, "length")
                 .line("return ", length, ";")
-            .end()
+            .end();
+
+        if (fixed_array_type.soa) {
+            std::string column_name;
+            uint16_t column_map_idx = element_map_idx_begin;
+            std::ignore = fixed_array_type.inner_type().visit(SoaColumnVisitor<lexer::Type, std::remove_reference_t<decltype(array_struct)>>{
+                array_struct,
+                offsets_accessor,
+                column_map_idx,
+                column_name,
+                length
+            });
+        }
+
+        if (!fixed_array_type.sort_key.empty()) {
+            uint64_t key_column_offset = static_cast<uint64_t>(-1);
+            if (fixed_array_type.eytzinger && array_depth == 0) {
+                uint16_t key_map_idx = element_map_idx_begin;
+                bool supported = true;
+                std::ignore = fixed_array_type.inner_type().visit(SortKeyColumnVisitor<lexer::Type>{
+                    offsets_accessor,
+                    key_map_idx,
+                    fixed_array_type.sort_key,
+                    key_column_offset,
+                    supported
+                });
+                if (!supported) key_column_offset = static_cast<uint64_t>(-1);
+            }
+            array_struct = add_sorted_search(std::move(array_struct), fixed_array_type, key_column_offset);
+        }
+
+        array_struct = std::move(array_struct)
             ._private()
             .field("size_t", "base");
 
@@ -984,6 +3065,7 @@ struct TypeVisitor {
 
             auto unique_name = get_unique_name(additional_args);
 
+            const auto report_scope = layout::LayoutReport::enter_element(offsets_accessor.layout_report);
             result_t result = array_type.inner_type().visit(
                 TypeVisitor<
                     next_type_t,
@@ -1013,7 +3095,8 @@ struct TypeVisitor {
                 array_type.length,
                 offsets_accessor.next_map_idx(),
                 size_size,
-                stored_size_size
+                stored_size_size,
+                array_type.max_byte_size
             };
 
             auto&& array_struct = std::move(result.value).template as<codegen::NestedStruct<codegen::UnknownStructBase>>()
@@ -1049,7 +3132,21 @@ struct TypeVisitor {
         ._struct(unique_name)
             .ctor(array_ctor_strs.ctor_args, array_ctor_strs.ctor_inits).end();
 
-        if (variant_count <= UINT8_MAX) {
+        // Variants sharing their storage read the one id of their group, their own ids follow the first id of theirs.
+        const uint16_t shared_id_base = offsets_accessor.next_shared_id_base();
+        const bool is_shared = shared_id_base != static_cast<uint16_t>(-1);
+        if (is_shared) {
+            variant_struct = gen_value_leaf<is_fixed, false, in_array, "uint8_t", SIZE::SIZE_1>(std::move(variant_struct), offsets_accessor, "group_id"_sl, pack_info_idx, array_depth)
+                .method("uint8_t", "id")
+                    .line("return static_cast<uint8_t>(group_id() - ", shared_id_base, ");")
+                .end()
+                .method("bool", "is_live")
+                    .line("return static_cast<uint8_t>(group_id() - ", shared_id_base, ") < ", variant_count, ";")
+                .end()
+                .method("void", "set_id", codegen::Args{"uint8_t id"})
+                    .line("set_group_id(static_cast<uint8_t>(", shared_id_base, " + id));")
+                .end();
+        } else if (variant_count <= UINT8_MAX) {
             variant_struct = gen_value_leaf<is_fixed, false, in_array, "uint8_t", SIZE::SIZE_1>(std::move(variant_struct), offsets_accessor, "id"_sl, pack_info_idx, array_depth);
         } else {
             variant_struct = gen_value_leaf<is_fixed, false, in_array, "uint16_t", SIZE::SIZE_2>(std::move(variant_struct), offsets_accessor, "id"_sl, pack_info_idx, array_depth);
@@ -1066,6 +3163,12 @@ struct TypeVisitor {
         }();
         
         for (uint16_t i = 0; i < variant_count; i++) {            
+            const auto report_scope = layout::LayoutReport::enter(offsets_accessor.layout_report, "as_", i);
+            AlternativeLeafs alternative_leafs;
+            OffsetsAccessor alternative_accessor = offsets_accessor;
+            alternative_accessor.alternative_leafs = &alternative_leafs;
+            alternative_accessor.resizable_leafs = nullptr;
+            alternative_accessor.resizable_optionals = nullptr;
             lexer::Type::VisitResult<lexer::Type, codegen::UnknownStructBase&&> result = type->visit(TypeVisitor<
                 lexer::Type,
                 is_fixed,
@@ -1074,20 +3177,32 @@ struct TypeVisitor {
                 decltype(estd::conditionally<is_dynamic_variant_element<Args>>(unique_name, base_name))
             >{
                 estd::conditionally<is_dynamic_variant_element<Args>>(unique_name, base_name),
-                offsets_accessor,
+                alternative_accessor,
                 std::span<SizeLeaf>{},
                 current_size_leaf_idx,
                 GenFixedVariantLeafArgs{
-                    {i, variant_depth}
+                    {i, variant_depth},
+                    is_shared ? static_cast<uint16_t>(shared_id_base + i) : GenFixedVariantLeafArgs::no_group_id
                 },
                 array_depth,
                 AlignSizes::zero()
             }, std::move(variant_struct).template as<codegen::UnknownStructBase>());
 
             type = &result.next_type;
-            variant_struct = std::move(result.value).template as<codegen::NestedStruct<codegen::UnknownStructBase>>();
+            if constexpr (is_fixed) {
+                variant_struct = add_emplace(std::move(result.value), alternative_leafs, i).template as<codegen::NestedStruct<codegen::UnknownStructBase>>();
+            } else {
+                variant_struct = std::move(result.value).template as<codegen::NestedStruct<codegen::UnknownStructBase>>();
+            }
+
+            // A variant inside an alternative belongs to the leafs of the outer alternative too.
+            if (offsets_accessor.alternative_leafs != nullptr) {
+                std::vector<AlternativeLeafs::Leaf>& outer_leafs = offsets_accessor.alternative_leafs->leafs;
+                outer_leafs.insert(outer_leafs.end(), alternative_leafs.leafs.begin(), alternative_leafs.leafs.end());
+                offsets_accessor.alternative_leafs->in_array |= alternative_leafs.in_array;
+            }
         }
-        
+
         variant_struct = std::move(variant_struct)
         ._private()
         .field("size_t", "base");
@@ -1147,7 +3262,8 @@ struct TypeVisitor {
                 dynamic_variant_type.min_byte_size,
                 offsets_accessor.next_map_idx(),
                 dynamic_variant_type.size_size,
-                dynamic_variant_type.stored_size_size
+                dynamic_variant_type.stored_size_size,
+                dynamic_variant_type.max_byte_size
             };
 
             const auto size_chain = offsets_accessor.next_var_offset();
@@ -1182,6 +3298,7 @@ struct TypeVisitor {
                 const auto level_size_leafs_count = type_meta.level_size_leafs;
 
                 uint16_t current_size_leaf_idx = 0;
+                const auto report_scope = layout::LayoutReport::enter(offsets_accessor.layout_report, "as_", i);
                 lexer::Type::VisitResult<lexer::Type, codegen::UnknownStructBase&&> result = type->visit(TypeVisitor<
                     lexer::Type,
                     true,
@@ -1242,7 +3359,12 @@ struct TypeVisitor {
         ._struct(unique_name)
             .ctor(array_ctor_strs.ctor_args, array_ctor_strs.ctor_inits).end();
 
-        struct_definition.visit([&](const lexer::StructField& field_data) -> const std::byte& {
+        OffsetsAccessor field_accessor = offsets_accessor;
+        field_accessor.resizable_leafs = nullptr;
+        field_accessor.resizable_optionals = nullptr;
+
+        offsets_accessor.field_order->visit(struct_definition, [&](const lexer::StructField& field_data) -> const std::byte& {
+            const auto report_scope = layout::LayoutReport::enter(offsets_accessor.layout_report, field_data.name);
             uint16_t struct_depth = [&] -> uint16_t {
                 if constexpr (std::is_same_v<Args, GenStructLeafArgs>) {
                     return additional_args.depth + 1;
@@ -1259,10 +3381,10 @@ struct TypeVisitor {
                 decltype(estd::conditionally<is_dynamic_variant_element<Args>>(unique_name, base_name))
             >{
                 estd::conditionally<is_dynamic_variant_element<Args>>(unique_name, base_name),
-                offsets_accessor,
+                field_accessor,
                 level_size_leafs,
                 current_size_leaf_idx,
-                GenStructLeafArgs{field_data.name, struct_depth},
+                GenStructLeafArgs{field_data.name, struct_depth, struct_definition.name},
                 array_depth,
                 pack_sizes
             }, std::move(struct_code).template as<codegen::UnknownStructBase>());
@@ -1308,6 +3430,7 @@ struct TypeVisitor {
 
 inline void generate (
     const lexer::StructDefinition& target_struct,
+    const layout::FieldOrder& field_order,
     const fs::File output_file
 ) {
     const lexer::StructDefinitionData target_struct_data = target_struct.data;
@@ -1355,10 +3478,17 @@ inline void generate (
 
     std::vector<uint64_t> var_offset_buffer;
     uint64_t var_leafs_start = 0;
+    std::vector<layout::BitLeaf> bit_leafs;
+    layout::OptionalLeafs optional_leafs;
+    std::vector<uint16_t> shared_id_bases;
 
     const auto layout_start_ts = std::chrono::high_resolution_clock::now();
     constexpr size_t layout_bench_iterations = 1;
 
+    layout::generation::LayoutBudget layout_budget = layout::generation::LayoutBudget::from_ms(global::options::layout_budget_ms);
+    layout::generation::SizeOptimization size_optimization;
+    layout::LayoutReport layout_report;
+
     for (size_t i = 0; i < layout_bench_iterations; i++) {
         std::ranges::fill(fixed_offsets, layout::FixedOffset::empty());
         std::ranges::fill(var_offset_idx_ranges, estd::integral_range<uint64_t>{});
@@ -1367,6 +3497,7 @@ inline void generate (
         var_offset_buffer.clear();
         auto generate_offsets_result = layout::generation::generate(
             target_struct,
+            field_order,
             fixed_offsets,
             var_offset_idx_ranges,
             idx_map,
@@ -1377,16 +3508,39 @@ inline void generate (
             total_top_level_var_leafs,
             level_fixed_variants,
             level_fixed_arrays,
-            level_size_leafs_count
+            level_size_leafs_count,
+            layout_budget,
+            global::options::optimize_size ? &size_optimization : nullptr,
+            global::options::layout_report && i == 0 ? &layout_report : nullptr
         );
         var_offset_buffer = std::move(generate_offsets_result.var_offset_buffer);
         var_leafs_start = generate_offsets_result.var_leafs_start;
+        bit_leafs = std::move(generate_offsets_result.bit_leafs);
+        optional_leafs = std::move(generate_offsets_result.optional_leafs);
+        shared_id_bases = std::move(generate_offsets_result.shared_id_bases);
     }
 
     const auto layout_end_ts = std::chrono::high_resolution_clock::now();
 
     console.info("Layout generation took ", std::chrono::duration_cast<std::chrono::milliseconds>(layout_end_ts - layout_start_ts).count(), " ms for ", layout_bench_iterations, " iterations");
 
+    if (layout_budget.greedy_layouts != 0) {
+        console.warn(
+            layout_budget.greedy_layouts, " variant layout(s) fell back to greedy packing",
+            layout_budget.exhausted() ? " after the layout budget ran out" : "",
+            ", ", layout_budget.bytes_above_lower_bound, " bytes above the lower bound"
+        );
+    }
+
+    if (global::options::optimize_size) {
+        console.info(
+            "Size optimization saved ", size_optimization.bytes_saved, " bytes over ", size_optimization.optimized_layouts, " variant layout(s), ",
+            size_optimization.lower_bound_layouts, " reached the lower bound, ",
+            size_optimization.unfinished_layouts, " cut short by the layout budget, ",
+            size_optimization.explored_nodes, " nodes explored"
+        );
+    }
+
     // auto generate_offsets_result = generate_offsets::generate(
     //     target_struct,
     //     fixed_offsets,
@@ -1412,8 +3566,13 @@ inline void generate (
         var_offsets,
         idx_map,
         pack_infos,
+        bit_leafs,
+        optional_leafs,
+        shared_id_bases,
+        field_order,
         var_leafs_start,
-        &current_map_idx
+        &current_map_idx,
+        nullptr
     };
 
     uint16_t current_size_leaf_idx = 0;
@@ -1422,17 +3581,37 @@ inline void generate (
     constexpr size_t codegen_bench_iterations = 1;
 
     for (size_t i = 0; ; i++) {
-        auto code = codegen::create_code(std::move(code_buffer))
+        const bool is_last = i == codegen_bench_iterations;
+
+        // Every iteration visits all leafs, only the last one reports them.
+        offsets_accessor.layout_report = global::options::layout_report && is_last ? &layout_report : nullptr;
+
+        std::vector<ResizableLeaf> resizable_leafs;
+        offsets_accessor.resizable_leafs = &resizable_leafs;
+        std::vector<ResizableOptional> resizable_optionals;
+        offsets_accessor.resizable_optionals = &resizable_optionals;
+
+        uint16_t message_alignment = SIZE::MAX.byte_size();
+        offsets_accessor.message_alignment = &message_alignment;
+
+        auto code = add_ring_runtime(add_stream_runtime(add_profile_runtime(add_atomic_include(codegen::create_code(std::move(code_buffer))
+        .line("#include <bit>")
+        .line("#include <cassert>")
         .line("#include <cstddef>")
         .line("#include <cstdint>")
+        .line("#include <cstring>")
+        .line("#include <memory>")
+        .line("#include <span>")
+        .line("#include <string_view>")))))
         .line();
 
         auto&& struct_code = std::move(code)
         ._struct(struct_name)
             .ctor("size_t base", "base(base)").end();
 
-        target_struct.visit([&](const lexer::StructField& field_data) -> const std::byte& {
+        field_order.visit(target_struct, [&](const lexer::StructField& field_data) -> const std::byte& {
             auto name = field_data.name;
+            const auto report_scope = layout::LayoutReport::enter(offsets_accessor.layout_report, name);
             auto result = field_data.type().visit(TypeVisitor<
                 std::byte,
                 true,
@@ -1444,7 +3623,7 @@ inline void generate (
                 offsets_accessor,
                 level_size_leafs,
                 &current_size_leaf_idx,
-                GenStructLeafArgs{name, 0},
+                GenStructLeafArgs{name, 0, struct_name},
                 0,
                 AlignSizes::zero()
             }, std::move(struct_code).template as<codegen::UnknownStructBase>());
@@ -1453,18 +3632,28 @@ inline void generate (
             return result.next_type;
         });
 
+        // base has to be aligned to alignment, buffers made of AlignedWords are.
         struct_code = std::move(struct_code)
+            .field("static constexpr size_t", codegen::StringParts{"alignment = "_sl, message_alignment})
+            ._struct("alignas(alignment) AlignedWord")
+            .strip_name()
+                .field("std::byte", "bytes[alignment]")
+            .end()
             ._private()
             .field("size_t", "base");
 
         struct_code = add_size_leafs(level_size_leafs, fixed_offsets, std::move(struct_code));
+        struct_code = add_optionals_size(offsets_accessor, std::move(struct_code));
+        struct_code = add_byte_size(offsets_accessor, level_size_leafs, std::move(struct_code));
+        struct_code = add_decoder(offsets_accessor, level_size_leafs.size(), struct_name, std::move(struct_code));
+        struct_code = add_editor(offsets_accessor, resizable_leafs, resizable_optionals, level_size_leafs, struct_name, std::move(struct_code));
+        struct_code = add_seqlock(offsets_accessor, struct_name, std::move(struct_code));
+        struct_code = add_prefetch(offsets_accessor, struct_name, std::move(struct_code));
 
         auto code_done = std::move(struct_code)
         .end()
         .end();
 
-        const bool is_last = i == codegen_bench_iterations;
-
         if (is_last) {
             console.info(AlignMembersBase<int, SIZE::SIZE_8, SIZE::SIZE_2>{1, 2, 3});
             for (size_t written = 0; written < code_done.size();) {
@@ -1488,6 +3677,10 @@ inline void generate (
     const auto codegen_end_ts = std::chrono::high_resolution_clock::now();
 
     console.info("Codegen took ", std::chrono::duration_cast<std::chrono::milliseconds>(codegen_end_ts - codegen_start_ts).count(), " ms for ", codegen_bench_iterations, " iterations");
+
+    if (global::options::layout_report) {
+        layout_report.print(struct_name, pack_infos);
+    }
 }
 
 
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 
 namespace global {
@@ -11,4 +12,35 @@ static std::string file_path {"<unknown>"};
 
 }; // namespace input
 
+namespace options {
+
+// Milliseconds the variant layout search may take before falling back to greedy packing. 0 means unbounded.
+static uint64_t layout_budget_ms = 0;
+
+// Search smaller variant layouts over the section boundaries instead of taking the first perfect one (--optimize=size).
+static bool optimize_size = false;
+
+// Print offsets, padding and accessor costs of the generated layout (--layout-report).
+static bool layout_report = false;
+
+// Count accessor calls per field in the generated code (--layout-instrument).
+static bool layout_instrument = false;
+
+// Accessor counts to order the fields by (--layout-profile=file), empty if none.
+static std::string layout_profile_path;
+
+// Emit the stream::Reader and stream::Writer runtime into the generated header (--stream-runtime).
+static bool stream_runtime = false;
+
+// Add std::atomic_ref based load, store and fetch_add accessors for fixed leafs (--atomic-accessors).
+static bool atomic_accessors = false;
+
+// Add a Seqlock publishing the fixed region to concurrent readers (--seqlock).
+static bool seqlock = false;
+
+// Emit the ring::Spsc and ring::Mpsc shared memory runtime into the generated header (--ring-runtime).
+static bool ring_runtime = false;
+
+}; // namespace options
+
 }; // namespace global
\ No newline at end of file
@@ -8,6 +8,7 @@ namespace layout {
 struct ArrayPackInfo {
     uint64_t size;
     uint16_t parent_idx;
+    bool soa = false;   // Holds one column per leaf instead of the leafs of every element in turn
 
     [[nodiscard]] bool has_parent () const {
         return parent_idx != static_cast<uint16_t>(-1);
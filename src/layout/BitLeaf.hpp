@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+
+#include "../core/SIZE.hpp"
+
+namespace layout {
+
+/**
+ * Position of a bit packed leaf inside the word at its fixed offset.
+ */
+struct BitLeaf {
+    uint8_t shift = 0;
+    uint8_t width = 0;      // 0 if the leaf is not bit packed
+    SIZE word_size;
+
+    [[nodiscard]] constexpr bool is_packed () const { return width != 0; }
+};
+
+} // namespace layout
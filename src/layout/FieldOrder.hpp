@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include <boost/unordered/unordered_flat_map.hpp>
+
+#include "../parser/lexer_types.hpp"
+
+namespace layout {
+
+/**
+ * Order the fields of a struct are laid out and generated in, filled from the layout profile (--layout-profile).
+ * Structs without a profiled order fall back to `StructDefinition::visit_in_layout_order`.
+ * Layout generation and code generation consume leaf indices in visiting order, so both have to visit through this.
+ */
+struct FieldOrder {
+    boost::unordered::unordered_flat_map<const lexer::StructDefinition*, std::vector<const lexer::StructField*>> orders;
+
+    template <typename VisitorT>
+    void visit (const lexer::StructDefinition& struct_definition, VisitorT&& visitor) const {
+        const auto it = orders.find(&struct_definition);
+        if (it == orders.end()) {
+            struct_definition.visit_in_layout_order(visitor);
+            return;
+        }
+        for (const lexer::StructField* field_data : it->second) {
+            static_cast<void>(visitor(*field_data));
+        }
+    }
+};
+
+} // namespace layout
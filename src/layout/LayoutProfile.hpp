@@ -0,0 +1,172 @@
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+#include <boost/unordered/unordered_flat_map.hpp>
+
+#include "../parser/lexer_types.hpp"
+#include "../helper/error_exit.hpp"
+#include "../sys/fs.hpp"
+#include "../util/logger.hpp"
+#include "./FieldOrder.hpp"
+
+namespace layout {
+
+/**
+ * Accessor call counts of instrumented code (`--layout-instrument`), read back with `--layout-profile=file`.
+ * A line holds either `Struct.field count`, the calls of an accessor, or `Struct.a>Struct.b count`, how often the
+ * accessor of b was called right after the one of a. Lines repeat for every thread and every use of a struct, their
+ * counts add up.
+ */
+struct LayoutProfile {
+    boost::unordered::unordered_flat_map<std::string, uint64_t> counts;
+    boost::unordered::unordered_flat_map<std::string, uint64_t> co_accesses;   // Keyed by both fields in ascending order
+    uint16_t applied_fields = 0;
+
+    [[nodiscard]] static std::string co_access_key (std::string_view a, std::string_view b) {
+        if (b < a) std::swap(a, b);
+        return std::string{a}.append(">").append(b);
+    }
+
+    [[nodiscard]] uint64_t co_access (const std::string_view a, const std::string_view b) const {
+        const auto it = co_accesses.find(co_access_key(a, b));
+        return it == co_accesses.end() ? 0 : it->second;
+    }
+
+    [[nodiscard]] static LayoutProfile read (const std::string& path) {
+        const fs::File file = fs::File::open(
+            path,
+            estd::variadic_v<fs::OPEN_FLAGS::RDONLY>{},
+            {},
+            [&path](const sys::OPEN_ERROR) {
+                error_exit("Failed to open layout profile: ", path);
+            }
+        );
+
+        std::string content;
+        char read_buffer[4096];
+        for (;;) {
+            const size_t read = file.read(read_buffer, sizeof(read_buffer), [](const auto e) {
+                error_exit("Failed to read layout profile: ", std::strerror(e));
+            });
+            if (read == 0) break;
+            content.append(read_buffer, read);
+        }
+
+        LayoutProfile profile;
+        std::string_view rest = content;
+        while (!rest.empty()) {
+            const size_t line_end = std::min(rest.find('\n'), rest.size());
+            const std::string_view line = rest.substr(0, line_end);
+            rest.remove_prefix(std::min(line_end + 1, rest.size()));
+            if (line.empty()) continue;
+
+            const size_t separator = line.rfind(' ');
+            if (separator == std::string_view::npos) {
+                error_exit("Invalid layout profile line: ", line);
+            }
+            const std::string_view count_str = line.substr(separator + 1);
+            uint64_t count = 0;
+            const auto [ptr, ec] = std::from_chars(count_str.data(), count_str.data() + count_str.size(), count);
+            if (ec != std::errc{} || ptr != count_str.data() + count_str.size()) {
+                error_exit("Invalid count in layout profile line: ", line);
+            }
+            const std::string_view key = line.substr(0, separator);
+            const size_t follower_separator = key.find('>');
+            if (follower_separator == std::string_view::npos) {
+                profile.counts[std::string{key}] += count;
+            } else {
+                profile.co_accesses[co_access_key(key.substr(0, follower_separator), key.substr(follower_separator + 1))] += count;
+            }
+        }
+        return profile;
+    }
+
+    /**
+     * Orders the fields of a profiled struct: `[[hot]]` fields first, each group starting with its most called field.
+     * Every field is followed by the unplaced one of its group it was accessed together with most often, or by the most
+     * called unplaced field if it has no such partner. Ties keep the declaration order.
+     */
+    void apply (const lexer::StructDefinition& struct_definition, FieldOrder& field_order) {
+        if (field_order.orders.contains(&struct_definition)) return;
+
+        struct ProfiledField {
+            const lexer::StructField* field_data;
+            std::string key;
+            uint64_t count;
+        };
+        std::vector<ProfiledField> fields;
+        fields.reserve(struct_definition.data.field_count);
+        bool profiled = false;
+        struct_definition.visit([&](const lexer::StructField& field_data) -> const std::byte& {
+            std::string key = std::string{struct_definition.name}.append(".").append(field_data.name);
+            const auto it = counts.find(key);
+            const uint64_t count = it == counts.end() ? 0 : it->second;
+            profiled |= count != 0;
+            fields.emplace_back(&field_data, std::move(key), count);
+            return field_data.type().skip<const std::byte>();
+        });
+        if (!profiled) return;
+
+        std::ranges::stable_sort(fields, [](const ProfiledField& a, const ProfiledField& b) {
+            if (a.field_data->attributes.hot != b.field_data->attributes.hot) return a.field_data->attributes.hot;
+            return a.count > b.count;
+        });
+
+        std::vector<const lexer::StructField*> order;
+        order.reserve(fields.size());
+        std::vector<bool> placed (fields.size(), false);
+        size_t first_unplaced = 0;
+        const ProfiledField* last = nullptr;
+        while (order.size() < fields.size()) {
+            while (placed[first_unplaced]) first_unplaced++;
+            size_t next = first_unplaced;
+            if (last != nullptr) {
+                const bool hot = fields[first_unplaced].field_data->attributes.hot;
+                uint64_t most_co_accesses = 0;
+                for (size_t i = first_unplaced; i < fields.size(); i++) {
+                    if (placed[i] || fields[i].field_data->attributes.hot != hot) continue;
+                    const uint64_t co_accesses = co_access(last->key, fields[i].key);
+                    if (co_accesses > most_co_accesses) {
+                        most_co_accesses = co_accesses;
+                        next = i;
+                    }
+                }
+            }
+            placed[next] = true;
+            last = &fields[next];
+            order.push_back(last->field_data);
+            if (last->count != 0) applied_fields++;
+        }
+        field_order.orders.emplace(&struct_definition, std::move(order));
+    }
+
+    /**
+     * Orders the fields of every profiled struct of the schema.
+     */
+    void apply (const lexer::IdentifierMap& identifier_map, const Buffer& buffer, FieldOrder& field_order) {
+        struct Visitor {
+            LayoutProfile& profile;
+            FieldOrder& field_order;
+
+            void on_struct (const lexer::StructDefinition& struct_definition) const { profile.apply(struct_definition, field_order); }
+
+            void on_enum (const lexer::EnumDefinition& /*unused*/) const {}
+        };
+
+        for (const auto& [name, definition_idx] : identifier_map) {
+            buffer.get(definition_idx).visit(Visitor{*this, field_order});
+        }
+        console.info("Layout profile applied to ", applied_fields, " fields");
+    }
+};
+
+} // namespace layout
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "../core/SIZE.hpp"
+#include "../core/AlignSizes.hpp"
+#include "../util/logger.hpp"
+#include "./ArrayPackInfo.hpp"
+
+namespace layout {
+
+/**
+ * Storage efficiency and accessor cost of a generated layout (`--layout-report`).
+ * Variants are added by the layout generation, leafs by the code generation walking the same type tree afterwards.
+ * Both name what they add by the field path of the scopes they entered.
+ */
+struct LayoutReport {
+    struct Variant {
+        std::string path;
+        AlignSizes pack_sizes;
+        uint64_t size;                          // Bytes all alternatives share, without the id
+        uint64_t max_wasted_bytes;
+        std::vector<uint64_t> alternative_sizes; // In declaration order
+    };
+
+    struct Leaf {
+        std::string path;
+        uint64_t offset;                        // Offset of a fixed leaf, start of the variable sized leafs otherwise
+        SIZE pack_align;
+        uint16_t dependent_loads;               // Sizes the accessor loads before it can compute the offset
+        bool is_fixed;
+    };
+
+    /**
+     * Appends a name to the path of every leaf added while it is alive.
+     */
+    struct Scope {
+        LayoutReport* report;
+        size_t path_size;
+
+        ~Scope () {
+            if (report != nullptr) report->path.resize(path_size);
+        }
+    };
+
+    std::string path;
+    std::vector<Variant> variants;
+    std::vector<Leaf> leafs;
+    uint64_t fixed_size = 0;
+    uint64_t fixed_padding = 0;                 // Bytes of the fixed size no leaf takes, between leafs or at the end
+    uint64_t fixed_tail_padding = 0;
+
+    template <typename... Parts>
+    [[nodiscard]] static Scope enter (LayoutReport* const report, const Parts&... parts) {
+        if (report == nullptr) return {nullptr, 0};
+        const size_t path_size = report->path.size();
+        if (path_size != 0) report->path += '.';
+        (report->append(parts), ...);
+        return {report, path_size};
+    }
+
+    /**
+     * Like enter, but for the elements of an array.
+     */
+    [[nodiscard]] static Scope enter_element (LayoutReport* const report) {
+        if (report == nullptr) return {nullptr, 0};
+        const size_t path_size = report->path.size();
+        report->path += "[]";
+        return {report, path_size};
+    }
+
+    void add_variant (std::vector<uint64_t>&& alternative_sizes, const AlignSizes pack_sizes, const uint64_t max_wasted_bytes) {
+        const uint64_t size = pack_sizes.get<SIZE::SIZE_8>() + pack_sizes.get<SIZE::SIZE_4>() + pack_sizes.get<SIZE::SIZE_2>() + pack_sizes.get<SIZE::SIZE_1>();
+        variants.push_back({path, pack_sizes, size, max_wasted_bytes, std::move(alternative_sizes)});
+    }
+
+    [[nodiscard]] const Variant* find_variant (const std::string_view variant_path) const {
+        const auto it = std::ranges::find(variants, variant_path, &Variant::path);
+        return it == variants.end() ? nullptr : &*it;
+    }
+
+    void add_fixed_leaf (const uint64_t offset, const SIZE pack_align) {
+        leafs.push_back({path, offset, pack_align, 0, true});
+    }
+
+    void add_var_leaf (const uint64_t var_leafs_start, const uint16_t size_chain_length) {
+        leafs.push_back({path, var_leafs_start, SIZE::SIZE_0, size_chain_length, false});
+    }
+
+    void print (const std::string_view struct_name, const std::span<const ArrayPackInfo> pack_infos) const {
+        console.info("Layout report for ", struct_name);
+        console.info("  fixed size: ", fixed_size, " bytes, padding: ", fixed_padding, " bytes, ", fixed_tail_padding, " of them at the end");
+
+        uint16_t max_dependent_loads = 0;
+        for (const Leaf& leaf : leafs) {
+            if (leaf.is_fixed) {
+                console.info("  ", leaf.path, " @ ", leaf.offset, " pack_align: ", leaf.pack_align);
+            } else {
+                console.info("  ", leaf.path, " @ ", leaf.offset, " + size chain, dependent loads: ", leaf.dependent_loads);
+            }
+            max_dependent_loads = std::max(max_dependent_loads, leaf.dependent_loads);
+        }
+        console.info("  max dependent loads: ", max_dependent_loads);
+
+        for (const Variant& variant : variants) {
+            console.info(
+                "  variant ", variant.path, ": ", variant.size, " bytes, packs: ", variant.pack_sizes,
+                ", max_wasted: ", variant.max_wasted_bytes
+            );
+            for (size_t i = 0; i < variant.alternative_sizes.size(); i++) {
+                const uint64_t alternative_size = variant.alternative_sizes[i];
+                const uint64_t wasted = variant.size - alternative_size;
+                console.info(
+                    "    as_", i, ": ", alternative_size, " bytes, wasted: ", wasted, " / ", variant.max_wasted_bytes,
+                    wasted > variant.max_wasted_bytes ? " (over budget)" : ""
+                );
+            }
+        }
+
+        for (size_t i = 0; i < pack_infos.size(); i++) {
+            const ArrayPackInfo& pack_info = pack_infos[i];
+            const std::string_view columns = pack_info.soa ? ", columns" : "";
+            if (pack_info.has_parent()) {
+                console.info("  array pack ", i, ": ", pack_info.size, " bytes per element, parent pack: ", pack_info.parent_idx, columns);
+            } else {
+                console.info("  array pack ", i, ": ", pack_info.size, " bytes per element", columns);
+            }
+        }
+    }
+
+private:
+    void append (const std::string_view part) { path += part; }
+
+    void append (const uint64_t part) { path += std::to_string(part); }
+};
+
+} // namespace layout
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "../core/AlignMembersBase.hpp"
+#include "../core/SIZE.hpp"
+
+namespace layout {
+
+/**
+ * Bits of the presence word, one mask for each value size.
+ */
+struct PresenceMasks : AlignMembersBase<uint64_t, SIZE::SIZE_8, SIZE::SIZE_1, PresenceMasks> {
+    using AlignMembersBase::AlignMembersBase;
+
+    [[nodiscard]] constexpr bool empty () const {
+        return (get<SIZE::SIZE_8>() | get<SIZE::SIZE_4>() | get<SIZE::SIZE_2>() | get<SIZE::SIZE_1>()) == 0;
+    }
+};
+
+/**
+ * Values of `optional<T>` fields are only stored when present. They follow each other from the start of the variable
+ * sized part, the bigger values first, so the offset of a value is the sum of popcounts of the presence word.
+ */
+struct OptionalLeafs {
+    std::vector<PresenceMasks> preceding;   // Indexed by map_idx, the presence bits of the values stored in front
+    PresenceMasks all;                      // The presence bits of all values
+    uint16_t first_map_idx = static_cast<uint16_t>(-1);
+    SIZE start_alignment = SIZE::SIZE_1;    // Size of the biggest value
+    SIZE end_alignment = SIZE::SIZE_1;      // The variable sized leafs behind the values need this alignment
+
+    [[nodiscard]] bool empty () const { return first_map_idx == static_cast<uint16_t>(-1); }
+};
+
+} // namespace layout
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "../../core/SIZE.hpp"
+#include "../../util/logger.hpp"
+#include "../BitLeaf.hpp"
+
+namespace layout::generation {
+
+/**
+ * Bools and ranged integers of the top level, packed into shared words once all fields are visited.
+ */
+struct BitFields {
+    struct Field {
+        uint16_t map_idx;
+        uint8_t width;
+    };
+
+    struct Word {
+        std::vector<Field> fields;
+        uint8_t used_bits = 0;
+        SIZE size = SIZE::MAX;
+    };
+
+    static constexpr uint8_t max_word_bits = SIZE::MAX.byte_size() * 8;
+
+    std::vector<Field> fields;
+    std::vector<BitLeaf> leafs;     // Indexed by map_idx, filled by pack
+
+    [[nodiscard]] bool empty () const { return fields.empty(); }
+
+    void add (const uint16_t map_idx, const uint8_t width) {
+        BSSERT(width != 0 && width <= max_word_bits);
+        fields.push_back({map_idx, width});
+    }
+
+    [[nodiscard]] static constexpr SIZE word_size (const uint8_t bits) {
+        if (bits <= 8) return SIZE::SIZE_1;
+        if (bits <= 16) return SIZE::SIZE_2;
+        if (bits <= 32) return SIZE::SIZE_4;
+        return SIZE::SIZE_8;
+    }
+
+    /**
+     * First fit decreasing into words of SIZE::MAX, every word then shrinks to the smallest size holding its bits.
+     * Returns the words from the biggest to the smallest.
+     */
+    [[nodiscard]] std::vector<Word> pack (const size_t map_idx_count) {
+        std::vector<Field> sorted = fields;
+        std::ranges::stable_sort(sorted, std::greater{}, &Field::width);
+
+        std::vector<Word> words;
+        for (const Field& field : sorted) {
+            auto word = std::ranges::find_if(words, [&field](const Word& word) {
+                return word.used_bits + field.width <= max_word_bits;
+            });
+            if (word == words.end()) {
+                word = words.emplace(words.end());
+            }
+            word->fields.push_back(field);
+            word->used_bits += field.width;
+        }
+
+        leafs.assign(map_idx_count, BitLeaf{});
+        for (Word& word : words) {
+            word.size = word_size(word.used_bits);
+            uint8_t shift = 0;
+            for (const Field& field : word.fields) {
+                leafs[field.map_idx] = {shift, field.width, word.size};
+                shift += field.width;
+            }
+        }
+        std::ranges::stable_sort(words, std::greater{}, &Word::size);
+
+        console.debug("[BitFields] ", fields.size(), " fields packed into ", words.size(), " words");
+        return words;
+    }
+};
+
+} // namespace layout::generation
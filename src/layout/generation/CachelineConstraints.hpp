@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "../../estd/ranges.hpp"
+#include "../../helper/error_exit.hpp"
+#include "../../parser/lexer_types.hpp"
+#include "../../util/logger.hpp"
+
+namespace layout::generation {
+
+/**
+ * `[[hot]]` and `[[cacheline=N]]` fields of the generated struct.
+ * Hot fields are visited first and flushed to the front of the fixed region. The units of a field with a cache line
+ * size skip the subset sum solver and are placed in order, each moved to the next line if it would straddle one and a
+ * unit bigger than a line starting one. Every placed unit is checked afterwards, hot fields which do not fit the first
+ * line are an error.
+ */
+struct CachelineConstraints {
+    static constexpr uint16_t default_cacheline = 64;
+
+    struct Field {
+        std::string_view name;
+        estd::integral_range<uint16_t> map_idxs;
+        lexer::FieldAttributes attributes;
+    };
+
+    // A leaf or pack placed on the top level
+    struct Unit {
+        uint64_t offset;
+        uint64_t size;
+        uint16_t map_idx;
+    };
+
+    std::vector<Field> fields;
+    std::vector<Unit> units;
+    uint16_t current_cacheline = 0;     // Line size of the field being visited
+    uint64_t padding = 0;               // Bytes spent to satisfy the constraints
+
+    [[nodiscard]] bool empty () const { return fields.empty(); }
+
+    void add_field (const lexer::StructField& field_data, const estd::integral_range<uint16_t> map_idxs) {
+        if (!field_data.attributes.hot && field_data.attributes.cacheline == 0) return;
+        fields.push_back({field_data.name, map_idxs, field_data.attributes});
+    }
+
+    void add_unit (const uint64_t offset, const uint64_t size, const uint16_t map_idx) {
+        if (empty()) return;
+        units.push_back({offset, size, map_idx});
+    }
+
+    /**
+     * Moves offset to the next line, if a unit of the current field would straddle one or is bigger than a line and
+     * does not start one. Any line size keeps the alignment of the offset.
+     */
+    void pad (uint64_t& offset, const uint64_t size) {
+        if (current_cacheline == 0) return;
+        const uint64_t line_offset = offset % current_cacheline;
+        if (line_offset == 0 || line_offset + size <= current_cacheline) return;
+        const uint64_t line_padding = current_cacheline - line_offset;
+        console.debug("[CachelineConstraints] padding: ", line_padding, " at: ", offset);
+        offset += line_padding;
+        padding += line_padding;
+    }
+
+    /**
+     * Exits on the first unit violating the constraints of its field.
+     */
+    void check () const {
+        for (const Unit& unit : units) {
+            for (const Field& field : fields) {
+                if (unit.map_idx < *field.map_idxs.begin() || unit.map_idx >= *field.map_idxs.end()) continue;
+
+                const uint64_t cacheline = field.attributes.cacheline != 0 ? field.attributes.cacheline : default_cacheline;
+                const uint64_t end = unit.offset + unit.size;
+                if (field.attributes.hot && end > cacheline) {
+                    error_exit("Hot field ", field.name, " ends at byte ", end, ", past the first cache line of ", cacheline, " bytes");
+                }
+                const bool straddles = unit.size <= cacheline
+                    ? unit.offset / cacheline != (end - 1) / cacheline
+                    : unit.offset % cacheline != 0;
+                if (field.attributes.cacheline != 0 && straddles) {
+                    error_exit("Field ", field.name, " straddles a cache line of ", cacheline, " bytes at byte ", unit.offset, " with ", unit.size, " bytes");
+                }
+                break;
+            }
+        }
+    }
+};
+
+} // namespace layout::generation
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace layout::generation {
+
+/**
+ * Time limit for the perfect variant layout search (`--layout-budget=<ms>`).
+ * The greedy layout of a variant always fits and is kept unless the search finds a layout at most as big in time.
+ * Once exhausted the remaining alignment sections of a variant are packed greedily.
+ */
+struct LayoutBudget {
+    using clock = std::chrono::steady_clock;
+
+    clock::time_point deadline = clock::time_point::max();
+    uint16_t greedy_layouts = 0;    // Variant layouts which fell back to greedy packing
+    uint64_t bytes_above_lower_bound = 0;   // Bytes those layouts take beyond their biggest variant
+
+    [[nodiscard]] static LayoutBudget unbounded () { return {}; }
+
+    [[nodiscard]] static LayoutBudget from_ms (const uint64_t ms) {
+        if (ms == 0) return unbounded();
+        return {clock::now() + std::chrono::milliseconds{ms}};
+    }
+
+    [[nodiscard]] bool is_bounded () const { return deadline != clock::time_point::max(); }
+
+    [[nodiscard]] bool exhausted () const { return is_bounded() && clock::now() >= deadline; }
+
+    void record_greedy_layout (const uint64_t layout_size, const uint64_t lower_bound) {
+        greedy_layouts++;
+        if (layout_size > lower_bound) {
+            bytes_above_lower_bound += layout_size - lower_bound;
+        }
+    }
+};
+
+} // namespace layout::generation
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include <gsl/util>
+
+#include "../../core/SIZE.hpp"
+#include "../../helper/error_exit.hpp"
+#include "../../util/logger.hpp"
+#include "../BitLeaf.hpp"
+#include "../OptionalLeafs.hpp"
+#include "./BitFields.hpp"
+
+namespace layout::generation {
+
+/**
+ * The presence bits of all optionals of the top level. They are added to the bit fields as one field, which keeps them
+ * in a single word in declaration order.
+ */
+struct PresenceBitmap {
+    struct Field {
+        uint16_t map_idx;
+        SIZE value_size;
+    };
+
+    std::vector<Field> fields;
+
+    [[nodiscard]] bool empty () const { return fields.empty(); }
+
+    void add (const uint16_t map_idx, const SIZE value_size) {
+        if (fields.size() == BitFields::max_word_bits) {
+            error_exit("A struct can have at most ", BitFields::max_word_bits, " optional fields");
+        }
+        fields.push_back({map_idx, value_size});
+    }
+
+    void add_to (BitFields& bit_fields) const {
+        bit_fields.add(fields.front().map_idx, gsl::narrow_cast<uint8_t>(fields.size()));
+    }
+
+    /**
+     * Spreads the packed bitmap over its fields after the bit fields are placed. Every field gets its own bit, the fixed
+     * offset of the word and the masks for the values stored in front of its own.
+     */
+    [[nodiscard]] OptionalLeafs finish (
+        const std::span<BitLeaf> bit_leafs,
+        const std::span<uint16_t> idx_map,
+        const SIZE var_leafs_alignment
+    ) const {
+        OptionalLeafs result;
+        if (empty()) return result;
+
+        const uint16_t first_map_idx = fields.front().map_idx;
+        const BitLeaf bitmap_leaf = bit_leafs[first_map_idx];
+        result.first_map_idx = first_map_idx;
+        result.end_alignment = var_leafs_alignment;
+        result.preceding.assign(idx_map.size(), PresenceMasks{});
+
+        for (size_t i = 0; i < fields.size(); i++) {
+            const Field& field = fields[i];
+            const uint64_t bit = uint64_t{1} << (bitmap_leaf.shift + i);
+            bit_leafs[field.map_idx] = {gsl::narrow_cast<uint8_t>(bitmap_leaf.shift + i), 1, bitmap_leaf.word_size};
+            idx_map[field.map_idx] = idx_map[first_map_idx];
+
+            PresenceMasks& preceding = result.preceding[field.map_idx];
+            preceding.get<estd::discouraged>(field.value_size) = result.all.get<estd::discouraged>(field.value_size);
+            result.all.get<estd::discouraged>(field.value_size) |= bit;
+            result.start_alignment = std::max(result.start_alignment, field.value_size);
+        }
+
+        // Bigger values are stored in front of all smaller ones.
+        for (const Field& field : fields) {
+            PresenceMasks& preceding = result.preceding[field.map_idx];
+            for (const SIZE size : {SIZE::SIZE_8, SIZE::SIZE_4, SIZE::SIZE_2}) {
+                if (size > field.value_size) {
+                    preceding.get<estd::discouraged>(size) = result.all.get<estd::discouraged>(size);
+                }
+            }
+        }
+
+        console.debug("[PresenceBitmap] ", fields.size(), " optionals, shift: ", uint16_t{bitmap_leaf.shift});
+        return result;
+    }
+};
+
+} // namespace layout::generation
@@ -0,0 +1,261 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+#include <boost/unordered/unordered_flat_map.hpp>
+
+#include "../../estd/ranges.hpp"
+#include "../../estd/utility.hpp"
+#include "../../parser/lexer_types.hpp"
+#include "../../helper/error_exit.hpp"
+#include "../../math/multiples.hpp"
+#include "../../util/logger.hpp"
+#include "../FixedOffsets.hpp"
+#include "../FieldOrder.hpp"
+#include "./PendingVariantFieldPacks.hpp"
+
+namespace layout::generation {
+
+/**
+ * Fixed variants of one struct with the same `[[shared_id=N]]` overlay each other.
+ * Each member is laid out on its own and its packs are put behind each other by decreasing alignment. Only the last
+ * member enqueues a pack, one region as big as the biggest member and aligned like the biggest pack of any member,
+ * which holds the fixed offsets of every member relative to its start.
+ * The members share the id leaf of the first one. Its values number the alternatives of all members one after the
+ * other, so the live member is the one whose alternatives hold the id.
+ */
+struct SharedVariantGroup {
+    uint32_t shared_id;
+    uint16_t members_left = 0;
+    uint16_t alternative_count = 0;     // Of all members
+    uint16_t next_alternative = 0;
+    std::vector<std::pair<uint16_t, uint16_t>> member_ids;  // Map idx of the id leaf and first id of every member
+    const void* level = nullptr;
+    uint64_t size = 0;
+    SIZE alignment = SIZE::SIZE_1;
+    std::vector<FixedOffset> offsets;
+
+    /**
+     * Numbers the alternatives of the member after those of the members before it.
+     * Returns true for the first member, which enqueues the id leaf of the group.
+     */
+    [[nodiscard]] bool add_id (const uint16_t map_idx, const uint16_t variant_count) {
+        member_ids.emplace_back(map_idx, next_alternative);
+        next_alternative += variant_count;
+        return member_ids.size() == 1;
+    }
+
+    /**
+     * Takes the fixed offsets of the member's packs out of the level.
+     * Returns true for the last member, the packs are then replaced by the region shared by the group.
+     */
+    [[nodiscard]] bool add_member (
+        PendingVariantFieldPacks& packs,
+        const void* const member_level,
+        const std::span<FixedOffset> fixed_offsets,
+        const uint16_t fixed_offset_idx_begin
+    ) {
+        if (level == nullptr) {
+            level = member_level;
+        } else if (level != member_level) {
+            error_exit("Variants with shared_id ", shared_id, " have to be fields of the same struct level");
+        }
+
+        uint64_t member_size = 0;
+        take_packs(packs, fixed_offsets, member_size, PendingVariantFieldPacks::alignments::apply<estd::reverse_variadic_v_t>{});
+        size = std::max(size, member_size);
+
+        BSSERT(members_left != 0);
+        if (--members_left != 0) return false;
+
+        uint16_t fixed_offset_idx = fixed_offset_idx_begin;
+        for (const FixedOffset& fixed_offset : offsets) {
+            BSSERT(fixed_offsets[fixed_offset_idx] == FixedOffset::empty());
+            fixed_offsets[fixed_offset_idx++] = fixed_offset;
+        }
+        packs = PendingVariantFieldPacks{};
+        packs.get<estd::discouraged>(alignment) = {size, {fixed_offset_idx_begin, fixed_offset_idx}};
+        console.debug("[SharedVariantGroup] shared_id: ", shared_id, " size: ", size, " alignment: ", alignment);
+        return true;
+    }
+
+private:
+    template <SIZE... alignments>
+    void take_packs (
+        const PendingVariantFieldPacks& packs,
+        const std::span<FixedOffset> fixed_offsets,
+        uint64_t& member_size,
+        estd::variadic_v<alignments...> /*unused*/
+    ) {
+        (..., take_pack<alignments>(packs.get<alignments>(), fixed_offsets, member_size));
+    }
+
+    template <SIZE pack_alignment>
+    void take_pack (
+        const std::pair<uint64_t, estd::integral_range<uint16_t>>& pack,
+        const std::span<FixedOffset> fixed_offsets,
+        uint64_t& member_size
+    ) {
+        if (pack.first == 0) return;
+        alignment = std::max(alignment, pack_alignment);
+        const uint64_t pack_offset = math::next_multiple(member_size, pack_alignment);
+        for (const uint16_t idx : pack.second) {
+            FixedOffset fixed_offset = fixed_offsets[idx];
+            fixed_offset.increment_offset(pack_offset);
+            offsets.push_back(fixed_offset);
+            fixed_offsets[idx] = FixedOffset::empty();
+        }
+        member_size = pack_offset + pack.first;
+    }
+};
+
+/**
+ * Shared ids are scoped to the struct they are used in. Every use of a struct gets its own groups, since its fields are
+ * laid out again for each use.
+ */
+struct SharedVariantGroups {
+    boost::unordered::unordered_flat_map<uint64_t, SharedVariantGroup> groups;
+    uint32_t struct_instance_count = 0;
+    uint32_t current_struct_instance = 0;
+
+    [[nodiscard]] static constexpr uint64_t key (const uint32_t struct_instance, const uint32_t shared_id) {
+        return (uint64_t{struct_instance} << 32) | shared_id;
+    }
+
+    void add_member (const uint32_t shared_id, const uint16_t variant_count) {
+        SharedVariantGroup& group = groups.try_emplace(key(current_struct_instance, shared_id)).first->second;
+        group.shared_id = shared_id;
+        group.members_left++;
+        group.alternative_count += variant_count;
+    }
+
+    [[nodiscard]] SharedVariantGroup& get (const uint32_t shared_id) {
+        return groups.at(key(current_struct_instance, shared_id));
+    }
+
+    /**
+     * Numbers struct uses in visiting order, the counting and the layout generation have to enter them alike.
+     */
+    [[nodiscard]] uint32_t enter_struct () {
+        const uint32_t outer = current_struct_instance;
+        current_struct_instance = ++struct_instance_count;
+        return outer;
+    }
+
+    void leave_struct (const uint32_t outer) {
+        current_struct_instance = outer;
+    }
+
+    /**
+     * Points the id leafs of every member to the placed id leaf of its group.
+     * Returns the first id of every member indexed by the map idx of its id leaf, empty without shared variants.
+     */
+    [[nodiscard]] std::vector<uint16_t> finish (const std::span<uint16_t> idx_map) const {
+        std::vector<uint16_t> id_bases;
+        if (groups.empty()) return id_bases;
+        id_bases.assign(idx_map.size(), static_cast<uint16_t>(-1));
+        for (const auto& [key, group] : groups) {
+            const uint16_t id_idx = idx_map[group.member_ids.front().first];
+            for (const auto& [map_idx, first_id] : group.member_ids) {
+                idx_map[map_idx] = id_idx;
+                id_bases[map_idx] = first_id;
+            }
+        }
+        return id_bases;
+    }
+};
+
+/**
+ * Counts the members of every shared variant group before the layout is generated.
+ * Visits the type tree the same way the layout generation does.
+ */
+template <typename NextType>
+struct SharedVariantCounter {
+    using next_type_t = NextType;
+    using result_t = lexer::Type::VisitResult<next_type_t>;
+
+    SharedVariantGroups& groups;
+    const FieldOrder& field_order;
+
+    void on_bool     () const {}
+    void on_uint8    () const {}
+    void on_uint16   () const {}
+    void on_uint32   () const {}
+    void on_uint64   () const {}
+    void on_int8     () const {}
+    void on_int16    () const {}
+    void on_int32    () const {}
+    void on_int64    () const {}
+    void on_float32  () const {}
+    void on_float64  () const {}
+
+    void on_ranged_uint (const lexer::RangedUintType& /*unused*/) const {}
+
+    void on_fixed_string (const lexer::FixedStringType& /*unused*/) const {}
+
+    void on_string (const lexer::StringType& /*unused*/) const {}
+
+    void on_vector (const lexer::VectorType& /*unused*/) const {}
+
+    void on_optional (const lexer::OptionalType& /*unused*/) const {}
+
+    void on_map (const lexer::MapType& /*unused*/) const {}
+
+    [[nodiscard]] result_t on_fixed_array (const lexer::ArrayType& fixed_array_type) const {
+        return fixed_array_type.inner_type().visit(*this);
+    }
+
+    [[nodiscard]] result_t on_array (const lexer::ArrayType& array_type) const {
+        return array_type.inner_type().visit(*this);
+    }
+
+    void on_fixed_variant (const lexer::FixedVariantType& fixed_variant_type) const {
+        const lexer::Type* type = &fixed_variant_type.first_variant();
+        for (uint16_t i = 0; i < fixed_variant_type.variant_count; i++) {
+            type = &type->visit(SharedVariantCounter<lexer::Type>{groups, field_order}).next_type;
+        }
+        if (fixed_variant_type.has_shared_id()) {
+            groups.add_member(fixed_variant_type.shared_id, fixed_variant_type.variant_count);
+        }
+    }
+
+    void on_packed_variant (const lexer::PackedVariantType& /*unused*/) const {}
+
+    void on_dynamic_variant (const lexer::DynamicVariantType& /*unused*/) const {}
+
+    void on_struct (const lexer::StructDefinition& struct_definition) const {
+        const uint32_t outer = groups.enter_struct();
+        visit_fields(struct_definition);
+        groups.leave_struct(outer);
+    }
+
+    void on_enum (const lexer::EnumDefinition& /*unused*/) const {}
+
+    void visit_fields (const lexer::StructDefinition& struct_definition) const {
+        field_order.visit(struct_definition, [this](const lexer::StructField& field_data) -> const std::byte& {
+            return field_data.type().visit(SharedVariantCounter<std::byte>{groups, field_order}).next_type;
+        });
+    }
+};
+
+[[nodiscard]] inline SharedVariantGroups count_shared_variants (const lexer::StructDefinition& target_struct, const FieldOrder& field_order) {
+    SharedVariantGroups groups;
+    SharedVariantCounter<std::byte>{groups, field_order}.visit_fields(target_struct);
+    BSSERT(groups.current_struct_instance == 0);
+    groups.struct_instance_count = 0;
+    for (const auto& [key, group] : groups.groups) {
+        if (group.members_left == 1) {
+            console.warn("Variant with shared_id ", group.shared_id, " has nothing to share its storage with");
+        }
+        if (group.alternative_count > UINT8_MAX) {
+            error_exit("Variants with shared_id ", group.shared_id, " have more than ", UINT8_MAX, " alternatives together");
+        }
+    }
+    return groups;
+}
+
+} // namespace layout::generation
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+
+namespace layout::generation {
+
+/**
+ * Statistics of the size optimizing variant layout search (`--optimize=size`).
+ * Every fixed variant is laid out by branch and bound over the placements of its fields into the packs of each alignment
+ * instead of taking the first perfect layout. Sizes are compared with every pack rounded up to its alignment, a finished
+ * search found the smallest one.
+ */
+struct SizeOptimization {
+    uint16_t optimized_layouts = 0;     // Variant layouts which were searched
+    uint16_t lower_bound_layouts = 0;   // Variant layouts which reached the size of their biggest variant, the lower bound
+    uint16_t unfinished_layouts = 0;    // Variant layouts whose search was cut short by the layout budget, not known to be minimal
+    uint64_t explored_nodes = 0;
+    uint64_t bytes_saved = 0;           // Bytes saved against the default layout
+
+    void record (const uint64_t default_size, const uint64_t best_size, const uint64_t lower_bound, const bool finished) {
+        optimized_layouts++;
+        if (best_size == lower_bound) lower_bound_layouts++;
+        if (!finished) unfinished_layouts++;
+        bytes_saved += default_size - best_size;
+    }
+};
+
+} // namespace layout::generation
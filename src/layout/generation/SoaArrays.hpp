@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+#include "../../estd/ranges.hpp"
+#include "../../parser/lexer_types.hpp"
+#include "../../helper/error_exit.hpp"
+#include "../FixedOffsets.hpp"
+
+namespace layout::generation {
+
+/**
+ * Elements of `[[soa]]` arrays may only hold scalars and structs of them, every leaf becomes one column.
+ */
+template <typename NextType>
+struct SoaElementCheck {
+    using next_type_t = NextType;
+    using result_t = lexer::Type::VisitResult<next_type_t>;
+
+    [[noreturn]] static void unsupported (const std::string_view what) {
+        error_exit("Elements of soa arrays can only hold scalars and structs of them, found ", what);
+    }
+
+    void on_bool     () const {}
+    void on_uint8    () const {}
+    void on_uint16   () const {}
+    void on_uint32   () const {}
+    void on_uint64   () const {}
+    void on_int8     () const {}
+    void on_int16    () const {}
+    void on_int32    () const {}
+    void on_int64    () const {}
+    void on_float32  () const {}
+    void on_float64  () const {}
+
+    void on_ranged_uint (const lexer::RangedUintType& /*unused*/) const { unsupported("a ranged integer"); }
+
+    void on_fixed_string (const lexer::FixedStringType& /*unused*/) const { unsupported("a string"); }
+
+    void on_string (const lexer::StringType& /*unused*/) const { unsupported("a string"); }
+
+    void on_vector (const lexer::VectorType& /*unused*/) const { unsupported("a vector"); }
+
+    void on_optional (const lexer::OptionalType& /*unused*/) const { unsupported("an optional"); }
+
+    void on_map (const lexer::MapType& /*unused*/) const { unsupported("a map"); }
+
+    [[nodiscard]] result_t on_fixed_array (const lexer::ArrayType& /*unused*/) const { unsupported("an array"); }
+
+    [[nodiscard]] result_t on_array (const lexer::ArrayType& /*unused*/) const { unsupported("an array"); }
+
+    void on_fixed_variant (const lexer::FixedVariantType& /*unused*/) const { unsupported("a variant"); }
+
+    void on_packed_variant (const lexer::PackedVariantType& /*unused*/) const { unsupported("a variant"); }
+
+    void on_dynamic_variant (const lexer::DynamicVariantType& /*unused*/) const { unsupported("a variant"); }
+
+    void on_struct (const lexer::StructDefinition& struct_definition) const {
+        struct_definition.visit_in_layout_order([](const lexer::StructField& field_data) -> const std::byte& {
+            return field_data.type().visit(SoaElementCheck<std::byte>{}).next_type;
+        });
+    }
+
+    void on_enum (const lexer::EnumDefinition& /*unused*/) const { unsupported("an enum"); }
+};
+
+/**
+ * Turns the element offsets of one pack into column offsets relative to the pack.
+ * A leaf at element offset p of a pack starting at pack_start gets the column (p - pack_start) * length, its elements
+ * follow each other with the leaf size as stride. Leafs are contiguous within the element, so are the columns.
+ */
+inline void to_soa_columns (
+    const std::span<FixedOffset> fixed_offsets,
+    const estd::integral_range<uint16_t> fixed_offset_idxs,
+    const uint64_t pack_start,
+    const uint32_t length
+) {
+    for (const uint16_t idx : fixed_offset_idxs) {
+        FixedOffset& fixed_offset = fixed_offsets[idx];
+        fixed_offset.set_offset((fixed_offset.get_offset() - pack_start) * length);
+    }
+}
+
+} // namespace layout::generation
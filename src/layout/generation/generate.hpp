@@ -6,6 +6,7 @@
 #include <gsl/pointers>
 #include <gsl/util>
 #include <span>
+#include <tuple>
 #include <type_traits>
 #include <utility>
 #include <vector>
@@ -21,7 +22,17 @@
 #include "../FixedOffsets.hpp"
 #include "../ArrayPackInfo.hpp"
 #include "./QueuedField.hpp"
+#include "./LayoutBudget.hpp"
+#include "./SharedVariants.hpp"
+#include "./CachelineConstraints.hpp"
+#include "./SoaArrays.hpp"
+#include "./BitFields.hpp"
+#include "../BitLeaf.hpp"
+#include "../OptionalLeafs.hpp"
+#include "./SizeOptimization.hpp"
+#include "../LayoutReport.hpp"
 #include "./variant_layout/variant_layout.hpp"
+#include "./variant_layout/minimal_layout.hpp"
 #include "./tvs.hpp"
 
 
@@ -63,7 +74,14 @@ struct TypeVisitor : TypeVisitorBase<State> {
         state.template next_simple<alignment>();
     }
 
-    void on_bool     () const { on_simple<lexer::FIELD_TYPE::BOOL   >(); }
+    void on_bool () const {
+        if constexpr (std::is_same_v<State, TopLevel::State>) {
+            state.next_bit_field(1);
+        } else {
+            on_simple<lexer::FIELD_TYPE::BOOL>();
+        }
+    }
+
     void on_uint8    () const { on_simple<lexer::FIELD_TYPE::UINT8  >(); }
     void on_uint16   () const { on_simple<lexer::FIELD_TYPE::UINT16 >(); }
     void on_uint32   () const { on_simple<lexer::FIELD_TYPE::UINT32 >(); }
@@ -75,11 +93,46 @@ struct TypeVisitor : TypeVisitorBase<State> {
     void on_float32  () const { on_simple<lexer::FIELD_TYPE::FLOAT32>(); }
     void on_float64  () const { on_simple<lexer::FIELD_TYPE::FLOAT64>(); }
 
+    void on_ranged_uint (const lexer::RangedUintType& ranged_uint_type) const {
+        if constexpr (std::is_same_v<State, TopLevel::State>) {
+            state.next_bit_field(ranged_uint_type.bit_width);
+        } else {
+            error_exit("Ranged integers are only supported outside of arrays and variants");
+        }
+    }
+
     void on_fixed_string (const lexer::FixedStringType& fixed_string_type) const {
         const uint32_t length = fixed_string_type.length;
         state.template next_simple<SIZE::SIZE_1>(length);
     }
 
+    void on_vector (const lexer::VectorType& vector_type) const {
+        if constexpr (std::is_same_v<State, TopLevel::State>) {
+            console.debug("[on_vector] byte_size: ", vector_type.byte_size(), ", alignment: ", vector_type.alignment);
+            state.next_vector(vector_type.byte_size(), vector_type.alignment);
+        } else {
+            error_exit("Vectors are only supported outside of arrays and variants, only the top level aligns them beyond 8 bytes");
+        }
+    }
+
+    void on_optional (const lexer::OptionalType& optional_type) const {
+        if constexpr (std::is_same_v<State, TopLevel::State>) {
+            state.next_optional(optional_type.value_size);
+        } else {
+            error_exit("Optionals are only supported outside of arrays and variants");
+        }
+    }
+
+    void on_map (const lexer::MapType& map_type) const {
+        if constexpr (std::is_same_v<State, TopLevel::State>) {
+            const SIZE alignment = map_type.alignment();
+            console.debug("[on_map] slot_count: ", map_type.slot_count, ", alignment: ", alignment);
+            state.next_simple(alignment, map_type.byte_size() / alignment.byte_size());
+        } else {
+            error_exit("Maps are only supported outside of arrays and variants");
+        }
+    }
+
     void on_string (const lexer::StringType& string_type) const {
         if constexpr (in_array) {
             error_exit("Variable length strings in arrays not supported");
@@ -99,7 +152,8 @@ struct TypeVisitor : TypeVisitorBase<State> {
         const uint16_t pack_info_base_idx,
         const uint16_t fixed_offset_idx_begin,
         const uint64_t last_offset,
-        const uint32_t array_length
+        const uint32_t array_length,
+        const bool soa
     ) const {
         if constexpr (alignment != SIZE::SIZE_8) {
             level_state.mutable_state.level().fixed_offset_idx = fixed_offset_idx_begin;
@@ -108,6 +162,11 @@ struct TypeVisitor : TypeVisitorBase<State> {
         const uint16_t fixed_offset_idx_end = level_state.mutable_state.level().fixed_offset_idx;
         const uint64_t current_offfset = level_state.mutable_state.level().current_offset;
 
+        if (soa) {
+            to_soa_columns(state.const_state.shared().fixed_offsets, {fixed_offset_idx_begin, fixed_offset_idx_end}, last_offset, array_length);
+            state.const_state.shared().pack_infos[pack_info_base_idx + alignment.ordinal()].soa = true;
+        }
+
         state.template next_array_pack<alignment>(
             (current_offfset - last_offset) * array_length,
             {fixed_offset_idx_begin, fixed_offset_idx_end},
@@ -123,12 +182,31 @@ struct TypeVisitor : TypeVisitorBase<State> {
                 pack_info_base_idx,
                 state.get_fixed_offset_idx(),
                 current_offfset,
-                array_length
+                array_length,
+                soa
             );
         }
     }
 
     [[nodiscard]] result_t on_fixed_array(lexer::ArrayType& fixed_array_type) const {
+        if (fixed_array_type.encoding != lexer::ARRAY_ENCODING::NONE) {
+            if constexpr (std::is_same_v<State, TopLevel::State>) {
+                const uint64_t leaf_count = fixed_array_type.encoded_leaf_count();
+                console.debug("[on_fixed_array] encoded, leaf_count: ", leaf_count, ", element_size: ", fixed_array_type.element_size);
+                state.next_simple(fixed_array_type.element_size, leaf_count);
+                return result_t{fixed_array_type.inner_type().template skip<const next_type_t>()};
+            } else {
+                error_exit("Delta and frame of reference encoded arrays are only supported outside of arrays and variants");
+            }
+        }
+
+        if (fixed_array_type.soa) {
+            if constexpr (!std::is_same_v<State, TopLevel::State>) {
+                error_exit("Soa arrays are only supported outside of arrays and variants");
+            }
+            std::ignore = fixed_array_type.inner_type().visit(SoaElementCheck<lexer::Type>{});
+        }
+
         const uint16_t pack_info_base_idx = state.next_pack_info_base_idx();
         fixed_array_type.pack_info_base_idx = pack_info_base_idx;
         
@@ -155,6 +233,7 @@ struct TypeVisitor : TypeVisitorBase<State> {
                 }
             }
         };
+        const auto report_scope = LayoutReport::enter_element(state.mutable_state.shared().layout_report);
         result_t result = fixed_array_type.inner_type().visit(visitor);
 
         add_fixed_array_packs<SIZE::SIZE_8>(
@@ -162,7 +241,8 @@ struct TypeVisitor : TypeVisitorBase<State> {
             pack_info_base_idx,
             fixed_offset_idx_begin,
             0,
-            fixed_array_type.length
+            fixed_array_type.length,
+            fixed_array_type.soa
         );
 
         return result;
@@ -180,7 +260,15 @@ struct TypeVisitor : TypeVisitorBase<State> {
 
         const uint16_t variant_count = fixed_variant_type.variant_count;
 
-        if (variant_count <= UINT8_MAX) {
+        SharedVariantGroup* const shared_group = fixed_variant_type.has_shared_id()
+            ? &state.mutable_state.shared().shared_variants.get(fixed_variant_type.shared_id)
+            : nullptr;
+
+        if (shared_group != nullptr && !shared_group->add_id(state.mutable_state.shared().current_map_idx, variant_count)) {
+            // The other members read the id leaf of the first one.
+            static_cast<void>(state.next_map_idx());
+            state.template skip<SIZE::SIZE_1>();
+        } else if (variant_count <= UINT8_MAX) {
             state.template next_simple<SIZE::SIZE_1>();
         } else {
             state.template next_simple<SIZE::SIZE_2>();
@@ -218,8 +306,11 @@ struct TypeVisitor : TypeVisitorBase<State> {
         
         const uint16_t fixed_offset_idx_begin_bak = state.get_fixed_offset_idx();
 
+        LayoutReport* const layout_report = state.mutable_state.shared().layout_report;
+
         const lexer::Type* type = &fixed_variant_type.first_variant();
         for (uint16_t i = 0; i < variant_count; i++) {
+            const auto report_scope = LayoutReport::enter(layout_report, "as_", i);
             const auto& type_meta = fixed_variant_type.type_metas()[i];
 
 
@@ -274,6 +365,14 @@ struct TypeVisitor : TypeVisitorBase<State> {
             max_used_space = std::max(used_space, max_used_space);
         }
 
+        std::vector<uint64_t> alternative_sizes;
+        if (layout_report != nullptr) {
+            alternative_sizes.reserve(variant_count);
+            for (const VariantLeafMeta& meta : variant_leaf_metas) {
+                alternative_sizes.push_back(meta.used_space);
+            }
+        }
+
         std::ranges::sort(variant_leaf_metas, [](const VariantLeafMeta& a, const VariantLeafMeta& b) {
             return a.used_space > b.used_space;
         });
@@ -283,18 +382,60 @@ struct TypeVisitor : TypeVisitorBase<State> {
 
         BSSERT(state.get_fixed_offset_idx() == fixed_offset_idx_begin_bak); // Inside variants no fixed_offsets should be added directy.
 
-        state.next_variant_packs(
-            variant_layout::apply_layout(
+        SizeOptimization* const size_optimization = state.mutable_state.shared().size_optimization;
+        PendingVariantFieldPacks packs;
+        if (size_optimization != nullptr) {
+            packs = variant_layout::minimal::apply_layout(
                 queued_fields_buffer,
                 state.const_state.shared().fixed_offsets,
                 state.const_state.shared().tmp_fixed_offsets,
                 variant_leaf_metas,
-                state.get_fixed_offset_idx()
-            )
-        );
+                state.get_fixed_offset_idx(),
+                *state.mutable_state.shared().layout_budget,
+                *size_optimization
+            );
+        } else {
+            packs = variant_layout::apply_layout(
+                queued_fields_buffer,
+                state.const_state.shared().fixed_offsets,
+                state.const_state.shared().tmp_fixed_offsets,
+                variant_leaf_metas,
+                state.get_fixed_offset_idx(),
+                *state.mutable_state.shared().layout_budget
+            );
+        }
+
+        if (shared_group != nullptr) {
+            const PendingVariantFieldPacks own_packs = packs;
+            if (!shared_group->add_member(packs, &state.mutable_state.level(), state.const_state.shared().fixed_offsets, state.get_fixed_offset_idx())) {
+                // The last member of the group enqueues the shared region.
+                packs = PendingVariantFieldPacks{};
+            }
+            if (layout_report != nullptr) {
+                report_variant(*layout_report, std::move(alternative_sizes), own_packs, fixed_variant_type.max_wasted_bytes);
+            }
+        } else if (layout_report != nullptr) {
+            report_variant(*layout_report, std::move(alternative_sizes), packs, fixed_variant_type.max_wasted_bytes);
+        }
+
+        state.next_variant_packs(packs);
         }
     }
 
+    static void report_variant (
+        LayoutReport& layout_report,
+        std::vector<uint64_t>&& alternative_sizes,
+        const PendingVariantFieldPacks& packs,
+        const uint64_t max_wasted_bytes
+    ) {
+        AlignSizes pack_sizes = AlignSizes::zero();
+        pack_sizes.get<SIZE::SIZE_8>() = packs.get<SIZE::SIZE_8>().first;
+        pack_sizes.get<SIZE::SIZE_4>() = packs.get<SIZE::SIZE_4>().first;
+        pack_sizes.get<SIZE::SIZE_2>() = packs.get<SIZE::SIZE_2>().first;
+        pack_sizes.get<SIZE::SIZE_1>() = packs.get<SIZE::SIZE_1>().first;
+        layout_report.add_variant(std::move(alternative_sizes), pack_sizes, max_wasted_bytes);
+    }
+
     void on_packed_variant (const lexer::PackedVariantType&  /*unused*/) const {
         error_exit("Packed variant not supported yet");
     }
@@ -304,9 +445,13 @@ struct TypeVisitor : TypeVisitorBase<State> {
     }
 
     void on_struct (const lexer::StructDefinition& struct_definition) const {
-        struct_definition.visit([&](const lexer::StructField& field_data) -> const std::byte& {
+        SharedVariantGroups& shared_variants = state.mutable_state.shared().shared_variants;
+        const uint32_t outer_struct_instance = shared_variants.enter_struct();
+        state.mutable_state.shared().field_order->visit(struct_definition, [&](const lexer::StructField& field_data) -> const std::byte& {
+            const auto report_scope = LayoutReport::enter(state.mutable_state.shared().layout_report, field_data.name);
             return field_data.type().visit(with_next<std::byte>()).next_type;
         });
+        shared_variants.leave_struct(outer_struct_instance);
     }
 
     void on_enum (const lexer::EnumDefinition& /*unused*/) const {
@@ -322,10 +467,14 @@ struct TypeVisitor : TypeVisitorBase<State> {
 struct GenerateResult {
     std::vector<uint64_t> var_offset_buffer;
     uint64_t var_leafs_start;
+    std::vector<BitLeaf> bit_leafs;     // Empty without bit fields
+    OptionalLeafs optional_leafs;
+    std::vector<uint16_t> shared_id_bases;  // First id of a shared variant by the map idx of its id, empty without them
 };
 
 [[nodiscard]] inline GenerateResult generate (
     const lexer::StructDefinition& target_struct,
+    const FieldOrder& field_order,
     const std::span<FixedOffset> fixed_offsets,
     const std::span<estd::integral_range<uint64_t>> var_offset_idx_ranges,
     const std::span<uint16_t> idx_map,
@@ -336,7 +485,10 @@ struct GenerateResult {
     const uint16_t& total_var_leafs,
     const uint16_t& level_fixed_variants,
     const uint16_t& level_fixed_arrays,
-    const uint16_t& /*unused*/
+    const uint16_t& /*unused*/,
+    LayoutBudget& layout_budget,
+    SizeOptimization* const size_optimization,
+    LayoutReport* const layout_report
 ) {    
     // uint64_t var_leaf_sizes[total_var_leafs];
     console.debug("total var leafs: ", total_var_leafs);
@@ -359,7 +511,12 @@ struct GenerateResult {
 
     TopLevel::MutableState::Data top_level_mutable_state_data {
         TopLevel::MutableState::Shared{
-            std::move(var_offset_buffer)
+            std::move(var_offset_buffer),
+            layout_budget,
+            size_optimization,
+            layout_report,
+            field_order,
+            count_shared_variants(target_struct, field_order)
         },
         TopLevel::MutableState::Level{
             (level_fixed_leafs + lexer::LeafCounts::of(level_fixed_variants + level_fixed_arrays)).counts(),
@@ -390,10 +547,41 @@ struct GenerateResult {
 
     console.debug("TopLevel:: ... left_fields: ", top_level_visitor.state.mutable_state.level().left_fields);
 
-    target_struct.visit([&top_level_visitor](const lexer::StructField& field_data) -> const std::byte& {
-        return field_data.type().visit(top_level_visitor).next_type;
+    CachelineConstraints& cacheline_constraints = top_level_mutable_state_data.shared.cacheline_constraints;
+    bool flush_hot_fields = false;
+    field_order.visit(target_struct, [&](const lexer::StructField& field_data) -> const std::byte& {
+        if (field_data.attributes.hot) {
+            flush_hot_fields = true;
+        } else if (flush_hot_fields) {
+            flush_hot_fields = false;
+            top_level_visitor.state.flush_queued();
+        }
+        const auto report_scope = LayoutReport::enter(layout_report, field_data.name);
+        const uint16_t map_idx_begin = top_level_mutable_state_data.shared.current_map_idx;
+        const uint16_t cacheline = field_data.attributes.cacheline;
+        if (cacheline != 0) top_level_visitor.state.enter_cacheline(cacheline);
+        const std::byte& next = field_data.type().visit(top_level_visitor).next_type;
+        if (cacheline != 0) top_level_visitor.state.leave_cacheline();
+        cacheline_constraints.add_field(field_data, {map_idx_begin, top_level_mutable_state_data.shared.current_map_idx});
+        return next;
     });
 
+    top_level_visitor.state.place_bit_fields();
+    std::vector<uint16_t> shared_id_bases = top_level_mutable_state_data.shared.shared_variants.finish(idx_map);
+    OptionalLeafs optional_leafs = top_level_mutable_state_data.shared.presence_bitmap.finish(
+        top_level_mutable_state_data.shared.bit_fields.leafs,
+        idx_map,
+        var_leaf_counts.largest_align()
+    );
+
+    if (!cacheline_constraints.empty()) {
+        cacheline_constraints.check();
+        console.info(
+            "Cache line constraints: ", cacheline_constraints.fields.size(), " fields, ",
+            cacheline_constraints.padding, " bytes padding"
+        );
+    }
+
     uint64_t offset = top_level_mutable_state_data.level.current_offset;
 
     console.debug("queued size: ", top_level_mutable_state_data.level.queued.fields.size());
@@ -401,12 +589,24 @@ struct GenerateResult {
     if (total_var_leafs > 0) {
         offset = math::next_multiple(offset, var_leaf_counts.largest_align());
     }
+    if (!optional_leafs.empty()) {
+        offset = math::next_multiple(offset, optional_leafs.start_alignment);
+    }
+
+    if (layout_report != nullptr) {
+        layout_report->fixed_size = offset;
+        layout_report->fixed_padding = offset - top_level_mutable_state_data.level.used_size;
+        layout_report->fixed_tail_padding = offset - top_level_mutable_state_data.level.current_offset;
+    }
 
     // visitor_state.set_var_offsets(total_var_leafs, level_size_leafs_count, 0);
 
     return {
         std::move(top_level_mutable_state_data.shared.var_offset_buffer),
-        offset
+        offset,
+        std::move(top_level_mutable_state_data.shared.bit_fields.leafs),
+        std::move(optional_leafs),
+        std::move(shared_id_bases)
     };
 }
 
@@ -17,6 +17,14 @@
 #include "../FixedOffsets.hpp"
 #include "../ArrayPackInfo.hpp"
 #include "./QueuedField.hpp"
+#include "./LayoutBudget.hpp"
+#include "./SizeOptimization.hpp"
+#include "./SharedVariants.hpp"
+#include "./CachelineConstraints.hpp"
+#include "./BitFields.hpp"
+#include "./PresenceBitmap.hpp"
+#include "../LayoutReport.hpp"
+#include "../FieldOrder.hpp"
 #include "./PendingVariantFieldPacks.hpp"
 #include "./field_queuing.hpp"
 #include "../../core/AlignSizes.hpp"
@@ -82,15 +90,30 @@ struct MutableStateBase {
         // uint16_t fixed_offset_idx_base = 0;  // The current base index for fixed sized leafs (maybe can be moved into LevelConstState if we know the total fixed leaf count including nested levels)
         uint16_t current_map_idx = 0;           // The current index into ConstState::idx_map
         uint16_t current_pack_info_idx = 0;
+        gsl::not_null<LayoutBudget*> layout_budget;
+        SizeOptimization* size_optimization;    // Search minimal size variant layouts when set
+        LayoutReport* layout_report;            // Collect variant waste when set
+        gsl::not_null<const FieldOrder*> field_order;
+        SharedVariantGroups shared_variants;
+        CachelineConstraints cacheline_constraints;
+        BitFields bit_fields;
+        PresenceBitmap presence_bitmap;
 
-        constexpr explicit Shared (
-            std::vector<uint64_t>&& var_offset_buffer
-        ) : var_offset_buffer(std::move(var_offset_buffer)) {}
+        constexpr Shared (
+            std::vector<uint64_t>&& var_offset_buffer,
+            LayoutBudget& layout_budget,
+            SizeOptimization* size_optimization,
+            LayoutReport* layout_report,
+            const FieldOrder& field_order,
+            SharedVariantGroups&& shared_variants
+        ) : var_offset_buffer(std::move(var_offset_buffer)), layout_budget(&layout_budget), size_optimization(size_optimization),
+            layout_report(layout_report), field_order(&field_order), shared_variants(std::move(shared_variants)) {}
     };
 
     struct TrivialLevel : estd::unique_only {
         Queued queued;
         uint64_t current_offset = 0;
+        uint64_t used_size = 0;     // Bytes of current_offset taken by fields, the rest is padding
         uint16_t fixed_offset_idx;
         uint16_t tmp_fixed_offset_idx;
 
@@ -311,6 +334,12 @@ public:
         this const auto& self,
         const QueuedField field
     ) {
+        if constexpr (state_type == STATE_TYPE::TOP_LEVEL) {
+            if (self.mutable_state.shared().cacheline_constraints.current_cacheline != 0) {
+                self.template enqueue_in_line<alignment>(field);
+                return;
+            }
+        }
         if constexpr (alignment == SIZE::MAX) {
             self.template enqueue_for_level_<alignment, false>(field);
             self.template decrement_left_fields<alignment>();
@@ -406,10 +435,13 @@ public:
     template <SIZE target_align, bool set_field_size_zero>
     void enqueue_for_level_ (estd::conditional_const_t<!set_field_size_zero, QueuedField>& field) const {
         MutableStateBase::TrivialLevel& level_mutable_state = mutable_state.level();
-        std::visit([this, &level_mutable_state]<typename T>(const T& arg) {
+        std::visit([this, &level_mutable_state, &field]<typename T>(const T& arg) {
             const ConstStateBase::Shared& shared_const_state = const_state.shared();
             if constexpr (std::is_same_v<SimpleField, T>) {
                 const uint16_t map_idx = arg.map_idx;
+                if constexpr (state_type == STATE_TYPE::TOP_LEVEL) {
+                    mutable_state.shared().cacheline_constraints.add_unit(level_mutable_state.current_offset, field.size, map_idx);
+                }
                 const uint16_t fixed_offset_idx = level_mutable_state.next_fixed_offset_idx();
                 const FixedOffset fo {level_mutable_state.current_offset, map_idx, target_align};
                 console.debug("fixed_offsets[", fixed_offset_idx, "] = ", fo);
@@ -432,6 +464,10 @@ public:
                     }
                 }
                 const estd::integral_range<uint16_t>& tmp_fixed_offset_idxs = arg.tmp_fixed_offset_idxs;
+                if constexpr (state_type == STATE_TYPE::TOP_LEVEL) {
+                    const uint16_t map_idx = shared_const_state.tmp_fixed_offsets[*tmp_fixed_offset_idxs.begin()].map_idx;
+                    mutable_state.shared().cacheline_constraints.add_unit(level_mutable_state.current_offset, field.size, map_idx);
+                }
                 console.debug(estd::conditionally<std::is_same_v<ArrayFieldPack, T>>("ArrayFieldPack "_sl, "VariantFieldPack "_sl) + "idxs: {from: "_sl, *tmp_fixed_offset_idxs.begin(),
                     ", to: ", *tmp_fixed_offset_idxs.end(), "}, target align: ", target_align);
                 console.debug("tmp_fixed_offsets[", *tmp_fixed_offset_idxs.begin(), " .. ", *tmp_fixed_offset_idxs.end(), "] = FixedOffset::empty() target_align: ", target_align, " (sq)");
@@ -462,6 +498,7 @@ public:
         }, field.info);
         BSSERT(field.size != 0);
         level_mutable_state.current_offset += field.size;
+        level_mutable_state.used_size += field.size;
         // TODO: Maybe implement this functionality without this NTTP
         if constexpr (set_field_size_zero) {
             // Mark for deletion from queue.
@@ -596,6 +633,129 @@ struct TopLevel {
             c--;
         }
 
+        /**
+         * Places every queued field now and pads the offset back to SIZE::MAX.
+         * Keeps the hot fields in front of the rest, at the cost of less than SIZE::MAX bytes.
+         */
+        void flush_queued () const {
+            try_solve_queued_for_align<SIZE::MAX>();
+
+            Queued& queued = mutable_state.level().queued;
+            if (queued.fields.empty()) return;
+
+            std::ranges::stable_sort(queued.fields, [](const QueuedField& a, const QueuedField& b) {
+                return a.info.alignment() > b.info.alignment();
+            });
+            for (QueuedField& field : queued.fields) {
+                field.info.alignment().visit<void>(SIZE::enums{}, []<SIZE alignment>(const State& self, QueuedField& field) {
+                    self.enqueue_for_level_<alignment, true>(field);
+                }, *this, field);
+            }
+            queued.fields.clear();
+            queued.field_size_sum = 0;
+            queued.modulated_field_size_sum = 0;
+            queued.invalidate_cached_bitset();
+
+            uint64_t& current_offset = mutable_state.level().current_offset;
+            const uint64_t aligned_offset = math::next_multiple(current_offset, SIZE::MAX);
+            console.debug("[TopLevel::flush_queued] padding: ", aligned_offset - current_offset);
+            mutable_state.shared().cacheline_constraints.padding += aligned_offset - current_offset;
+            current_offset = aligned_offset;
+        }
+
+        /**
+         * Places a unit of a `[[cacheline=N]]` field right away, aligned and moved to the next line if it would straddle
+         * one. The queue is empty while such a field is visited, so the solver never places its units unpadded.
+         */
+        template <SIZE alignment>
+        void enqueue_in_line (const QueuedField& field) const {
+            CachelineConstraints& cacheline_constraints = mutable_state.shared().cacheline_constraints;
+            uint64_t& current_offset = mutable_state.level().current_offset;
+            BSSERT(mutable_state.level().queued.fields.empty());
+            const uint64_t aligned_offset = math::next_multiple(current_offset, alignment);
+            cacheline_constraints.padding += aligned_offset - current_offset;
+            current_offset = aligned_offset;
+            cacheline_constraints.pad(current_offset, field.size);
+            enqueue_for_level_<alignment, false>(field);
+            decrement_left_fields<alignment>();
+        }
+
+        /**
+         * Starts a `[[cacheline=N]]` field on an empty queue.
+         */
+        void enter_cacheline (const uint16_t cacheline) const {
+            flush_queued();
+            mutable_state.shared().cacheline_constraints.current_cacheline = cacheline;
+        }
+
+        /**
+         * Ends a `[[cacheline=N]]` field by padding the offset back to SIZE::MAX, which the queue relies on.
+         */
+        void leave_cacheline () const {
+            mutable_state.shared().cacheline_constraints.current_cacheline = 0;
+            uint64_t& current_offset = mutable_state.level().current_offset;
+            const uint64_t aligned_offset = math::next_multiple(current_offset, SIZE::MAX);
+            mutable_state.shared().cacheline_constraints.padding += aligned_offset - current_offset;
+            current_offset = aligned_offset;
+        }
+
+        /**
+         * Takes the map_idx of a bool or ranged integer, its word is placed by place_bit_fields.
+         * The lexer counts the field as a leaf of SIZE_1, so that count is skipped.
+         */
+        void next_bit_field (const uint8_t width) const {
+            mutable_state.shared().bit_fields.add(next_map_idx(), width);
+            skip<SIZE::SIZE_1>();
+        }
+
+        /**
+         * Takes the map_idx of an optional, its presence bit is placed with the bit fields. The value is not part of the
+         * fixed leafs.
+         */
+        void next_optional (const SIZE value_size) const {
+            mutable_state.shared().presence_bitmap.add(next_map_idx(), value_size);
+            skip<SIZE::SIZE_1>();
+        }
+
+        /**
+         * Places the words of all bit fields behind the other fixed leafs. The map_idx of a word's first field gets the
+         * fixed offset, the other fields of the word share it.
+         */
+        void place_bit_fields () const {
+            BitFields& bit_fields = mutable_state.shared().bit_fields;
+            const PresenceBitmap& presence_bitmap = mutable_state.shared().presence_bitmap;
+            if (!presence_bitmap.empty()) {
+                presence_bitmap.add_to(bit_fields);
+            }
+            if (bit_fields.empty()) return;
+
+            const std::span<uint16_t> idx_map = const_state.shared().idx_map;
+            for (const BitFields::Word& word : bit_fields.pack(idx_map.size())) {
+                const uint16_t first_map_idx = word.fields.front().map_idx;
+                word.size.visit<void>(SIZE::enums{}, []<SIZE alignment>(const State& self, const uint16_t map_idx) {
+                    uint64_t& current_offset = self.mutable_state.level().current_offset;
+                    current_offset = math::next_multiple(current_offset, alignment);
+                    self.enqueue_for_level_<alignment, false>(QueuedField{alignment.byte_size(), SimpleField{map_idx, alignment}});
+                }, *this, first_map_idx);
+                for (const BitFields::Field& field : word.fields) {
+                    idx_map[field.map_idx] = idx_map[first_map_idx];
+                }
+            }
+        }
+
+        /**
+         * Places a vector right away, padded to its alignment. The offset is aligned to SIZE::MAX already, so the padding
+         * is a multiple of it and the queued fields are not affected.
+         */
+        void next_vector (const uint64_t byte_size, const uint8_t alignment) const {
+            uint64_t& current_offset = mutable_state.level().current_offset;
+            mutable_state.shared().cacheline_constraints.pad(current_offset, byte_size);
+            const uint64_t aligned_offset = math::next_multiple<uint64_t, estd::discouraged>(current_offset, alignment);
+            console.debug("[TopLevel::next_vector] padding: ", aligned_offset - current_offset);
+            current_offset = aligned_offset;
+            next_simple<SIZE::MAX>(byte_size / SIZE::MAX.byte_size());
+        }
+
         template <SIZE alignment>
         void try_solve_queued () const {
             const SIZE largest_align = mutable_state.level().left_fields.largest_align();
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <variant>
+#include <vector>
+
+#include "../../../estd/ranges.hpp"
+#include "../../FixedOffsets.hpp"
+#include "../QueuedField.hpp"
+#include "../VariantLeafMeta.hpp"
+
+namespace layout::generation::variant_layout {
+
+/**
+ * Takes back layouts of the fields of one variant group.
+ * Laying out a field zeroes its size, clears its temporary fixed offsets and appends fixed offsets. So the sizes and
+ * temporary fixed offsets are saved once up front, a mark only logs which fields were still left and the metas.
+ * Fields whose size is zero up front are never laid out, they count as applied.
+ */
+struct LayoutUndo {
+    struct Mark {
+        uint32_t left_fields_begin;
+        uint32_t left_fields_end;
+        uint32_t metas_begin;
+        uint16_t fixed_offset_idx;
+    };
+
+    std::span<QueuedField> queued_fields_buffer;
+    std::span<FixedOffset> fixed_offsets;
+    std::span<FixedOffset> tmp_fixed_offsets;
+    std::span<VariantLeafMeta> variant_leaf_metas;
+    estd::integral_range<uint16_t> field_idxs;
+    std::vector<uint64_t> field_sizes;              // Indexed by field_idx - field_idxs.begin
+    std::vector<FixedOffset> field_tmp_fixed_offsets;
+    std::vector<uint32_t> field_tmp_starts;         // Indexed like field_sizes, one more for the end
+    std::vector<uint16_t> left_fields;              // Stack of the fields left at each mark
+    std::vector<VariantLeafMeta> metas;             // Stack of the metas at each mark
+
+    LayoutUndo (
+        const std::span<QueuedField> queued_fields_buffer,
+        const std::span<FixedOffset> fixed_offsets,
+        const std::span<FixedOffset> tmp_fixed_offsets,
+        const std::span<VariantLeafMeta> variant_leaf_metas
+    ) :
+    queued_fields_buffer(queued_fields_buffer),
+    fixed_offsets(fixed_offsets),
+    tmp_fixed_offsets(tmp_fixed_offsets),
+    variant_leaf_metas(variant_leaf_metas),
+    field_idxs(group_field_idxs(variant_leaf_metas))
+    {
+        field_sizes.reserve(field_idxs.size());
+        field_tmp_starts.reserve(field_idxs.size() + 1);
+        for (const uint16_t field_idx : field_idxs) {
+            const QueuedField& field = queued_fields_buffer[field_idx];
+            field_sizes.push_back(field.size);
+            field_tmp_starts.push_back(static_cast<uint32_t>(field_tmp_fixed_offsets.size()));
+            if (const estd::integral_range<uint16_t>* const tmp_idxs = tmp_fixed_offset_idxs(field)) {
+                const std::span<FixedOffset> tmp = tmp_idxs->access_subspan(tmp_fixed_offsets);
+                field_tmp_fixed_offsets.insert(field_tmp_fixed_offsets.end(), tmp.begin(), tmp.end());
+            }
+        }
+        field_tmp_starts.push_back(static_cast<uint32_t>(field_tmp_fixed_offsets.size()));
+    }
+
+    [[nodiscard]] static estd::integral_range<uint16_t> group_field_idxs (const std::span<const VariantLeafMeta> variant_leaf_metas) {
+        uint16_t begin = static_cast<uint16_t>(-1);
+        uint16_t end = 0;
+        for (const VariantLeafMeta& meta : variant_leaf_metas) {
+            begin = std::min(begin, *meta.field_idxs.begin());
+            end = std::max(end, *meta.field_idxs.end());
+        }
+        return {begin, end};
+    }
+
+    [[nodiscard]] static const estd::integral_range<uint16_t>* tmp_fixed_offset_idxs (const QueuedField& field) {
+        if (const auto* const pack = std::get_if<ArrayFieldPack>(&field.info)) return &pack->tmp_fixed_offset_idxs;
+        if (const auto* const pack = std::get_if<VariantFieldPack>(&field.info)) return &pack->tmp_fixed_offset_idxs;
+        return nullptr;
+    }
+
+    /**
+     * Marks the current state, fixed offsets from fixed_offset_idx on are the ones laid out after it.
+     */
+    [[nodiscard]] Mark mark (const uint16_t fixed_offset_idx) {
+        const auto left_fields_begin = static_cast<uint32_t>(left_fields.size());
+        for (const uint16_t field_idx : field_idxs) {
+            if (queued_fields_buffer[field_idx].size != 0) left_fields.push_back(field_idx);
+        }
+        const auto metas_begin = static_cast<uint32_t>(metas.size());
+        metas.insert(metas.end(), variant_leaf_metas.begin(), variant_leaf_metas.end());
+        return {left_fields_begin, static_cast<uint32_t>(left_fields.size()), metas_begin, fixed_offset_idx};
+    }
+
+    /**
+     * Returns to the marked state, from before or after it. Marks stay valid until released.
+     */
+    void undo (const Mark& mark) {
+        uint32_t left_idx = mark.left_fields_begin;
+        for (const uint16_t field_idx : field_idxs) {
+            const size_t idx = field_idx - *field_idxs.begin();
+            const bool is_left = left_idx != mark.left_fields_end && left_fields[left_idx] == field_idx;
+            if (is_left) left_idx++;
+            QueuedField& field = queued_fields_buffer[field_idx];
+            field.size = is_left ? field_sizes[idx] : 0;
+            if (const estd::integral_range<uint16_t>* const tmp_idxs = tmp_fixed_offset_idxs(field)) {
+                const std::span<FixedOffset> tmp = tmp_idxs->access_subspan(tmp_fixed_offsets);
+                if (is_left) {
+                    std::copy(field_tmp_fixed_offsets.begin() + field_tmp_starts[idx], field_tmp_fixed_offsets.begin() + field_tmp_starts[idx + 1], tmp.begin());
+                } else if (field_sizes[idx] != 0) {
+                    std::ranges::fill(tmp, FixedOffset::empty());
+                }
+            }
+        }
+        std::copy_n(metas.begin() + mark.metas_begin, variant_leaf_metas.size(), variant_leaf_metas.begin());
+        for (size_t idx = mark.fixed_offset_idx; idx != fixed_offsets.size() && fixed_offsets[idx] != FixedOffset::empty(); idx++) {
+            fixed_offsets[idx] = FixedOffset::empty();
+        }
+    }
+
+    /**
+     * Drops the mark and every mark taken after it.
+     */
+    void release (const Mark& mark) {
+        left_fields.resize(mark.left_fields_begin);
+        metas.resize(mark.metas_begin);
+    }
+};
+
+} // namespace layout::generation::variant_layout
@@ -0,0 +1,353 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <gsl/util>
+#include <memory>
+#include <span>
+#include <tuple>
+#include <vector>
+
+#include "../../../core/SIZE.hpp"
+#include "../../../math/multiples.hpp"
+#include "../../../subset_sum_solving/dp_bitset_base.hpp"
+#include "../../../util/logger.hpp"
+#include "../../FixedOffsets.hpp"
+#include "../QueuedField.hpp"
+#include "../VariantLeafMeta.hpp"
+#include "../LayoutBudget.hpp"
+#include "../SizeOptimization.hpp"
+#include "../PendingVariantFieldPacks.hpp"
+#include "./LayoutUndo.hpp"
+#include "./variant_layout.hpp"
+
+namespace layout::generation::variant_layout::minimal {
+
+/**
+ * Size of the packs as they take space in the parent, every pack rounded up to its alignment.
+ */
+[[nodiscard]] inline uint64_t aligned_packs_size (const PendingVariantFieldPacks& packs) {
+    return math::next_multiple(packs.get<SIZE::SIZE_8>().first, SIZE::SIZE_8)
+         + math::next_multiple(packs.get<SIZE::SIZE_4>().first, SIZE::SIZE_4)
+         + math::next_multiple(packs.get<SIZE::SIZE_2>().first, SIZE::SIZE_2)
+         + packs.get<SIZE::SIZE_1>().first;
+}
+
+/**
+ * Branch and bound over every placement of the fields into the packs of alignment 8, 4, 2 and 1.
+ * A field goes into any pack whose alignment is at least its own and counts with its size rounded up to its alignment.
+ * Within a pack fields are placed by decreasing alignment, so a variant fits a pack if the sizes of its fields there sum
+ * up to at most the pack size.
+ * The search picks the size of the packs from the biggest alignment down. Sizes no variant could fill up to the last
+ * alignment step are skipped, and so is a size once the subset sums of the fields still fitting into each pack leave a
+ * variant with more than the best layout has room for. With the sizes of the aligned packs fixed, every variant keeps the
+ * fields it can not fit there as small as possible, the biggest of them makes the byte pack.
+ * A finished search found the smallest layout of the fields into packs.
+ */
+struct Search {
+    static constexpr uint8_t pack_count = 4;    // The packs of alignment 8, 4, 2 and 1 in that order
+    static constexpr uint8_t last_pack = pack_count - 1;
+    static constexpr uint64_t budget_check_interval = 4096;
+
+    struct Item {
+        uint16_t field_idx;
+        SIZE alignment;
+        uint8_t last_pack;      // Pack of the smallest alignment the field still fits into
+        uint64_t size;          // Rounded up to the alignment
+    };
+
+    struct Variant {
+        std::vector<Item> items;                    // Biggest first
+        uint64_t total = 0;
+        std::array<uint64_t, pack_count> needs {};  // Size of the fields which only fit up to each pack
+        uint64_t word_count = 0;
+        std::unique_ptr<dp_bitset_base::word_t[]> sums;     // Subset sums of the fields fitting into each pack
+        std::vector<uint8_t> packs;                 // Pack of each item while fitting
+        std::vector<uint8_t> fit_packs;             // Best fit of the current pack sizes
+        std::vector<uint8_t> best_packs;            // Fit of the best layout
+
+        [[nodiscard]] dp_bitset_base::word_t* pack_sums (const uint8_t pack) const {
+            return sums.get() + (word_count * pack);
+        }
+
+        // Most the fields fitting into pack can fill of space.
+        [[nodiscard]] uint64_t max_sum (const uint8_t pack, const uint64_t space) const {
+            for (uint64_t sum = std::min(space, total);; sum--) {
+                if (dp_bitset_base::bit_at(pack_sums(pack), sum)) return sum;
+            }
+        }
+    };
+
+    struct Fit {
+        std::array<uint64_t, last_pack> left;   // Space left in the aligned packs
+        uint64_t best;                          // Smallest byte pack so far
+        uint64_t good_enough;                   // Byte pack another variant needs anyway
+    };
+
+    std::vector<Variant> variants;
+    const LayoutBudget& layout_budget;
+    uint64_t lower_bound = 0;
+    uint64_t best_size = static_cast<uint64_t>(-1);
+    std::array<uint64_t, pack_count> sizes {};
+    std::array<uint64_t, pack_count> best_sizes {};
+    uint64_t explored_nodes = 0;
+    bool found = false;
+    bool finished = true;
+
+    [[nodiscard]] static constexpr uint64_t pack_alignment (const uint8_t pack) {
+        return uint64_t{8} >> pack;
+    }
+
+    [[nodiscard]] static constexpr uint8_t item_last_pack (const SIZE alignment) {
+        return gsl::narrow_cast<uint8_t>(last_pack - alignment.ordinal());
+    }
+
+    void add_variant (const std::span<const QueuedField> queued_fields_buffer, const VariantLeafMeta& meta) {
+        Variant& variant = variants.emplace_back();
+        for (const uint16_t field_idx : meta.field_idxs) {
+            const QueuedField& field = queued_fields_buffer[field_idx];
+            if (field.size == 0) continue;
+            const SIZE alignment = field.info.alignment();
+            variant.items.push_back({field_idx, alignment, item_last_pack(alignment), math::next_multiple(field.size, alignment)});
+        }
+        std::ranges::stable_sort(variant.items, [](const Item& a, const Item& b) { return a.size > b.size; });
+
+        for (const Item& item : variant.items) {
+            variant.total += item.size;
+            for (uint8_t pack = item.last_pack; pack != pack_count; pack++) variant.needs[pack] += item.size;
+        }
+
+        variant.word_count = dp_bitset_base::bitset_word_count(variant.total);
+        variant.sums = std::make_unique_for_overwrite<dp_bitset_base::word_t[]>(variant.word_count * pack_count);
+        for (uint8_t pack = 0; pack != pack_count; pack++) {
+            dp_bitset_base::init_bits(variant.pack_sums(pack), variant.word_count);
+            for (const Item& item : variant.items) {
+                if (item.last_pack >= pack) dp_bitset_base::apply_num_unsafe(item.size, variant.pack_sums(pack), variant.word_count);
+            }
+        }
+
+        variant.packs.resize(variant.items.size());
+        variant.fit_packs.resize(variant.items.size());
+        lower_bound = std::max(lower_bound, variant.total);
+    }
+
+    [[nodiscard]] bool done () const {
+        return best_size <= lower_bound || !finished;
+    }
+
+    void count_node () {
+        explored_nodes++;
+        if (explored_nodes % budget_check_interval == 0 && layout_budget.exhausted()) finished = false;
+    }
+
+    /**
+     * Places the items from item_idx on into the aligned packs or the byte pack, with as little in the byte pack as possible.
+     */
+    void fit (Fit& fit_state, Variant& variant, const size_t item_idx, const uint64_t byte_size, const uint64_t rest) {
+        count_node();
+        if (!finished) return;
+        const uint64_t left = fit_state.left[0] + fit_state.left[1] + fit_state.left[2];
+        if (byte_size + (rest > left ? rest - left : 0) >= fit_state.best) return;
+
+        if (item_idx == variant.items.size()) {
+            fit_state.best = byte_size;
+            variant.fit_packs = variant.packs;
+            return;
+        }
+
+        const Item& item = variant.items[item_idx];
+        for (uint8_t pack = 0; pack != std::min(static_cast<uint8_t>(item.last_pack + 1), last_pack); pack++) {
+            if (item.size > fit_state.left[pack]) continue;
+            fit_state.left[pack] -= item.size;
+            variant.packs[item_idx] = pack;
+            fit(fit_state, variant, item_idx + 1, byte_size, rest - item.size);
+            fit_state.left[pack] += item.size;
+            if (fit_state.best <= fit_state.good_enough) return;
+        }
+        if (item.last_pack == last_pack) {
+            variant.packs[item_idx] = last_pack;
+            fit(fit_state, variant, item_idx + 1, byte_size + item.size, rest - item.size);
+        }
+    }
+
+    void search_byte_pack (const uint64_t prefix) {
+        uint64_t byte_size = 0;
+        for (Variant& variant : variants) {
+            Fit fit_state {{sizes[0], sizes[1], sizes[2]}, best_size - prefix, byte_size};
+            fit(fit_state, variant, 0, 0, variant.total);
+            if (fit_state.best >= best_size - prefix) return;
+            byte_size = std::max(byte_size, fit_state.best);
+        }
+
+        sizes[last_pack] = byte_size;
+        console.debug("[minimal_layout] new best size: ", prefix + byte_size, " (was ", best_size, ")");
+        best_size = prefix + byte_size;
+        best_sizes = sizes;
+        found = true;
+        for (Variant& variant : variants) variant.best_packs = variant.fit_packs;
+    }
+
+    void search (const uint8_t pack, const uint64_t prefix) {
+        count_node();
+        if (pack == last_pack) {
+            search_byte_pack(prefix);
+            return;
+        }
+
+        const uint64_t alignment = pack_alignment(pack);
+        uint64_t need = 0;
+        uint64_t max_size = 0;
+        for (const Variant& variant : variants) {
+            need = std::max(need, variant.needs[pack]);
+            max_size = std::max(max_size, variant.max_sum(pack, variant.total));
+        }
+        const uint64_t min_size = need > prefix ? math::next_multiple<uint64_t, estd::discouraged>(need - prefix, alignment) : 0;
+
+        for (uint64_t size = math::next_multiple<uint64_t, estd::discouraged>(max_size, alignment); size >= min_size; size -= alignment) {
+            if (prefix + size < best_size) {
+                sizes[pack] = size;
+                // Some variant has to fill the last alignment step, the left over fields of every variant have to fit after the pack.
+                bool filled = size == 0;
+                uint64_t max_left = 0;
+                for (const Variant& variant : variants) {
+                    filled = filled || variant.max_sum(pack, size) > size - alignment;
+                    uint64_t placed = 0;
+                    for (uint8_t prev_pack = 0; prev_pack <= pack; prev_pack++) placed += variant.max_sum(prev_pack, sizes[prev_pack]);
+                    max_left = std::max(max_left, variant.total - std::min(placed, variant.total));
+                }
+                if (filled && prefix + size + max_left < best_size) {
+                    search(pack + 1, prefix + size);
+                    if (done()) return;
+                }
+            }
+            if (size == 0) break;
+        }
+    }
+
+    template <SIZE alignment>
+    [[nodiscard]] PendingVariantFieldPacks apply (
+        const std::span<QueuedField> queued_fields_buffer,
+        const std::span<FixedOffset> fixed_offsets,
+        const std::span<FixedOffset> tmp_fixed_offsets,
+        const std::span<VariantLeafMeta> variant_leaf_metas,
+        uint16_t fixed_offset_idx,
+        PendingVariantFieldPacks packs
+    ) const {
+        constexpr uint8_t pack = item_last_pack(alignment);
+
+        const uint16_t fixed_offset_idx_begin = fixed_offset_idx;
+        uint64_t max_offset = 0;
+        for (size_t variant_idx = 0; variant_idx != variants.size(); variant_idx++) {
+            const Variant& variant = variants[variant_idx];
+            VariantLeafMeta& meta = variant_leaf_metas[variant_idx];
+            uint64_t offset = 0;
+
+            for (const SIZE field_alignment : {SIZE::SIZE_8, SIZE::SIZE_4, SIZE::SIZE_2, SIZE::SIZE_1}) {
+                for (size_t item_idx = 0; item_idx != variant.items.size(); item_idx++) {
+                    const Item& item = variant.items[item_idx];
+                    if (variant.best_packs[item_idx] != pack || item.alignment != field_alignment) continue;
+
+                    QueuedField& field = queued_fields_buffer[item.field_idx];
+                    meta.left_fields.get<estd::discouraged>(field_alignment)--;
+                    meta.required_spaces.get<estd::discouraged>(field_alignment) -= field.size;
+
+                    std::tie(fixed_offset_idx, offset) = apply_field<alignment>(
+                        field,
+                        math::next_multiple(offset, field_alignment),
+                        fixed_offset_idx,
+                        fixed_offsets,
+                        tmp_fixed_offsets
+                    );
+                }
+            }
+
+            max_offset = std::max(offset, max_offset);
+        }
+
+        if (max_offset == 0) {
+            packs.get<alignment>() = {0, {0, 0}};
+        } else {
+            console.debug("packs.get<", alignment, ">() = {", max_offset, ", ", "{", fixed_offset_idx_begin, ", ", fixed_offset_idx, "}} (minimal)" );
+            packs.get<alignment>() = {max_offset, {fixed_offset_idx_begin, fixed_offset_idx}};
+        }
+
+        if constexpr (alignment > SIZE::SIZE_1) {
+            return apply<alignment.next_smaller()>(
+                queued_fields_buffer,
+                fixed_offsets,
+                tmp_fixed_offsets,
+                variant_leaf_metas,
+                fixed_offset_idx,
+                packs
+            );
+        } else {
+            return packs;
+        }
+    }
+};
+
+/**
+ * Lays out the variants with the smallest size of their packs the search finds.
+ * Starts from the default layout and keeps it, unless the search finds a smaller one.
+ */
+[[nodiscard]] inline PendingVariantFieldPacks apply_layout (
+    const std::span<QueuedField> queued_fields_buffer,
+    const std::span<FixedOffset> fixed_offsets,
+    const std::span<FixedOffset> tmp_fixed_offsets,
+    const std::span<VariantLeafMeta> variant_leaf_metas,
+    const uint16_t fixed_offset_idx_begin,
+    LayoutBudget& layout_budget,
+    SizeOptimization& size_optimization
+) {
+    const uint64_t max_used_space = variant_leaf_metas[0].used_space;
+
+    Search search {{}, layout_budget};
+    search.variants.reserve(variant_leaf_metas.size());
+    for (const VariantLeafMeta& meta : variant_leaf_metas) {
+        search.add_variant(queued_fields_buffer, meta);
+    }
+
+    LayoutUndo undo {queued_fields_buffer, fixed_offsets, tmp_fixed_offsets, variant_leaf_metas};
+    const LayoutUndo::Mark initial = undo.mark(fixed_offset_idx_begin);
+
+    // The default layout is the incumbent. Its greedy fallbacks are not reported, the search may still improve on them.
+    LayoutBudget default_layout_budget = layout_budget;
+    PendingVariantFieldPacks packs = variant_layout::apply_layout(
+        queued_fields_buffer,
+        fixed_offsets,
+        tmp_fixed_offsets,
+        variant_leaf_metas,
+        fixed_offset_idx_begin,
+        default_layout_budget
+    );
+    const uint64_t default_size = aligned_packs_size(packs);
+
+    search.best_size = default_size;
+    if (!search.done()) {
+        search.search(0, 0);
+    }
+
+    if (search.found) {
+        undo.undo(initial);
+        packs = search.apply<SIZE::SIZE_8>(
+            queued_fields_buffer,
+            fixed_offsets,
+            tmp_fixed_offsets,
+            variant_leaf_metas,
+            fixed_offset_idx_begin,
+            {}
+        );
+    }
+    undo.release(initial);
+
+    const uint64_t best_size = aligned_packs_size(packs);
+    console.debug("[minimal_layout] size: ", best_size, " default: ", default_size, " lower bound: ", max_used_space, " nodes: ", search.explored_nodes);
+
+    size_optimization.explored_nodes += search.explored_nodes;
+    size_optimization.record(default_size, best_size, max_used_space, search.finished);
+
+    return packs;
+}
+
+} // namespace layout::generation::variant_layout::minimal
@@ -5,6 +5,7 @@
 
 #include "../QueuedField.hpp"
 #include "../VariantLeafMeta.hpp"
+#include "../LayoutBudget.hpp"
 
 #include "./sum_intersection_dp_bitset.hpp"
 
@@ -19,7 +20,8 @@ requires (alignment != SIZE::SIZE_1)
     const std::span<const VariantLeafMeta> variant_leaf_metas,
     const std::span<const QueuedField> queued_fields_buffer,
     const uint64_t max_used_space,
-    const uint64_t min_offset
+    const uint64_t min_offset,
+    const LayoutBudget& layout_budget
 ) {
     constexpr uint8_t alignement_bytes = alignment.byte_size();
     if (std::ranges::all_of(variant_leaf_metas, [](const VariantLeafMeta& e) {
@@ -58,6 +60,10 @@ requires (alignment != SIZE::SIZE_1)
             console.debug("could not find perfect layout at align", alignement_bytes);
             return {applied_variants, 0};
         }
+        if (layout_budget.exhausted()) {
+            console.debug("layout budget exhausted at align", alignement_bytes);
+            return {applied_variants, 0};
+        }
         target -= alignement_bytes;
     }
 }
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <cstdint>
+#include <span>
+
 #include "../../../subset_sum_solving/dp_bitset_base.hpp"
 #include "../QueuedField.hpp"
 #include "../VariantLeafMeta.hpp"
@@ -17,12 +20,21 @@ inline void generate_bits (
 
     dp_bitset_base::init_bits(bits, bitset_words);
 
+    num_t batch[dp_bitset_base::APPLY_BATCH_SIZE];
+    uint8_t batch_size = 0;
+
     for (const QueuedField& field : meta.field_idxs.access_subrange(queued_fields_buffer)) {
         auto num = field.size;
         if (num == 0) continue;
         BSSERT(num <= meta.used_space);
-        dp_bitset_base::apply_num_unsafe(num, bits, bitset_words);
+        batch[batch_size++] = num;
+        if (batch_size == dp_bitset_base::APPLY_BATCH_SIZE) {
+            dp_bitset_base::apply_nums_unsafe(batch, bits, bitset_words);
+            batch_size = 0;
+        }
     }
+
+    dp_bitset_base::apply_nums_unsafe({batch, batch_size}, bits, bitset_words);
 }
 
 } // namespace layout::generation::variant_layout::sum_intersection_dp_bitset
\ No newline at end of file
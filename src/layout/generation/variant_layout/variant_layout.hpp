@@ -10,11 +10,14 @@
 #include <utility>
 #include <variant>
 
+#include "../../../core/AlignSizes.hpp"
 #include "../../../util/logger.hpp"
 #include "../../FixedOffsets.hpp"
 #include "../QueuedField.hpp"
+#include "../LayoutBudget.hpp"
 #include "../PendingVariantFieldPacks.hpp"
 #include "../field_queuing.hpp"
+#include "./LayoutUndo.hpp"
 #include "./perfect_st.hpp"
 
 namespace layout::generation::variant_layout {
@@ -346,6 +349,167 @@ template <SIZE alignment, bool has_pre_selected>
 }
 
 
+/**
+ * Lays out the section of `layout_space` bytes in every variant. It holds all left fields of `alignment`
+ * and is filled up with smaller aligned fields where possible.
+ */
+template <SIZE alignment>
+requires (alignment != SIZE::SIZE_1)
+[[nodiscard]] inline uint16_t apply_section_ (
+    const uint64_t layout_space,
+    const std::span<QueuedField> queued_fields_buffer,
+    const std::span<FixedOffset> fixed_offsets,
+    const std::span<FixedOffset> tmp_fixed_offsets,
+    const std::span<VariantLeafMeta> variant_leaf_metas,
+    const uint16_t fixed_offset_idx_begin,
+    PendingVariantFieldPacks& packs
+) {
+    console.debug("[apply_layout] alignemnt: ", alignment);
+
+    uint16_t fixed_offset_idx = fixed_offset_idx_begin;
+    uint64_t max_offset = 0;
+    for (VariantLeafMeta& meta : variant_leaf_metas) {            
+        uint64_t offset = 0;
+        
+        const uint16_t pre_selected_count = meta.left_fields.get<alignment>();
+        
+        
+        if (pre_selected_count > 0) {
+            std::pair<uint16_t, uint64_t> pre_selected_buffer[pre_selected_count];
+            std::span<std::pair<uint16_t, uint64_t>> pre_selected {pre_selected_buffer, pre_selected_count};
+            uint16_t pre_slected_idx = 0;
+            
+            uint64_t required = 0; // Only used for assert at this point
+
+            for (const uint16_t& field_idx : meta.field_idxs) {
+                // console.debug("pre select checking field at: ", field_idx);
+                QueuedField& field = queued_fields_buffer[field_idx];
+                BSSERT(field.size != ~uint64_t{0});
+
+                if constexpr (alignment != SIZE::SIZE_8) {
+                    if (field.size == 0) continue;
+                } else {
+                    BSSERT(field.size != 0);
+                }
+
+                if (field.info.alignment() != alignment) continue;
+
+                // console.debug("pre selected field with size: ", field.size, " from idx: ", field_idx);
+
+                required += field.size;
+                meta.left_fields.get<alignment>()--;
+
+                pre_selected[pre_slected_idx++] = {field_idx, field.size};
+
+                // Mark as tracked
+                field.size = 0;
+            }
+
+            BSSERT(meta.left_fields.get<alignment>() == 0);
+            BSSERT(meta.required_spaces.get<alignment>() == required);
+
+            std::tie(fixed_offset_idx, offset) = solve_and_apply<alignment, true>(
+                layout_space,
+                meta,
+                offset,
+                fixed_offset_idx,
+                fixed_offsets,
+                tmp_fixed_offsets,
+                queued_fields_buffer,
+                pre_selected
+            );
+        } else {
+            std::tie(fixed_offset_idx, offset) = solve_and_apply<alignment, false>(
+                layout_space,
+                meta,
+                offset,
+                fixed_offset_idx,
+                fixed_offsets,
+                tmp_fixed_offsets,
+                queued_fields_buffer
+            );
+        }
+
+        max_offset = std::max(offset, max_offset);
+    }
+
+    // state.template next_variant_pack<alignment>(max_offset, {fixed_offset_idx_begin, fixed_offset_idx});
+    console.debug("packs.get<", alignment, ">() = {", max_offset, ", ", "{", fixed_offset_idx_begin, ", ", fixed_offset_idx, "}}" );
+    packs.get<alignment>() = {max_offset, {fixed_offset_idx_begin, fixed_offset_idx}};
+
+    return fixed_offset_idx;
+}
+
+[[nodiscard]] inline uint64_t packs_size (const PendingVariantFieldPacks& packs) {
+    return packs.get<SIZE::SIZE_8>().first
+         + packs.get<SIZE::SIZE_4>().first
+         + packs.get<SIZE::SIZE_2>().first
+         + packs.get<SIZE::SIZE_1>().first;
+}
+
+/**
+ * Fallback for when no perfect layout was found, either because there is none or the layout budget ran out.
+ * Every variant places its left fields of an alignment back to back, so each pack is as big as the largest share of that alignment.
+ */
+template <SIZE alignment>
+[[nodiscard]] inline PendingVariantFieldPacks apply_greedy_layout_ (
+    const std::span<QueuedField> queued_fields_buffer,
+    const std::span<FixedOffset> fixed_offsets,
+    const std::span<FixedOffset> tmp_fixed_offsets,
+    const std::span<VariantLeafMeta> variant_leaf_metas,
+    uint16_t fixed_offset_idx,
+    PendingVariantFieldPacks packs
+) {
+    console.debug("[apply_greedy_layout] alignemnt: ", alignment);
+
+    const uint16_t fixed_offset_idx_begin = fixed_offset_idx;
+    uint64_t max_offset = 0;
+    for (VariantLeafMeta& meta : variant_leaf_metas) {
+        uint64_t offset = 0;
+
+        for (const uint16_t& field_idx : meta.field_idxs) {
+            QueuedField& field = queued_fields_buffer[field_idx];
+            if (field.size == 0 || field.info.alignment() != alignment) continue;
+
+            meta.left_fields.get<alignment>()--;
+            meta.required_spaces.get<alignment>() -= field.size;
+
+            std::tie(fixed_offset_idx, offset) = apply_field<alignment>(
+                field,
+                offset,
+                fixed_offset_idx,
+                fixed_offsets,
+                tmp_fixed_offsets
+            );
+        }
+
+        BSSERT(meta.left_fields.get<alignment>() == 0);
+        BSSERT(meta.required_spaces.get<alignment>() == 0);
+
+        max_offset = std::max(offset, max_offset);
+    }
+
+    if (max_offset == 0) {
+        packs.get<alignment>() = {0, {0, 0}};
+    } else {
+        console.debug("packs.get<", alignment, ">() = {", max_offset, ", ", "{", fixed_offset_idx_begin, ", ", fixed_offset_idx, "}} (greedy)" );
+        packs.get<alignment>() = {max_offset, {fixed_offset_idx_begin, fixed_offset_idx}};
+    }
+
+    if constexpr (alignment > SIZE::SIZE_1) {
+        return apply_greedy_layout_<alignment.next_smaller()>(
+            queued_fields_buffer,
+            fixed_offsets,
+            tmp_fixed_offsets,
+            variant_leaf_metas,
+            fixed_offset_idx,
+            packs
+        );
+    } else {
+        return packs;
+    }
+}
+
 template <SIZE alignment>
 requires (alignment == SIZE::SIZE_1)
 [[nodiscard]] inline PendingVariantFieldPacks apply_layout_ (
@@ -359,7 +523,8 @@ requires (alignment == SIZE::SIZE_1)
     const uint64_t max_used_space,
     const uint16_t fixed_offset_idx_begin,
     const uint64_t prev_layout_end,
-    PendingVariantFieldPacks packs
+    PendingVariantFieldPacks packs,
+    LayoutBudget& /*unused*/
 ) {
     if (std::ranges::all_of(variant_leaf_metas, [](const VariantLeafMeta& e) {
         return e.required_spaces.get<SIZE::SIZE_1>() == 0; 
@@ -439,7 +604,8 @@ requires (alignment != SIZE::SIZE_1)
     const uint64_t max_used_space,
     const uint16_t fixed_offset_idx_begin,
     const uint64_t prev_layout_end,
-    PendingVariantFieldPacks packs
+    PendingVariantFieldPacks packs,
+    LayoutBudget& layout_budget
 ) {
 
     const uint64_t min_space = std::ranges::max(
@@ -461,7 +627,8 @@ requires (alignment != SIZE::SIZE_1)
             max_used_space,
             fixed_offset_idx_begin,
             prev_layout_end,
-            packs
+            packs,
+            layout_budget
         );
     }
     
@@ -475,87 +642,35 @@ requires (alignment != SIZE::SIZE_1)
         variant_leaf_metas,
         queued_fields_buffer,
         max_used_space,
-        prev_layout_end + min_space
+        prev_layout_end + min_space,
+        layout_budget
     );
     applied_variants = found.first;
     uint64_t layout_end = found.second;
 
-    BSSERT(layout_end != 0, "Non perfect variant layouts disabled for now!");
-
-    const uint64_t layout_space = layout_end - prev_layout_end;
-
-    console.debug("[apply_layout] alignemnt: ", alignment);
-
-    uint16_t fixed_offset_idx = fixed_offset_idx_begin;
-    uint64_t max_offset = 0;
-    for (VariantLeafMeta& meta : variant_leaf_metas) {            
-        uint64_t offset = 0;
-        
-        const uint16_t pre_selected_count = meta.left_fields.get<alignment>();
-        
-        
-        if (pre_selected_count > 0) {
-            std::pair<uint16_t, uint64_t> pre_selected_buffer[pre_selected_count];
-            std::span<std::pair<uint16_t, uint64_t>> pre_selected {pre_selected_buffer, pre_selected_count};
-            uint16_t pre_slected_idx = 0;
-            
-            uint64_t required = 0; // Only used for assert at this point
-
-            for (const uint16_t& field_idx : meta.field_idxs) {
-                // console.debug("pre select checking field at: ", field_idx);
-                QueuedField& field = queued_fields_buffer[field_idx];
-                BSSERT(field.size != ~uint64_t{0});
-
-                if constexpr (alignment != SIZE::SIZE_8) {
-                    if (field.size == 0) continue;
-                } else {
-                    BSSERT(field.size != 0);
-                }
-
-                if (field.info.alignment() != alignment) continue;
-
-                // console.debug("pre selected field with size: ", field.size, " from idx: ", field_idx);
-
-                required += field.size;
-                meta.left_fields.get<alignment>()--;
-
-                pre_selected[pre_slected_idx++] = {field_idx, field.size};
-
-                // Mark as tracked
-                field.size = 0;
-            }
-
-            BSSERT(meta.left_fields.get<alignment>() == 0);
-            BSSERT(meta.required_spaces.get<alignment>() == required);
-
-            std::tie(fixed_offset_idx, offset) = solve_and_apply<alignment, true>(
-                layout_space,
-                meta,
-                offset,
-                fixed_offset_idx,
-                fixed_offsets,
-                tmp_fixed_offsets,
-                queued_fields_buffer,
-                pre_selected
-            );
-        } else {
-            std::tie(fixed_offset_idx, offset) = solve_and_apply<alignment, false>(
-                layout_space,
-                meta,
-                offset,
-                fixed_offset_idx,
-                fixed_offsets,
-                tmp_fixed_offsets,
-                queued_fields_buffer
-            );
-        }
-
-        max_offset = std::max(offset, max_offset);
+    if (layout_end == 0) {
+        packs = apply_greedy_layout_<alignment>(
+            queued_fields_buffer,
+            fixed_offsets,
+            tmp_fixed_offsets,
+            variant_leaf_metas,
+            fixed_offset_idx_begin,
+            packs
+        );
+        // The biggest variant is a lower bound for any layout.
+        layout_budget.record_greedy_layout(packs_size(packs), max_used_space);
+        return packs;
     }
 
-    // state.template next_variant_pack<alignment>(max_offset, {fixed_offset_idx_begin, fixed_offset_idx});
-    console.debug("packs.get<", alignment, ">() = {", max_offset, ", ", "{", fixed_offset_idx_begin, ", ", fixed_offset_idx, "}}" );
-    packs.get<alignment>() = {max_offset, {fixed_offset_idx_begin, fixed_offset_idx}};
+    const uint16_t fixed_offset_idx = apply_section_<alignment>(
+        layout_end - prev_layout_end,
+        queued_fields_buffer,
+        fixed_offsets,
+        tmp_fixed_offsets,
+        variant_leaf_metas,
+        fixed_offset_idx_begin,
+        packs
+    );
 
     return apply_layout_<alignment.next_smaller()>(
         current_bits,
@@ -568,19 +683,59 @@ requires (alignment != SIZE::SIZE_1)
         max_used_space,
         fixed_offset_idx,
         layout_end,
-        packs
+        packs,
+        layout_budget
     );
 }
 
+/**
+ * Size of laying out every alignment greedily, each variant packs its fields of an alignment back to back.
+ */
+[[nodiscard]] inline uint64_t greedy_layout_size (const std::span<const VariantLeafMeta> variant_leaf_metas) {
+    AlignSizes sizes = AlignSizes::zero();
+    for (const VariantLeafMeta& meta : variant_leaf_metas) {
+        for (const SIZE alignment : {SIZE::SIZE_8, SIZE::SIZE_4, SIZE::SIZE_2, SIZE::SIZE_1}) {
+            sizes.get<estd::discouraged>(alignment) = std::max(sizes.get<estd::discouraged>(alignment), meta.required_spaces.get<estd::discouraged>(alignment));
+        }
+    }
+    return sizes.total();
+}
+
+/**
+ * Anytime layout of the variants. The greedy layout is the incumbent, the perfect search improves on it while the budget
+ * lasts. Should the search only get a layout bigger than the incumbent, because it had to fall back to greedy packing
+ * part way, the incumbent is laid out instead.
+ */
 [[nodiscard]] inline PendingVariantFieldPacks apply_layout (
     const std::span<QueuedField> queued_fields_buffer,
     const std::span<FixedOffset> fixed_offsets,
     const std::span<FixedOffset> tmp_fixed_offsets,
     const std::span<VariantLeafMeta> variant_leaf_metas,
-    const uint16_t fixed_offset_idx_begin
+    const uint16_t fixed_offset_idx_begin,
+    LayoutBudget& layout_budget
 ) {
     BSSERT(variant_leaf_metas.size() >= 2, "find_perfect_variant_layout_st: variant_count shouldn't be less than 2");
     VariantLeafMeta biggest_variant_leaf_meta = variant_leaf_metas[0];
+    const uint64_t lower_bound = biggest_variant_leaf_meta.used_space;
+    const uint64_t incumbent_size = greedy_layout_size(variant_leaf_metas);
+
+    const auto apply_incumbent = [&] {
+        const PendingVariantFieldPacks packs = apply_greedy_layout_<SIZE::SIZE_8>(
+            queued_fields_buffer,
+            fixed_offsets,
+            tmp_fixed_offsets,
+            variant_leaf_metas,
+            fixed_offset_idx_begin,
+            {}
+        );
+        layout_budget.record_greedy_layout(packs_size(packs), lower_bound);
+        return packs;
+    };
+
+    if (layout_budget.exhausted()) return apply_incumbent();
+
+    LayoutUndo undo {queued_fields_buffer, fixed_offsets, tmp_fixed_offsets, variant_leaf_metas};
+    const LayoutUndo::Mark initial = undo.mark(fixed_offset_idx_begin);
 
     auto biggest_word_count = dp_bitset_base::bitset_word_count(biggest_variant_leaf_meta.used_space);
     auto second_biggest_word_count = dp_bitset_base::bitset_word_count(variant_leaf_metas[1].used_space);
@@ -594,7 +749,9 @@ requires (alignment != SIZE::SIZE_1)
         biggest_variant_leaf_meta
     );
 
-    return apply_layout_<SIZE::SIZE_8>(
+    // The fallbacks of the search are only reported if its layout is kept.
+    LayoutBudget search_budget = layout_budget;
+    const PendingVariantFieldPacks packs = apply_layout_<SIZE::SIZE_8>(
         current_bits.get(),
         current_bits.get() + biggest_word_count,
         1,
@@ -605,8 +762,18 @@ requires (alignment != SIZE::SIZE_1)
         biggest_variant_leaf_meta.used_space,
         fixed_offset_idx_begin,
         0,
-        {}
+        {},
+        search_budget
     );
+
+    if (packs_size(packs) <= incumbent_size) {
+        layout_budget = search_budget;
+        return packs;
+    }
+
+    console.debug("[apply_layout] search size: ", packs_size(packs), " keeping the greedy layout of size: ", incumbent_size);
+    undo.undo(initial);
+    return apply_incumbent();
 }
 
 } // namespace layout::generation::variant_layout
@@ -1,7 +1,11 @@
+#include <charconv>
 #include <cstddef>
+#include <cstdint>
 #include <cstdio>
 #include <gsl/util>
 #include <string>
+#include <string_view>
+#include <system_error>
 #include <chrono>
 
 #include "estd/utility.hpp"
@@ -14,15 +18,79 @@
 #include "./container/memory.hpp"
 #include "./parser/lexer.re2c.hpp"
 #include "./decode_code.hpp"
+#include "./layout/LayoutProfile.hpp"
+
+namespace {
+
+[[nodiscard]] uint64_t parse_option_uint (const std::string_view option, const std::string_view value) {
+    uint64_t result = 0;
+    const char* const end = value.data() + value.size();
+    const auto [ptr, ec] = std::from_chars(value.data(), end, result);
+    if (value.empty() || ec != std::errc{} || ptr != end) {
+        error_exit("Invalid value for ", option, " ", value);
+    }
+    return result;
+}
+
+void parse_option (const std::string_view arg) {
+    constexpr std::string_view layout_budget_option = "--layout-budget=";
+    constexpr std::string_view optimize_option = "--optimize=";
+    constexpr std::string_view layout_profile_option = "--layout-profile=";
+
+    if (arg == "--layout-report") {
+        global::options::layout_report = true;
+    } else if (arg == "--layout-instrument") {
+        global::options::layout_instrument = true;
+    } else if (arg == "--stream-runtime") {
+        global::options::stream_runtime = true;
+    } else if (arg == "--atomic-accessors") {
+        global::options::atomic_accessors = true;
+    } else if (arg == "--seqlock") {
+        global::options::seqlock = true;
+    } else if (arg == "--ring-runtime") {
+        global::options::ring_runtime = true;
+    } else if (arg.starts_with(layout_profile_option)) {
+        global::options::layout_profile_path = arg.substr(layout_profile_option.size());
+        if (global::options::layout_profile_path.empty()) {
+            error_exit("Invalid value for ", layout_profile_option, " ", arg);
+        }
+    } else if (arg.starts_with(layout_budget_option)) {
+        global::options::layout_budget_ms = parse_option_uint(layout_budget_option, arg.substr(layout_budget_option.size()));
+    } else if (arg.starts_with(optimize_option)) {
+        const std::string_view value = arg.substr(optimize_option.size());
+        if (value != "size") {
+            error_exit("Invalid value for ", optimize_option, " ", value);
+        }
+        global::options::optimize_size = true;
+    } else {
+        error_exit("Unknown option: ", arg);
+    }
+}
+
+} // namespace
 
 int main (const int argc, const char* const* const argv) {
     console.debug("spc");
-    if (argc <= 2) {
+
+    const char* paths[2] {};
+    size_t path_count = 0;
+    for (int i = 1; i < argc; i++) {
+        const std::string_view arg {argv[i]};
+        if (arg.starts_with("--")) {
+            parse_option(arg);
+        } else if (path_count < 2) {
+            paths[path_count++] = argv[i];
+        } else {
+            error_exit("Unexpected argument: ", arg);
+        }
+    }
+
+    if (path_count < 2) {
         error_exit("no output and/or input supplied");
     }
 
-    const std::string input_path {argv[1]};
-    const std::string output_path {argv[2]};
+    const std::string input_path {paths[0]};
+    const std::string output_path {paths[1]};
 
     auto input_file = fs::File::open(
         input_path,
@@ -98,7 +166,14 @@ int main (const int argc, const char* const* const argv) {
     Buffer ast_buffer {initial_ast_buffer};
     const lexer::StructDefinition& target_struct = lexer::lex<false>(global::input::start, identifier_map, ast_buffer, {});
 
-    decode_code::generate(target_struct, std::move(output_file));
+    layout::FieldOrder field_order;
+    if (!global::options::layout_profile_path.empty()) {
+        layout::LayoutProfile profile = layout::LayoutProfile::read(global::options::layout_profile_path);
+        profile.apply(target_struct, field_order);
+        profile.apply(identifier_map, ast_buffer, field_order);
+    }
+
+    decode_code::generate(target_struct, field_order, std::move(output_file));
 
     auto end_ts = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_ts - start_ts);
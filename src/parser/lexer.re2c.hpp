@@ -1,5 +1,6 @@
 #pragma once
 
+#include <bit>
 #include <cassert>
 #include <concepts>
 #include <cstddef>
@@ -197,6 +198,139 @@ struct VariantAttributes {
 }
 
 
+/**
+ * Lexes the attributes of a struct field, after the opening "[[".
+ */
+[[nodiscard]] inline LexResult<FieldAttributes> lex_field_attributes (const char* YYCURSOR) {
+    FieldAttributes attributes;
+
+    lex_attributes: {
+        /*!local:re2c
+            white_space* "hot"          { goto lex_hot; }
+            white_space* "cacheline"    { goto lex_cacheline; }
+            white_space* "soa"          { goto lex_soa; }
+            white_space* "delta"        { goto lex_delta; }
+            white_space* "for"          { goto lex_for; }
+            white_space* "sorted"       { goto lex_sorted; }
+            white_space*                { show_syntax_error("expected attribute", YYCURSOR - 1); }
+        */
+        lex_hot: {
+            if (attributes.hot) {
+                show_syntax_error("conflicting attributes", YYCURSOR - 1);
+            }
+            attributes.hot = true;
+            goto attribute_end;
+        }
+        lex_soa: {
+            if (attributes.soa) {
+                show_syntax_error("conflicting attributes", YYCURSOR - 1);
+            }
+            attributes.soa = true;
+            goto attribute_end;
+        }
+        lex_delta: {
+            if (attributes.encoding != ARRAY_ENCODING::NONE) {
+                show_syntax_error("conflicting attributes", YYCURSOR - 1);
+            }
+            attributes.encoding = ARRAY_ENCODING::DELTA;
+            /*!local:re2c
+                white_space* "("    { goto lex_encoding_bits; }
+                white_space*        { goto attribute_end; }
+            */
+        }
+        lex_for: {
+            if (attributes.encoding != ARRAY_ENCODING::NONE) {
+                show_syntax_error("conflicting attributes", YYCURSOR - 1);
+            }
+            attributes.encoding = ARRAY_ENCODING::FOR;
+            YYCURSOR = lex_symbol<'(', "expected bits argument for frame of reference encoding">(YYCURSOR);
+            goto lex_encoding_bits;
+        }
+        lex_encoding_bits: {
+            /*!local:re2c
+                white_space* "bits" { goto lex_encoding_bits_value; }
+                white_space*        { show_syntax_error("expected bits argument", YYCURSOR - 1); }
+            */
+            lex_encoding_bits_value:
+            const char* const value_start = YYCURSOR;
+            auto parsed = lex_attribute_value<uint8_t>(YYCURSOR);
+            switch (parsed.value) {
+                case 8:     attributes.encoding_size = SIZE::SIZE_1; break;
+                case 16:    attributes.encoding_size = SIZE::SIZE_2; break;
+                case 32:    attributes.encoding_size = SIZE::SIZE_4; break;
+                default:    show_syntax_error("encoding bits have to be 8, 16 or 32", value_start, parsed.cursor);
+            }
+            YYCURSOR = lex_symbol<')'>(parsed.cursor);
+            goto attribute_end;
+        }
+        lex_sorted: {
+            if (!attributes.sort_key.empty()) {
+                show_syntax_error("conflicting attributes", YYCURSOR - 1);
+            }
+            YYCURSOR = lex_symbol<'(', "expected key argument for sorted">(YYCURSOR);
+            /*!local:re2c
+                white_space* "key"  { goto lex_sort_key; }
+                white_space*        { show_syntax_error("expected key argument", YYCURSOR - 1); }
+            */
+            lex_sort_key:
+            YYCURSOR = lex_symbol<'=', "Expected value assignment for attribute">(YYCURSOR);
+            /*!local:re2c
+                white_space* [a-zA-Z_]  { goto sort_key_start; }
+                white_space*            { show_syntax_error("expected field name", YYCURSOR - 1); }
+            */
+            sort_key_start:
+            const char* const key_start = YYCURSOR - 1;
+            /*!local:re2c
+                [a-zA-Z0-9_]*  { goto sort_key_end; }
+            */
+            sort_key_end:
+            attributes.sort_key = {key_start, gsl::narrow_cast<size_t>(YYCURSOR - key_start)};
+            /*!local:re2c
+                white_space* ","    { goto lex_sort_order; }
+                white_space* ")"    { goto attribute_end; }
+                white_space*        { show_syntax_error("expected ',' or ')'", YYCURSOR - 1); }
+            */
+            lex_sort_order:
+            /*!local:re2c
+                white_space* "eytzinger"    { goto lex_eytzinger; }
+                white_space*                { show_syntax_error("expected eytzinger", YYCURSOR - 1); }
+            */
+            lex_eytzinger:
+            attributes.eytzinger = true;
+            YYCURSOR = lex_symbol<')'>(YYCURSOR);
+            goto attribute_end;
+        }
+        lex_cacheline: {
+            if (attributes.cacheline != 0) {
+                show_syntax_error("conflicting attributes", YYCURSOR - 1);
+            }
+            const char* const value_start = YYCURSOR;
+            auto parsed = lex_attribute_value<uint16_t>(YYCURSOR);
+            if (parsed.value < SIZE::MAX.byte_size() || !std::has_single_bit(parsed.value)) {
+                show_syntax_error("cache line size has to be a power of two and at least 8", value_start, parsed.cursor);
+            }
+            attributes.cacheline = parsed.value;
+            YYCURSOR = parsed.cursor;
+            goto attribute_end;
+        }
+        attribute_end: {
+            /*!local:re2c
+                white_space* "]" { goto close_attributes; }
+                white_space* "," { goto lex_attributes; }
+                white_space* { show_syntax_error("expected end of attributes or next ", YYCURSOR); }
+            */
+        }
+    }
+
+    close_attributes:
+    /*!local:re2c
+        "]" { goto done; }
+        * { show_syntax_error("expected closing of attributes", YYCURSOR); }
+    */
+    done:
+    return {YYCURSOR, attributes};
+}
+
 [[nodiscard]] inline LexResult<std::string_view> lex_identifier_name (const char* YYCURSOR) {
     const char* start;
 
@@ -217,12 +351,16 @@ struct VariantAttributes {
         any_white_space* "uint16"  invalid      { UNEXPECTED_INPUT("uint16 is reserved");  }
         any_white_space* "uint32"  invalid      { UNEXPECTED_INPUT("uint32 is reserved");  }
         any_white_space* "uint64"  invalid      { UNEXPECTED_INPUT("uint64 is reserved");  }
+        any_white_space* "uint"    invalid      { UNEXPECTED_INPUT("uint is reserved");    }
         any_white_space* "float32" invalid      { UNEXPECTED_INPUT("float32 is reserved"); }
         any_white_space* "float64" invalid      { UNEXPECTED_INPUT("float64 is reserved"); }
         any_white_space* "bool"    invalid      { UNEXPECTED_INPUT("bool is reserved");    }
         any_white_space* "string"  invalid      { UNEXPECTED_INPUT("string is reserved");  }
         any_white_space* "array"   invalid      { UNEXPECTED_INPUT("array is reserved");   }
         any_white_space* "variant" invalid      { UNEXPECTED_INPUT("variant is reserved"); }
+        any_white_space* "vec"     invalid      { UNEXPECTED_INPUT("vec is reserved");     }
+        any_white_space* "optional" invalid     { UNEXPECTED_INPUT("optional is reserved"); }
+        any_white_space* "map"     invalid      { UNEXPECTED_INPUT("map is reserved");     }
         any_white_space* "struct"  invalid      { UNEXPECTED_INPUT("struct is reserved");  }
         any_white_space* "enum"    invalid      { UNEXPECTED_INPUT("enum is reserved");    }
         any_white_space* "union"   invalid      { UNEXPECTED_INPUT("union is reserved");   }
@@ -423,7 +561,10 @@ template <bool is_dynamic, bool expect_fixed, typename BufferedTypeMeta>
 
         buffer.get(created_variant_type.extended) = {
             inner_min_byte_size,
+            inner_max_byte_size,
+            max_wasted_bytes,
             type_metas_offset,
+            shared_id,
             variant_count,
             sublevel_fixed_leafs,
             total_variant_var_leafs,
@@ -433,7 +574,10 @@ template <bool is_dynamic, bool expect_fixed, typename BufferedTypeMeta>
     } else {
         buffer.get(created_variant_type.extended) = {
             static_cast<uint64_t>(-1),
+            static_cast<uint64_t>(-1),
+            max_wasted_bytes,
             type_metas_offset,
+            shared_id,
             variant_count,
             sublevel_fixed_leafs,
             total_variant_var_leafs,
@@ -690,6 +834,10 @@ lex_type (const char* YYCURSOR, Buffer &buffer, IdentifierMap &identifier_map) {
         any_white_space*  @typename_start "string"          { goto string;             }
         any_white_space*  @typename_start "array"           { goto array;              }
         any_white_space*  @typename_start "variant"         { goto variant;            }
+        any_white_space*  @typename_start "vec"             { goto vector;             }
+        any_white_space*  @typename_start "uint<"           { goto ranged_uint;        }
+        any_white_space*  @typename_start "optional"        { goto optional;           }
+        any_white_space*  @typename_start "map"             { goto map;                }
         any_white_space*  @typename_start identifier        { goto identifier;         }
 
         any_white_space* { UNEXPECTED_INPUT("expected type"); }
@@ -761,7 +909,7 @@ lex_type (const char* YYCURSOR, Buffer &buffer, IdentifierMap &identifier_map) {
 
                     min_byte_size += min_length;
                     max_byte_size += max_length;
-                    const Buffer::Index<Type> type_header_idx = StringType::create(buffer, min_length, stored_size_size, size_size);
+                    const Buffer::Index<Type> type_header_idx = StringType::create(buffer, min_length, max_length, stored_size_size, size_size);
 
                     return LexTypeResult{
                         lex_argument_list_end(cursor),
@@ -811,6 +959,265 @@ lex_type (const char* YYCURSOR, Buffer &buffer, IdentifierMap &identifier_map) {
         }
     }
 
+    vector: {
+        if constexpr (expect_fixed) {
+            show_syntax_error("vectors can only be struct fields", typename_start, YYCURSOR - 1);
+        } else {
+            YYCURSOR = lex_argument_list_start(YYCURSOR);
+
+            FIELD_TYPE element_type;
+            SIZE element_size;
+
+            #define VECTOR_ELEMENT(TYPE) \
+            element_type = FIELD_TYPE::TYPE; \
+            element_size = type_alignment<FIELD_TYPE::TYPE>; \
+            goto vector_length;
+
+            /*!local:re2c
+                any_white_space* "int8"         { VECTOR_ELEMENT(INT8   ) }
+                any_white_space* "int16"        { VECTOR_ELEMENT(INT16  ) }
+                any_white_space* "int32"        { VECTOR_ELEMENT(INT32  ) }
+                any_white_space* "int64"        { VECTOR_ELEMENT(INT64  ) }
+                any_white_space* "uint8"        { VECTOR_ELEMENT(UINT8  ) }
+                any_white_space* "uint16"       { VECTOR_ELEMENT(UINT16 ) }
+                any_white_space* "uint32"       { VECTOR_ELEMENT(UINT32 ) }
+                any_white_space* "uint64"       { VECTOR_ELEMENT(UINT64 ) }
+                any_white_space* "float32"      { VECTOR_ELEMENT(FLOAT32) }
+                any_white_space* "float64"      { VECTOR_ELEMENT(FLOAT64) }
+
+                any_white_space* { UNEXPECTED_INPUT("expected numeric vector element type"); }
+            */
+            #undef VECTOR_ELEMENT
+
+            vector_length: {
+                YYCURSOR = lex_symbol<',', "expected length argument">(YYCURSOR);
+                const auto parsed = parse_uint_skip_white_space<uint16_t, true>(YYCURSOR);
+                const char* const length_start = parsed.cursor - parsed.digits;
+
+                // Vectors are loaded with whole SIMD registers, so their size has to fill them.
+                const uint32_t byte_size = uint32_t{parsed.value} * element_size.byte_size();
+                if (byte_size == 0 || byte_size % 16 != 0) {
+                    show_syntax_error("vector size has to be a non zero multiple of 16 bytes", length_start, parsed.cursor);
+                }
+                const uint8_t alignment = byte_size % 64 == 0 ? 64 : byte_size % 32 == 0 ? 32 : 16;
+
+                const Buffer::Index<Type> type_header_idx = VectorType::create(buffer, element_type, element_size, parsed.value, alignment);
+
+                return LexTypeResult{
+                    lex_argument_list_end(parsed.cursor),
+                    LeafCounts::from_size<SIZE::SIZE_8>(),
+                    LeafCounts::zero(),
+                    byte_size,
+                    byte_size,
+                    0,
+                    0,
+                    0,
+                    0,
+                    0,
+                    0,
+                    0,
+                    SIZE::SIZE_8,
+                    type_header_idx
+                };
+            }
+        }
+    }
+
+    ranged_uint: {
+        if constexpr (expect_fixed) {
+            show_syntax_error("ranged integers can only be struct fields", typename_start, YYCURSOR - 1);
+        } else {
+            return lex_range_argument<LexTypeResult, true>(
+                YYCURSOR,
+                [typename_start] [[noreturn]] (const char* cursor) {
+                    show_syntax_error("expected range of values", typename_start, cursor - 1);
+                },
+                [](const char* cursor, uint32_t min, uint32_t max, Buffer& buffer)->LexTypeResult {
+                    const Buffer::Index<Type> type_header_idx = RangedUintType::create(buffer, min, max);
+
+                    // Counted like a bool, the layout packs both into shared words.
+                    return LexTypeResult{
+                        lex_argument_list_end(cursor),
+                        LeafCounts::from_size<SIZE::SIZE_1>(),
+                        LeafCounts::zero(),
+                        1,
+                        1,
+                        0,
+                        0,
+                        0,
+                        0,
+                        0,
+                        0,
+                        0,
+                        SIZE::SIZE_1,
+                        type_header_idx
+                    };
+                },
+                buffer
+            );
+        }
+    }
+
+    optional: {
+        if constexpr (expect_fixed) {
+            show_syntax_error("optionals can only be struct fields", typename_start, YYCURSOR - 1);
+        } else {
+            YYCURSOR = lex_argument_list_start(YYCURSOR);
+
+            FIELD_TYPE value_type;
+            SIZE value_size;
+
+            #define OPTIONAL_VALUE(TYPE) \
+            value_type = FIELD_TYPE::TYPE; \
+            value_size = type_alignment<FIELD_TYPE::TYPE>; \
+            goto optional_end;
+
+            /*!local:re2c
+                any_white_space* "int8"         { OPTIONAL_VALUE(INT8   ) }
+                any_white_space* "int16"        { OPTIONAL_VALUE(INT16  ) }
+                any_white_space* "int32"        { OPTIONAL_VALUE(INT32  ) }
+                any_white_space* "int64"        { OPTIONAL_VALUE(INT64  ) }
+                any_white_space* "uint8"        { OPTIONAL_VALUE(UINT8  ) }
+                any_white_space* "uint16"       { OPTIONAL_VALUE(UINT16 ) }
+                any_white_space* "uint32"       { OPTIONAL_VALUE(UINT32 ) }
+                any_white_space* "uint64"       { OPTIONAL_VALUE(UINT64 ) }
+                any_white_space* "float32"      { OPTIONAL_VALUE(FLOAT32) }
+                any_white_space* "float64"      { OPTIONAL_VALUE(FLOAT64) }
+                any_white_space* "bool"         { OPTIONAL_VALUE(BOOL   ) }
+
+                any_white_space* { UNEXPECTED_INPUT("expected numeric or bool optional value type, optional strings, arrays and structs are not supported"); }
+            */
+            #undef OPTIONAL_VALUE
+
+            optional_end: {
+                const Buffer::Index<Type> type_header_idx = OptionalType::create(buffer, value_type, value_size);
+
+                // The presence bit is counted like a bool, the value is stored behind the fixed leafs when present.
+                return LexTypeResult{
+                    lex_argument_list_end(YYCURSOR),
+                    LeafCounts::from_size<SIZE::SIZE_1>(),
+                    LeafCounts::zero(),
+                    1,
+                    1 + uint64_t{value_size.byte_size()},
+                    0,
+                    0,
+                    0,
+                    0,
+                    0,
+                    0,
+                    0,
+                    SIZE::SIZE_1,
+                    type_header_idx
+                };
+            }
+        }
+    }
+
+    map: {
+        if constexpr (expect_fixed) {
+            show_syntax_error("maps can only be struct fields", typename_start, YYCURSOR - 1);
+        } else {
+            YYCURSOR = lex_argument_list_start(YYCURSOR);
+
+            FIELD_TYPE key_type;
+            SIZE key_size;
+            uint16_t key_byte_size;
+            FIELD_TYPE value_type;
+            SIZE value_size;
+
+            #define MAP_KEY(TYPE) \
+            key_type = FIELD_TYPE::TYPE; \
+            key_size = type_alignment<FIELD_TYPE::TYPE>; \
+            key_byte_size = key_size.byte_size(); \
+            goto map_value;
+
+            /*!local:re2c
+                any_white_space* "int8"         { MAP_KEY(INT8   ) }
+                any_white_space* "int16"        { MAP_KEY(INT16  ) }
+                any_white_space* "int32"        { MAP_KEY(INT32  ) }
+                any_white_space* "int64"        { MAP_KEY(INT64  ) }
+                any_white_space* "uint8"        { MAP_KEY(UINT8  ) }
+                any_white_space* "uint16"       { MAP_KEY(UINT16 ) }
+                any_white_space* "uint32"       { MAP_KEY(UINT32 ) }
+                any_white_space* "uint64"       { MAP_KEY(UINT64 ) }
+                any_white_space* "string"       { goto map_string_key; }
+
+                any_white_space* { UNEXPECTED_INPUT("expected integer or string map key type"); }
+            */
+            #undef MAP_KEY
+
+            // string<L> keys of up to L bytes, stored zero padded in slots of L bytes.
+            map_string_key: {
+                YYCURSOR = lex_argument_list_start(YYCURSOR);
+                const auto parsed = parse_uint_skip_white_space<uint16_t, true>(YYCURSOR);
+                if (parsed.value == 0) {
+                    show_syntax_error("map key length has to be at least 1", parsed.cursor - parsed.digits, parsed.cursor);
+                }
+                YYCURSOR = lex_argument_list_end(parsed.cursor);
+                key_type = FIELD_TYPE::STRING_FIXED;
+                key_size = SIZE::SIZE_1;
+                key_byte_size = parsed.value;
+                goto map_value;
+            }
+
+            map_value:
+            YYCURSOR = lex_symbol<',', "expected value type argument">(YYCURSOR);
+
+            #define MAP_VALUE(TYPE) \
+            value_type = FIELD_TYPE::TYPE; \
+            value_size = type_alignment<FIELD_TYPE::TYPE>; \
+            goto map_capacity;
+
+            /*!local:re2c
+                any_white_space* "int8"         { MAP_VALUE(INT8   ) }
+                any_white_space* "int16"        { MAP_VALUE(INT16  ) }
+                any_white_space* "int32"        { MAP_VALUE(INT32  ) }
+                any_white_space* "int64"        { MAP_VALUE(INT64  ) }
+                any_white_space* "uint8"        { MAP_VALUE(UINT8  ) }
+                any_white_space* "uint16"       { MAP_VALUE(UINT16 ) }
+                any_white_space* "uint32"       { MAP_VALUE(UINT32 ) }
+                any_white_space* "uint64"       { MAP_VALUE(UINT64 ) }
+                any_white_space* "float32"      { MAP_VALUE(FLOAT32) }
+                any_white_space* "float64"      { MAP_VALUE(FLOAT64) }
+                any_white_space* "bool"         { MAP_VALUE(BOOL   ) }
+
+                any_white_space* { UNEXPECTED_INPUT("expected numeric or bool map value type"); }
+            */
+            #undef MAP_VALUE
+
+            map_capacity: {
+                YYCURSOR = lex_symbol<',', "expected capacity argument">(YYCURSOR);
+                const auto parsed = parse_uint_skip_white_space<uint16_t, true>(YYCURSOR);
+                if (parsed.value == 0) {
+                    show_syntax_error("map capacity has to be at least 1", parsed.cursor - parsed.digits, parsed.cursor);
+                }
+
+                const MapType map_type = MapType::make(key_type, key_size, key_byte_size, value_type, value_size, parsed.value);
+                const Buffer::Index<Type> type_header_idx = MapType::create(buffer, map_type);
+                const uint64_t byte_size = map_type.byte_size();
+                const SIZE alignment = map_type.alignment();
+
+                // The slots are one leaf, its size is a multiple of the alignment since the slot count is.
+                return LexTypeResult{
+                    lex_argument_list_end(parsed.cursor),
+                    LeafCounts{alignment},
+                    LeafCounts::zero(),
+                    byte_size,
+                    byte_size,
+                    0,
+                    0,
+                    0,
+                    0,
+                    0,
+                    0,
+                    0,
+                    alignment,
+                    type_header_idx
+                };
+            }
+        }
+    }
+
     array: {
         const auto [type_header_idx, extended_idx] = ArrayType::create(buffer);
 
@@ -920,6 +1327,7 @@ lex_type (const char* YYCURSOR, Buffer &buffer, IdentifierMap &identifier_map) {
                         stored_size_size,
                         size_size
                     };
+                    buffer.get(extended_idx).max_byte_size = result.byte_size * max_length;
 
                     return LexTypeResult{
                         lex_argument_list_end(cursor),
@@ -1134,14 +1542,28 @@ template <bool is_first_field>
     uint16_t pack_count,
     SIZE max_alignment
 ) {
+    FieldAttributes field_attributes;
+
     before_field:
+    field_attributes = {};
     /*!local:re2c
         any_white_space* [a-zA-Z_]   { goto name_start; }
+        any_white_space* "[["        { goto field_attributes_start; }
         any_white_space* "}"         { goto struct_end; }
 
         any_white_space* { show_syntax_error("Expected field name or end of struct", YYCURSOR - 1); }
     */
 
+    field_attributes_start: {
+        const LexResult<FieldAttributes> attributes_lex_result = lex_field_attributes(YYCURSOR);
+        YYCURSOR = attributes_lex_result.cursor;
+        field_attributes = attributes_lex_result.value;
+    }
+    /*!local:re2c
+        any_white_space* [a-zA-Z_]   { goto name_start; }
+        any_white_space* { show_syntax_error("Expected field name after attributes", YYCURSOR - 1); }
+    */
+
     struct_end: {
         if constexpr (is_first_field) {
             show_syntax_error("expected at least one field", YYCURSOR - 1);
@@ -1186,11 +1608,50 @@ template <bool is_first_field>
     */
 
     struct_field: {
-        StructField::create(buffer, {field_name});
+        StructField::create(buffer, {field_name, field_attributes});
 
-        const LexTypeResult result = lex_type<false, false>(YYCURSOR, buffer, identifier_map);
+        LexTypeResult result = lex_type<false, false>(YYCURSOR, buffer, identifier_map);
         YYCURSOR = result.cursor;
 
+        if (field_attributes.soa && !buffer.get(result.type_header_idx).set_soa()) {
+            show_syntax_error("soa is only supported on fixed size arrays", field_name);
+        }
+
+        if (
+            !field_attributes.sort_key.empty() &&
+            !buffer.get(result.type_header_idx).set_sorted(field_attributes.sort_key, field_attributes.eytzinger)
+        ) {
+            show_syntax_error("sorted is only supported on fixed size arrays of structs with a numeric key field", field_attributes.sort_key);
+        }
+
+        if (field_attributes.encoding != ARRAY_ENCODING::NONE) {
+            const ArrayType* const array_type = buffer.get(result.type_header_idx).set_encoding(
+                field_attributes.encoding,
+                field_attributes.encoding_size
+            );
+            if (array_type == nullptr) {
+                show_syntax_error("delta and for are only supported on fixed size arrays of integers wider than the encoding, not on variable size arrays", field_name);
+            }
+            // The reference value and the differences are stored as one leaf of the element alignment.
+            const uint64_t byte_size = array_type->encoded_leaf_count() * array_type->element_size.byte_size();
+            result = LexTypeResult{
+                result.cursor,
+                LeafCounts{array_type->element_size},
+                LeafCounts::zero(),
+                byte_size,
+                byte_size,
+                0,
+                0,
+                0,
+                0,
+                0,
+                0,
+                0,
+                array_type->element_size,
+                result.type_header_idx
+            };
+        }
+
         YYCURSOR = lex_symbol<';'>(YYCURSOR);
 
         if constexpr (is_first_field) {
@@ -45,7 +45,11 @@ enum class FIELD_TYPE : uint8_t {
     FIXED_VARIANT,
     PACKED_VARIANT,
     DYNAMIC_VARIANT,
-    IDENTIFIER
+    IDENTIFIER,
+    VECTOR,
+    RANGED_UINT,
+    OPTIONAL,
+    MAP
 };
 
 template <FIELD_TYPE field_type>
@@ -185,6 +189,10 @@ struct IdentifiedType;
 struct FixedStringType;
 struct StringType;
 struct ArrayType;
+struct VectorType;
+struct RangedUintType;
+struct OptionalType;
+struct MapType;
 
 template <typename TypeMeta>
 struct VariantTypeBase;
@@ -196,6 +204,14 @@ using FixedVariantType = VariantTypeBase<FixedVariantTypeMeta>;
 using PackedVariantType = VariantTypeBase<FixedVariantTypeMeta>;
 using DynamicVariantType = VariantTypeBase<DynamicVariantTypeMeta>;
 
+// Only fixed arrays are encoded. Elements of variable arrays live behind their size leaf in the variable region, which
+// decode() and the iterator would first have to read the length from, so `[[delta]]` and `[[for]]` on them are errors.
+enum class ARRAY_ENCODING : uint8_t {
+    NONE,
+    DELTA,  // First element, then the difference of every element to the one before
+    FOR     // Frame of reference: the smallest element, then the difference of every element to it
+};
+
 struct Type {
 private:
     FIELD_TYPE type;
@@ -208,6 +224,10 @@ private:
     [[nodiscard]] const FixedStringType& as_fixed_string () const;
     [[nodiscard]] const StringType& as_string () const;
     [[nodiscard]] ArrayType& as_array () const;
+    [[nodiscard]] const VectorType& as_vector () const;
+    [[nodiscard]] const RangedUintType& as_ranged_uint () const;
+    [[nodiscard]] const OptionalType& as_optional () const;
+    [[nodiscard]] const MapType& as_map () const;
     [[nodiscard]] FixedVariantType& as_fixed_variant () const;
     [[nodiscard]] PackedVariantType& as_packed_variant () const;
     [[nodiscard]] DynamicVariantType& as_dynamic_variant () const;
@@ -263,6 +283,23 @@ public:
 
     template <typename T>
     [[nodiscard]] inline T& skip () const;
+
+    /**
+     * Lays a fixed array out as struct of arrays. Returns false for any other type.
+     */
+    [[nodiscard]] bool set_soa () const;
+
+    /**
+     * Stores a fixed array of integers as reference value and narrow differences, SIZE_0 picks half the element size.
+     * Returns nullptr for any other type or if the differences are not narrower than the elements.
+     */
+    [[nodiscard]] const ArrayType* set_encoding (ARRAY_ENCODING encoding, SIZE narrow_size) const;
+
+    /**
+     * Marks a fixed array of structs as sorted by the numeric field `key` of its elements, optionally in Eytzinger
+     * order. Returns false for any other type or if the elements have no such field.
+     */
+    [[nodiscard]] bool set_sorted (std::string_view key, bool eytzinger) const;
 };
 
 struct FixedStringType {
@@ -295,18 +332,20 @@ private:
 struct StringType {
     friend Type;
 
-    [[nodiscard]] static Buffer::Index<Type> create (Buffer &buffer, uint32_t min_length, SIZE stored_size_size, SIZE size_size) {
+    [[nodiscard]] static Buffer::Index<Type> create (Buffer &buffer, uint32_t min_length, uint32_t max_length, SIZE stored_size_size, SIZE size_size) {
         return create_with_header<Type, StringType>(
             buffer,
             Type{FIELD_TYPE::STRING},
             StringType{
                 min_length,
+                max_length,
                 stored_size_size,
                 size_size
             }
         );
     }
     uint32_t min_length;
+    uint32_t max_length;
     SIZE stored_size_size;
     SIZE size_size;
 
@@ -320,6 +359,169 @@ private:
     return get_padded<const StringType>(this + 1);
 }
 
+/**
+ * `vec<T, N>`: N numeric elements stored inline and aligned to 16, 32 or 64 bytes for SIMD loads.
+ * The alignment model (SIZE, AlignCounts) stops at 8 bytes, a vector is counted as one 8 byte leaf and padded to its
+ * alignment where the top level places it. It can not be an element of an array or an alternative of a variant.
+ */
+struct VectorType {
+    friend Type;
+
+    [[nodiscard]] static Buffer::Index<Type> create (Buffer &buffer, FIELD_TYPE element_type, SIZE element_size, uint16_t length, uint8_t alignment) {
+        return create_with_header<Type, VectorType>(
+            buffer,
+            Type{FIELD_TYPE::VECTOR},
+            VectorType{
+                element_type,
+                element_size,
+                length,
+                alignment
+            }
+        );
+    }
+
+    FIELD_TYPE element_type;
+    SIZE element_size;
+    uint16_t length;
+    uint8_t alignment; // In bytes
+
+    [[nodiscard]] constexpr uint32_t byte_size () const {
+        return uint32_t{length} * element_size.byte_size();
+    }
+
+private:
+    template <typename T>
+    [[nodiscard]] T& after () const {
+        return *estd::ptr_cast<T>(this + 1);
+    }
+};
+[[nodiscard]] inline const VectorType& Type::as_vector () const {
+    return get_padded<const VectorType>(this + 1);
+}
+
+/**
+ * `uint<min..max>`: stores value - min with the fewest bits, packed into a word shared with other bit fields.
+ */
+struct RangedUintType {
+    friend Type;
+
+    [[nodiscard]] static Buffer::Index<Type> create (Buffer &buffer, uint32_t min, uint32_t max) {
+        return create_with_header<Type, RangedUintType>(
+            buffer,
+            Type{FIELD_TYPE::RANGED_UINT},
+            RangedUintType{
+                min,
+                max,
+                gsl::narrow_cast<uint8_t>(std::bit_width(max - min))
+            }
+        );
+    }
+
+    uint32_t min;
+    uint32_t max;
+    uint8_t bit_width;
+
+    // Size of the integer the accessor returns
+    [[nodiscard]] constexpr SIZE value_size () const {
+        if (max <= UINT8_MAX) return SIZE::SIZE_1;
+        if (max <= UINT16_MAX) return SIZE::SIZE_2;
+        return SIZE::SIZE_4;
+    }
+
+private:
+    template <typename T>
+    [[nodiscard]] T& after () const {
+        return *estd::ptr_cast<T>(this + 1);
+    }
+};
+[[nodiscard]] inline const RangedUintType& Type::as_ranged_uint () const {
+    return get_padded<const RangedUintType>(this + 1);
+}
+
+/**
+ * `optional<T>`: a numeric or bool value with a presence bit, only stored when present.
+ * Values of variable size are not supported, the offset of a value is a popcount over the fixed value sizes.
+ */
+struct OptionalType {
+    friend Type;
+
+    [[nodiscard]] static Buffer::Index<Type> create (Buffer &buffer, FIELD_TYPE value_type, SIZE value_size) {
+        return create_with_header<Type, OptionalType>(
+            buffer,
+            Type{FIELD_TYPE::OPTIONAL},
+            OptionalType{
+                value_type,
+                value_size
+            }
+        );
+    }
+
+    FIELD_TYPE value_type;
+    SIZE value_size;
+
+private:
+    template <typename T>
+    [[nodiscard]] T& after () const {
+        return *estd::ptr_cast<T>(this + 1);
+    }
+};
+[[nodiscard]] inline const OptionalType& Type::as_optional () const {
+    return get_padded<const OptionalType>(this + 1);
+}
+
+/**
+ * `map<K, V, N>`: up to N entries of integer or `string<L>` keys and numeric or bool values in an open addressing table.
+ * Keys, values and one tag byte per slot are stored as packed arrays, lookups probe the tags in groups of 8.
+ * A string key takes L bytes in its slot, shorter keys are padded with zeros.
+ */
+struct MapType {
+    friend Type;
+
+    static constexpr uint32_t group_size = 8;
+
+    [[nodiscard]] static constexpr MapType make (
+        const FIELD_TYPE key_type,
+        const SIZE key_size,
+        const uint16_t key_byte_size,
+        const FIELD_TYPE value_type,
+        const SIZE value_size,
+        const uint16_t capacity
+    ) {
+        // Keeps the load factor at most 80% and at least one slot empty, so every probe sequence ends.
+        const uint32_t slot_count = std::max(group_size, std::bit_ceil(uint32_t{capacity} + (capacity / 4) + 1));
+        return {key_type, key_size, key_byte_size, value_type, value_size, capacity, slot_count};
+    }
+
+    [[nodiscard]] static Buffer::Index<Type> create (Buffer &buffer, const MapType& map_type) {
+        return create_with_header<Type, const MapType&>(buffer, Type{FIELD_TYPE::MAP}, map_type);
+    }
+
+    FIELD_TYPE key_type;    // STRING_FIXED for string keys
+    SIZE key_size;          // Alignment of the keys
+    uint16_t key_byte_size; // Bytes of one key slot
+    FIELD_TYPE value_type;
+    SIZE value_size;
+    uint16_t capacity;
+    uint32_t slot_count;    // Power of two multiple of group_size
+
+    [[nodiscard]] constexpr SIZE alignment () const {
+        return std::max(key_size, value_size);
+    }
+
+    [[nodiscard]] constexpr uint64_t byte_size () const {
+        return uint64_t{slot_count} * (key_byte_size + value_size.byte_size() + 1);
+    }
+
+private:
+    template <typename T>
+    [[nodiscard]] T& after () const {
+        return *estd::ptr_cast<T>(this + 1);
+    }
+};
+[[nodiscard]] inline const MapType& Type::as_map () const {
+    return get_padded<const MapType>(this + 1);
+}
+
 
 using IdentifedDefinitionIndex = Buffer::Index<const IdentifiedDefinition>;
 struct IdentifiedType {
@@ -366,16 +568,66 @@ struct ArrayType {
     uint16_t pack_info_base_idx;
     SIZE stored_size_size;
     SIZE size_size;
+    bool soa = false;   // Every leaf of the elements gets its own column, only for fixed arrays
+    ARRAY_ENCODING encoding = ARRAY_ENCODING::NONE;
+    FIELD_TYPE element_type;    // Only set for encoded arrays
+    SIZE element_size;          // Only set for encoded arrays
+    SIZE narrow_size;           // Unsigned differences of encoded arrays
+    bool eytzinger = false;     // Sorted elements are stored in breadth first order of the search tree
+    FIELD_TYPE sort_key_type;   // Only set for sorted arrays
+    std::string_view sort_key;  // Field of the elements the array is sorted by, empty if unsorted
+    uint64_t max_byte_size = 0; // Only set for variable arrays, bytes of the elements at the maximum length
 
     [[nodiscard]] const Type& inner_type () const {
         return *estd::ptr_cast<const Type>(this + 1);
     }
 
+    [[nodiscard]] constexpr uint64_t encoded_byte_size () const {
+        const uint64_t narrow_count = encoding == ARRAY_ENCODING::DELTA ? length - 1 : length;
+        return element_size.byte_size() + (narrow_count * narrow_size.byte_size());
+    }
+
+    // The reference value and the differences are one leaf of the element alignment
+    [[nodiscard]] constexpr uint64_t encoded_leaf_count () const {
+        return (encoded_byte_size() + element_size.byte_size() - 1) / element_size.byte_size();
+    }
 };
 [[nodiscard]] inline ArrayType& Type::as_array () const {
     return const_cast<ArrayType&>(get_padded<const ArrayType>(this + 1));
 }
 
+[[nodiscard]] inline bool Type::set_soa () const {
+    if (type != FIELD_TYPE::ARRAY_FIXED) return false;
+    as_array().soa = true;
+    return true;
+}
+
+[[nodiscard]] inline const ArrayType* Type::set_encoding (const ARRAY_ENCODING encoding, const SIZE narrow_size) const {
+    if (type != FIELD_TYPE::ARRAY_FIXED) return nullptr;
+    ArrayType& array_type = as_array();
+    if (array_type.soa || array_type.length == 0) return nullptr;
+
+    const FIELD_TYPE element_type = array_type.inner_type().type;
+    SIZE element_size;
+    switch (element_type) {
+        case FIELD_TYPE::UINT16:
+        case FIELD_TYPE::INT16:     element_size = SIZE::SIZE_2; break;
+        case FIELD_TYPE::UINT32:
+        case FIELD_TYPE::INT32:     element_size = SIZE::SIZE_4; break;
+        case FIELD_TYPE::UINT64:
+        case FIELD_TYPE::INT64:     element_size = SIZE::SIZE_8; break;
+        default:                    return nullptr;
+    }
+    const SIZE used_narrow_size = narrow_size == SIZE::SIZE_0 ? element_size - SIZE::SIZE_2 : narrow_size;
+    if (used_narrow_size >= element_size) return nullptr;
+
+    array_type.encoding = encoding;
+    array_type.element_type = element_type;
+    array_type.element_size = element_size;
+    array_type.narrow_size = used_narrow_size;
+    return &array_type;
+}
+
 
 
 template <typename TypeMeta>
@@ -387,7 +639,10 @@ struct VariantTypeBase {
     }
 
     uint64_t min_byte_size;                 // Minimum byte size of the variant (used for size getter)
+    uint64_t max_byte_size;                 // Maximum byte size of the variant (used for the message size bound)
+    uint64_t max_wasted_bytes;              // Bytes an alternative may leave unused before the variant is packed
     Buffer::index_t type_metas_offset;      // Offset from head of type_metas to the head of this
+    uint32_t shared_id;                     // Variants of a struct with the same shared_id overlay each other, -1 if none
     uint16_t variant_count;                 // Count of variants
     uint16_t total_fixed_leafs;             // Count of nested and non-nested fixed sized leafs
     uint16_t total_var_leafs;               // Count of nested and non-nested variable sized leafs
@@ -403,6 +658,10 @@ struct VariantTypeBase {
     [[nodiscard]] const Type& first_variant() const {
         return *estd::ptr_cast<const Type>(this + 1);
     }
+
+    [[nodiscard]] bool has_shared_id () const {
+        return shared_id != static_cast<uint32_t>(-1);
+    }
 private:
     template <typename T>
     [[nodiscard]] T& after () const {
@@ -440,8 +699,19 @@ struct DynamicVariantTypeMeta {
 }
 
 
+struct FieldAttributes {
+    uint16_t cacheline = 0;     // Cache line size no leaf of the field may straddle, 0 if unconstrained
+    bool hot = false;           // Placed at the front of the fixed region
+    bool soa = false;           // Fixed array stored as one column per leaf of its elements
+    ARRAY_ENCODING encoding = ARRAY_ENCODING::NONE;
+    SIZE encoding_size = SIZE::SIZE_0;  // Size of the differences of encoded arrays, SIZE_0 if not given
+    bool eytzinger = false;     // Sorted array stored in breadth first order
+    std::string_view sort_key;  // Element field a sorted array is ordered by
+};
+
 struct StructField {
     std::string_view name;
+    FieldAttributes attributes;
 
     [[nodiscard]] const Type& type () const {
         return *estd::ptr_cast<const Type>(this + 1);
@@ -526,6 +796,29 @@ public:
         }
     }
 
+    /**
+     * Visits `[[hot]]` fields first, then the rest in declaration order.
+     * Layout generation and code generation consume leaf indices in visiting order, so both have to use this, or
+     * `layout::FieldOrder` when a layout profile reorders the fields.
+     */
+    template <typename VisitorT>
+    void visit_in_layout_order (VisitorT&& visitor) const {
+        uint16_t hot_fields = 0;
+        visit([&](const StructField& field_data) -> const std::byte& {
+            if (!field_data.attributes.hot) return field_data.type().skip<const std::byte>();
+            hot_fields++;
+            return visitor(field_data);
+        });
+        if (hot_fields == 0) {
+            visit(visitor);
+            return;
+        }
+        visit([&](const StructField& field_data) -> const std::byte& {
+            if (field_data.attributes.hot) return field_data.type().skip<const std::byte>();
+            return visitor(field_data);
+        });
+    }
+
     template <typename VisitorT>
     void visit_uninitialized (VisitorT&& visitor, const uint16_t field_count) const {
         const std::byte* after_field = &visitor(first_field());
@@ -577,6 +870,10 @@ template <typename T>
         case FIELD_TYPE::PACKED_VARIANT:    return as_packed_variant().after<T>();
         case FIELD_TYPE::DYNAMIC_VARIANT:   return as_dynamic_variant().after<T>();
         case FIELD_TYPE::IDENTIFIER:        return as_identifier().after<T>();
+        case FIELD_TYPE::VECTOR:            return as_vector().after<T>();
+        case FIELD_TYPE::RANGED_UINT:       return as_ranged_uint().after<T>();
+        case FIELD_TYPE::OPTIONAL:          return as_optional().after<T>();
+        case FIELD_TYPE::MAP:               return as_map().after<T>();
         case FIELD_TYPE::BOOL:
         case FIELD_TYPE::UINT8:
         case FIELD_TYPE::UINT16:
@@ -720,6 +1017,46 @@ template <typename VisitorT, typename... ArgsT>
                     std::forward<VisitorT>(visitor).on_string(string_type, std::forward<ArgsT>(args)...)};
             }
         }
+        case FIELD_TYPE::VECTOR: {
+            const VectorType& vector_type = as_vector();
+            if constexpr (no_value) {
+                std::forward<VisitorT>(visitor).on_vector(vector_type, std::forward<ArgsT>(args)...);
+                return result_t{vector_type.after<const_next_type_t>()};
+            } else {
+                return result_t{vector_type.after<const_next_type_t>(),
+                    std::forward<VisitorT>(visitor).on_vector(vector_type, std::forward<ArgsT>(args)...)};
+            }
+        }
+        case FIELD_TYPE::RANGED_UINT: {
+            const RangedUintType& ranged_uint_type = as_ranged_uint();
+            if constexpr (no_value) {
+                std::forward<VisitorT>(visitor).on_ranged_uint(ranged_uint_type, std::forward<ArgsT>(args)...);
+                return result_t{ranged_uint_type.after<const_next_type_t>()};
+            } else {
+                return result_t{ranged_uint_type.after<const_next_type_t>(),
+                    std::forward<VisitorT>(visitor).on_ranged_uint(ranged_uint_type, std::forward<ArgsT>(args)...)};
+            }
+        }
+        case FIELD_TYPE::OPTIONAL: {
+            const OptionalType& optional_type = as_optional();
+            if constexpr (no_value) {
+                std::forward<VisitorT>(visitor).on_optional(optional_type, std::forward<ArgsT>(args)...);
+                return result_t{optional_type.after<const_next_type_t>()};
+            } else {
+                return result_t{optional_type.after<const_next_type_t>(),
+                    std::forward<VisitorT>(visitor).on_optional(optional_type, std::forward<ArgsT>(args)...)};
+            }
+        }
+        case FIELD_TYPE::MAP: {
+            const MapType& map_type = as_map();
+            if constexpr (no_value) {
+                std::forward<VisitorT>(visitor).on_map(map_type, std::forward<ArgsT>(args)...);
+                return result_t{map_type.after<const_next_type_t>()};
+            } else {
+                return result_t{map_type.after<const_next_type_t>(),
+                    std::forward<VisitorT>(visitor).on_map(map_type, std::forward<ArgsT>(args)...)};
+            }
+        }
         case FIELD_TYPE::ARRAY_FIXED: {
             return std::forward<VisitorT>(visitor).on_fixed_array(as_array(), std::forward<ArgsT>(args)...);
         }
@@ -783,4 +1120,37 @@ template <typename Visitor, typename... Args>
         return std::forward<Visitor>(visitor).on_fail(std::forward<Args>(args)...);
     }
 
+[[nodiscard]] inline bool Type::set_sorted (const std::string_view key, const bool eytzinger) const {
+    if (type != FIELD_TYPE::ARRAY_FIXED) return false;
+    ArrayType& array_type = as_array();
+    if (array_type.encoding != ARRAY_ENCODING::NONE) return false;
+
+    struct KeyTypeVisitor {
+        std::string_view key;
+
+        [[nodiscard]] FIELD_TYPE on_struct (const StructDefinition& struct_definition) const {
+            FIELD_TYPE key_type = FIELD_TYPE::IDENTIFIER;
+            struct_definition.visit([&](const StructField& field_data) -> const std::byte& {
+                if (field_data.name == key) {
+                    key_type = field_data.type().type;
+                }
+                return field_data.type().skip<const std::byte>();
+            });
+            return key_type;
+        }
+
+        [[nodiscard]] FIELD_TYPE on_enum (const EnumDefinition& /*unused*/) const { return FIELD_TYPE::IDENTIFIER; }
+
+        [[nodiscard]] FIELD_TYPE on_fail () const { return FIELD_TYPE::IDENTIFIER; }
+    };
+
+    const FIELD_TYPE key_type = array_type.inner_type().try_visit_identifier(KeyTypeVisitor{key});
+    if (key_type < FIELD_TYPE::UINT8 || key_type > FIELD_TYPE::FLOAT64) return false;
+
+    array_type.sort_key = key;
+    array_type.sort_key_type = key_type;
+    array_type.eytzinger = eytzinger;
+    return true;
+}
+
 }
@@ -1,10 +1,12 @@
 #pragma once
 
+#include <algorithm>
 #include <bit>
 #include <cstddef>
 #include <cstdint>
 #include <cstdlib>
 #include <gsl/pointers>
+#include <span>
 #include <type_traits>
 #include <immintrin.h>
 #include <xmmintrin.h>
@@ -75,6 +77,32 @@ enum class FillDirection : uint8_t {
     FROM
 };
 
+// Host specific choices written by the `tune` target (see bench/CMakeLists.txt), otherwise the defaults below.
+#if __has_include(<dp_bitset_tuning.generated.hpp>)
+#include <dp_bitset_tuning.generated.hpp>
+#endif
+
+#ifndef DP_BITSET_ONES_STRATEGY
+#define DP_BITSET_ONES_STRATEGY HYBRID_LUT_VECTOR
+#endif
+
+#ifndef DP_BITSET_TILE_BYTES
+#define DP_BITSET_TILE_BYTES 2048
+#endif
+
+#ifndef DP_BITSET_APPLY_BATCH_SIZE
+#define DP_BITSET_APPLY_BATCH_SIZE 4
+#endif
+
+constexpr OnesStrategys DEFAULT_ONES_STRATEGY = OnesStrategys::DP_BITSET_ONES_STRATEGY;
+
+// Blocking parameters of apply_nums_unsafe. A tile plus one double sized window per batched num should stay L1 resident.
+constexpr uint32_t TILE_BYTES = DP_BITSET_TILE_BYTES;
+constexpr num_t TILE_WORDS = TILE_BYTES / WORD_BYTES;
+constexpr uint8_t APPLY_BATCH_SIZE = DP_BITSET_APPLY_BATCH_SIZE;
+
+static_assert(TILE_WORDS > 0 && APPLY_BATCH_SIZE > 0);
+
 namespace detail {
     template <FillDirection direction>
     [[nodiscard, gnu::always_inline]] constexpr slane_t make_partial_lane (const uint16_t n) {
@@ -98,7 +126,7 @@ namespace detail {
 
 
 // 0 <= n < WORD_BITS
-template <FillDirection direction, OnesStrategys strategy = OnesStrategys::HYBRID_LUT_VECTOR>
+template <FillDirection direction, OnesStrategys strategy = DEFAULT_ONES_STRATEGY>
 [[nodiscard, gnu::always_inline]] constexpr word_t ones (const uint16_t n) {
     if constexpr (strategy == OnesStrategys::FULL_LUT) {
         struct Table {
@@ -284,6 +312,46 @@ constexpr __m512i mm512_lsl_epi64_idxs[9] {
     }
 }
 
+/**
+ * Shift-or of `num` for the `out_count` words of one tile.
+ * `in[i - word_shift]` and `in[i - word_shift - 1]` have to hold the source words of `out[i]` from before applying `num`.
+ */
+[[gnu::always_inline]] inline void apply_num_window_unsafe (const num_t num, const word_t* const in, word_t* const out, const num_t out_count) {
+    const uint8_t bit_shift = num % LANE_BITS;
+    const uint8_t rbit_shift = LANE_BITS - bit_shift;
+    const uint8_t lane_shift = (num / LANE_BITS) % WORD_LANE_COUNT;
+    const num_t word_shift = num / WORD_BITS;
+
+    const word_t* const src = in - word_shift;
+
+    word_t prev = src[-1];
+    word_t prev_ovflw = _mm512_srli_epi64(prev, rbit_shift);
+    word_t prev_lane_bit_shifted = _mm512_slli_epi64(prev, bit_shift);
+
+    for (num_t i = 0; i < out_count; i++) {
+        word_t curr = src[i];
+
+        word_t curr_ovflw = _mm512_srli_epi64(curr, rbit_shift);
+        word_t curr_lane_bit_shifted = _mm512_slli_epi64(curr, bit_shift);
+        word_t curr_bit_shifted = _mm512_or_si512(
+            curr_lane_bit_shifted,
+            _mm512_alignr_epi64(curr_ovflw, prev_ovflw, WORD_LANE_COUNT - 1)
+        );
+        word_t prev_bit_shifted = _mm512_or_si512(
+            prev_lane_bit_shifted,
+            _mm512_alignr_epi64(prev_ovflw, _mm512_setzero_si512(), WORD_LANE_COUNT - 1)
+        );
+
+        out[i] = _mm512_or_si512(
+            out[i],
+            mm512_lsl_epi64_(curr_bit_shifted, prev_bit_shifted, lane_shift)
+        );
+
+        prev_ovflw = curr_ovflw;
+        prev_lane_bit_shifted = curr_lane_bit_shifted;
+    }
+}
+
 #undef mm512_lsl_epi64_
 
 #elif __AVX2__
@@ -378,6 +446,42 @@ template <size_t lane_shift>
     }
 }
 
+template <size_t lane_shift>
+[[clang::always_inline]] inline void apply_num_window_unsafe_ (const num_t num, const word_t* const in, word_t* const out, const num_t out_count) {
+    const uint8_t bit_shift = num % LANE_BITS;
+    const uint8_t rbit_shift = LANE_BITS - bit_shift;
+    const num_t word_shift = num / WORD_BITS;
+
+    const word_t* const src = in - word_shift;
+
+    word_t prev = src[-1];
+    word_t prev_ovflw = _mm256_srli_epi64(prev, rbit_shift);
+    word_t prev_lane_bit_shifted = _mm256_slli_epi64(prev, bit_shift);
+
+    for (num_t i = 0; i < out_count; i++) {
+        word_t curr = src[i];
+
+        word_t curr_ovflw = _mm256_srli_epi64(curr, rbit_shift);
+        word_t curr_lane_bit_shifted = _mm256_slli_epi64(curr, bit_shift);
+        word_t curr_bit_shifted = _mm256_or_si256(
+            curr_lane_bit_shifted,
+            mm256_lsl_epi64_<1>(curr_ovflw, prev_ovflw)
+        );
+        word_t prev_bit_shifted = _mm256_or_si256(
+            prev_lane_bit_shifted,
+            mm256_lsl_epi64_<1>(prev_ovflw, _mm256_setzero_si256())
+        );
+
+        out[i] = _mm256_or_si256(
+            out[i],
+            mm256_lsl_epi64_<lane_shift>(curr_bit_shifted, prev_bit_shifted)
+        );
+
+        prev_ovflw = curr_ovflw;
+        prev_lane_bit_shifted = curr_lane_bit_shifted;
+    }
+}
+
 } // namespace
 
 [[gnu::always_inline]] inline void apply_num_unsafe (const num_t num, word_t* const words, num_t word_count) {
@@ -401,6 +505,94 @@ template <size_t lane_shift>
     }
 }
 
+/**
+ * Shift-or of `num` for the `out_count` words of one tile.
+ * `in[i - word_shift]` and `in[i - word_shift - 1]` have to hold the source words of `out[i]` from before applying `num`.
+ */
+[[gnu::always_inline]] inline void apply_num_window_unsafe (const num_t num, const word_t* const in, word_t* const out, const num_t out_count) {
+    const uint16_t lane_shift = (num / LANE_BITS) % WORD_LANE_COUNT;
+
+    switch (lane_shift) {
+        case 0:
+            apply_num_window_unsafe_<0>(num, in, out, out_count);
+            break;
+        case 1:
+            apply_num_window_unsafe_<1>(num, in, out, out_count);
+            break;
+        case 2:
+            apply_num_window_unsafe_<2>(num, in, out, out_count);
+            break;
+        case 3:
+            apply_num_window_unsafe_<3>(num, in, out, out_count);
+            break;
+        default:
+            std::unreachable();
+    }
+}
+
 #endif
 
+namespace detail {
+    template <num_t tile_words, uint8_t batch_size>
+    inline void apply_num_batch_unsafe (const std::span<const num_t> nums, word_t* const words, const num_t word_count) {
+        alignas(WORD_BYTES) word_t windows[batch_size][2 * tile_words];
+        num_t tiled_nums[batch_size];
+        uint8_t tiled_count = 0;
+
+        for (const num_t num : nums) {
+            if (num / WORD_BITS < tile_words) {
+                tiled_nums[tiled_count++] = num;
+            } else {
+                // Reaches back further than one tile. Applying the nums is commutative so it can go first.
+                apply_num_unsafe(num, words, word_count);
+            }
+        }
+
+        if (tiled_count == 0) return;
+
+        for (uint8_t i = 0; i < tiled_count; i++) {
+            std::fill_n(windows[i], tile_words, mmXXX_setzero_siXXX());
+        }
+
+        for (num_t tile_start = 0; tile_start < word_count; tile_start += tile_words) {
+            word_t* const tile = words + tile_start;
+            const num_t tile_count = std::min(tile_words, word_count - tile_start);
+
+            for (uint8_t i = 0; i < tiled_count; i++) {
+                word_t* const window = windows[i];
+                if (tile_start != 0) {
+                    // Only the words reaching across the tile boundary are needed from the previous tile, which was a full one.
+                    const num_t carry_words = (tiled_nums[i] / WORD_BITS) + 1;
+                    std::copy_n(window + (2 * tile_words) - carry_words, carry_words, window + tile_words - carry_words);
+                }
+                std::copy_n(tile, tile_count, window + tile_words);
+                apply_num_window_unsafe(tiled_nums[i], window + tile_words, tile, tile_count);
+            }
+        }
+    }
+}
+
+/**
+ * Same result as calling `apply_num_unsafe` for each num, but walks the words in tiles of `tile_bytes`
+ * and applies up to `batch_size` nums per tile while it is cache resident.
+ * Each num keeps its own copy of the words of the current and the previous tile from before it was applied,
+ * which provides the carries across the tile boundary.
+ */
+template <uint32_t tile_bytes = TILE_BYTES, uint8_t batch_size = APPLY_BATCH_SIZE>
+inline void apply_nums_unsafe (const std::span<const num_t> nums, word_t* const words, const num_t word_count) {
+    constexpr num_t tile_words = tile_bytes / WORD_BYTES;
+    static_assert(tile_words > 0 && batch_size > 0);
+
+    if (word_count <= tile_words) {
+        for (const num_t num : nums) {
+            apply_num_unsafe(num, words, word_count);
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < nums.size(); i += batch_size) {
+        detail::apply_num_batch_unsafe<tile_words, batch_size>(nums.subspan(i, std::min<size_t>(batch_size, nums.size() - i)), words, word_count);
+    }
+}
+
 } // namespace dp_bitset_base
\ No newline at end of file
@@ -0,0 +1,20 @@
+# Runs COMMAND (a |-separated list) and fails unless its output matches every |-separated regex of EXPECTED
+string(REPLACE "|" ";" COMMAND "${COMMAND}")
+string(REPLACE "|" ";" EXPECTED "${EXPECTED}")
+
+execute_process(
+    COMMAND ${COMMAND}
+    OUTPUT_VARIABLE OUTPUT
+    ERROR_VARIABLE OUTPUT
+    RESULT_VARIABLE RESULT
+)
+
+if(NOT RESULT EQUAL 0)
+    message(FATAL_ERROR "${COMMAND} failed with ${RESULT}:\n${OUTPUT}")
+endif()
+
+foreach(REGEX IN LISTS EXPECTED)
+    if(NOT OUTPUT MATCHES "${REGEX}")
+        message(FATAL_ERROR "Output does not match \"${REGEX}\":\n${OUTPUT}")
+    endif()
+endforeach()
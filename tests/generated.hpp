@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+#include <unistd.h>
+
+namespace test {
+
+/**
+ * Zeroed bytes for one message of a header generated from tests/schemas, aligned like the buffers of the runtimes.
+ */
+template <typename T, size_t size = T::max_byte_size>
+struct MessageBuffer {
+    alignas(T::alignment) std::byte bytes[size] {};
+
+    std::byte* data () { return bytes; }
+    [[nodiscard]] size_t base () const { return reinterpret_cast<size_t>(bytes); }
+    [[nodiscard]] T view () const { return T{base()}; }
+};
+
+/**
+ * First and one past the last byte write(T) changes in a zeroed message, {size, 0} if it changes none.
+ * Setters of leafs the test knows nothing about are found this way without knowing their offsets.
+ */
+template <typename T, typename F, size_t size = T::max_byte_size>
+std::pair<size_t, size_t> written_range (F&& write) {
+    MessageBuffer<T, size> buffer;
+    write(buffer.view());
+    size_t first = size;
+    size_t end = 0;
+    for (size_t i = 0; i < size; i++) {
+        if (buffer.bytes[i] == std::byte{0}) continue;
+        if (first == size) first = i;
+        end = i + 1;
+    }
+    return {first, end};
+}
+
+template <typename T, typename F, size_t size = T::max_byte_size>
+size_t written_offset (F&& write) {
+    return written_range<T, F, size>(std::forward<F>(write)).first;
+}
+
+/**
+ * A file for the stream runtime, removed again when it goes out of scope.
+ */
+struct TempFile {
+    char path[32] = "/tmp/spc_test_XXXXXX";
+    int fd = ::mkstemp(path);
+
+    TempFile () = default;
+    TempFile (const TempFile&) = delete;
+    TempFile& operator = (const TempFile&) = delete;
+    ~TempFile () {
+        ::close(fd);
+        ::unlink(path);
+    }
+};
+
+} // namespace test
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "./generated.hpp"
+#include "message.generated.hpp"
+
+namespace test {
+
+inline std::string symbol_of (const uint64_t i) {
+    return std::string(i % 20, static_cast<char>('A' + (i % 26)));
+}
+
+/**
+ * Message i of a test stream, the symbol grows with i so the messages differ in size.
+ */
+inline void fill_message (MessageBuffer<Message>& buffer, const uint64_t i) {
+    Message view = buffer.view();
+    view.set_seq(i);
+    view.set_price(static_cast<double>(i) / 4);
+    view.set_qty(static_cast<uint32_t>(i * 10));
+    const std::string symbol = symbol_of(i);
+    Message::Editor editor {buffer.data(), Message::max_byte_size};
+    static_cast<void>(editor.assign_symbol(symbol.data(), symbol.size()));
+}
+
+inline bool is_message (Message view, const uint64_t i) {
+    return view.seq() == i
+        && std::bit_cast<uint64_t>(view.price()) == std::bit_cast<uint64_t>(static_cast<double>(i) / 4)
+        && view.qty() == static_cast<uint32_t>(i * 10)
+        && std::string{view.symbol().c_str()} == symbol_of(i);
+}
+
+inline std::vector<MessageBuffer<Message>> make_messages (const uint64_t count) {
+    std::vector<MessageBuffer<Message>> messages (count);
+    for (uint64_t i = 0; i < count; i++) fill_message(messages[i], i);
+    return messages;
+}
+
+} // namespace test
@@ -0,0 +1,6 @@
+Paired.a 100
+Paired.b 90
+Paired.c 80
+Paired.d 10
+Paired.d>Paired.a 30
+Paired.a>Paired.d 20
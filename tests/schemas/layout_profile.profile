@@ -0,0 +1,6 @@
+Profiled.hottest 1000
+Profiled.warm 6
+Profiled.cold 9
+Profiled.early 5
+Profiled.late 5
+Profiled.warm 4
@@ -0,0 +1,103 @@
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include <boost/ut.hpp>
+#include "../../message.hpp"
+#include "bit_fields.generated.hpp"
+
+using namespace boost::ut;
+
+int main () {
+
+"Atomic accessors reach the leafs of the plain accessors"_test = [] {
+    test::MessageBuffer<Message> buffer;
+    Message view = buffer.view();
+
+    view.store_seq(5);
+    expect(eq(view.seq(), uint64_t{5}));
+    view.set_qty(7);
+    expect(eq(view.load_qty(std::memory_order_acquire), 7u));
+    view.store_price(1.5, std::memory_order_release);
+    expect(eq(std::bit_cast<uint64_t>(view.price()), std::bit_cast<uint64_t>(1.5)));
+    expect(eq(std::bit_cast<uint64_t>(view.load_price()), std::bit_cast<uint64_t>(1.5)));
+
+    expect(eq(view.fetch_add_qty(3), 7u));
+    expect(eq(view.qty(), 10u));
+    expect(eq(view.fetch_add_venue(2), uint16_t{0}));
+    expect(eq(view.venue(), uint16_t{2}));
+};
+
+"fetch_add from several threads loses no increment"_test = [] {
+    test::MessageBuffer<Message> buffer;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; i++) {
+        threads.emplace_back([&buffer] {
+            Message view = buffer.view();
+            for (int j = 0; j < 10000; j++) {
+                static_cast<void>(view.fetch_add_seq(1, std::memory_order_relaxed));
+                static_cast<void>(view.fetch_add_qty(2, std::memory_order_relaxed));
+            }
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+    expect(eq(buffer.view().load_seq(), uint64_t{40000}));
+    expect(eq(buffer.view().load_qty(), 80000u));
+};
+
+"Atomic accessors of bit fields keep the other bits of the word"_test = [] {
+    test::MessageBuffer<Flags> buffer;
+    Flags view = buffer.view();
+    view.set_level(7);
+    view.set_wide(12345);
+
+    view.store_active(true);
+    view.store_count(1000, std::memory_order_release);
+    view.store_locked(true);
+    view.store_active(false, std::memory_order_release);
+    expect(!view.load_active());
+    expect(view.load_locked(std::memory_order_acquire));
+    expect(!view.hidden());
+    expect(eq(view.load_count(), uint16_t{1000}));
+    expect(eq(view.load_level(), uint8_t{7}));
+    expect(eq(view.wide(), 12345u));
+
+    view.store_level(3);
+    view.store_wide(UINT32_MAX);
+    expect(eq(view.level(), uint8_t{3}));
+    expect(eq(view.load_wide(), uint32_t{UINT32_MAX}));
+    expect(eq(view.count(), uint16_t{1000}));
+    expect(view.locked());
+};
+
+"Bit fields of one word stored from several threads lose no store"_test = [] {
+    test::MessageBuffer<Flags> buffer;
+    std::vector<std::thread> threads;
+    threads.emplace_back([&buffer] {
+        Flags view = buffer.view();
+        for (int i = 0; i < 10000; i++) view.store_active(i % 2 == 0, std::memory_order_relaxed);
+    });
+    threads.emplace_back([&buffer] {
+        Flags view = buffer.view();
+        for (int i = 0; i < 10000; i++) view.store_hidden(i % 2 != 0, std::memory_order_relaxed);
+    });
+    threads.emplace_back([&buffer] {
+        Flags view = buffer.view();
+        for (uint16_t i = 0; i <= 1000; i++) view.store_count(i, std::memory_order_relaxed);
+    });
+    threads.emplace_back([&buffer] {
+        Flags view = buffer.view();
+        for (int i = 0; i < 10000; i++) view.store_level(static_cast<uint8_t>(3 + (i % 8)), std::memory_order_relaxed);
+    });
+    for (std::thread& thread : threads) thread.join();
+
+    Flags view = buffer.view();
+    expect(!view.load_active());
+    expect(view.load_hidden());
+    expect(eq(view.load_count(), uint16_t{1000}));
+    expect(eq(view.load_level(), uint8_t{10}));
+    expect(!view.load_locked());
+};
+
+}
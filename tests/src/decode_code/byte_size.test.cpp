@@ -0,0 +1,65 @@
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <boost/ut.hpp>
+#include "../../generated.hpp"
+#include "strings.generated.hpp"
+
+using namespace boost::ut;
+
+namespace {
+
+size_t string_start (test::MessageBuffer<Strings>& buffer, const char* const c_str) {
+    return static_cast<size_t>(reinterpret_cast<const std::byte*>(c_str) - buffer.data());
+}
+
+// One past the last byte of either string, the strings are the last leafs of the message.
+size_t strings_end (test::MessageBuffer<Strings>& buffer) {
+    Strings view = buffer.view();
+    return std::max(
+        string_start(buffer, view.name().c_str()) + size_t{view.name().size()},
+        string_start(buffer, view.note().c_str()) + size_t{view.note().size()}
+    );
+}
+
+} // namespace
+
+int main () {
+
+"Zeroed message holds strings of their min length"_test = [] {
+    test::MessageBuffer<Strings> buffer;
+    Strings view = buffer.view();
+    expect(eq(size_t{view.name().size()}, size_t{4}));
+    expect(eq(size_t{view.note().size()}, size_t{1}));
+    expect(eq(size_t{view.note().length()}, size_t{0}));
+
+    const size_t strings_start = std::min(string_start(buffer, view.name().c_str()), string_start(buffer, view.note().c_str()));
+    expect(eq(Strings::byte_size(buffer.data()), strings_start + 4 + 1));
+    expect(eq(Strings::byte_size(buffer.data()), strings_end(buffer)));
+};
+
+"byte_size follows the stored sizes"_test = [] {
+    test::MessageBuffer<Strings> buffer;
+    Strings::Editor editor {buffer.data(), Strings::max_byte_size};
+    expect(neq(editor.assign_name("static", 6), size_t{0}));
+    expect(neq(editor.assign_note("proto", 5), size_t{0}));
+
+    Strings view = buffer.view();
+    expect(eq(size_t{view.name().size()}, size_t{7}));
+    expect(eq(size_t{view.note().size()}, size_t{6}));
+    expect(eq(std::string{view.name().c_str()}, std::string{"static"}));
+    expect(eq(std::string{view.note().c_str()}, std::string{"proto"}));
+    expect(eq(Strings::byte_size(buffer.data()), strings_end(buffer)));
+};
+
+"Strings at their max length fill max_byte_size exactly"_test = [] {
+    test::MessageBuffer<Strings> buffer;
+    Strings::Editor editor {buffer.data(), Strings::max_byte_size};
+    const std::string longest (31, 'x');
+    expect(neq(editor.assign_name(longest.data(), 31), size_t{0}));
+    expect(neq(editor.assign_note(longest.data(), 15), size_t{0}));
+    expect(eq(Strings::byte_size(buffer.data()), strings_end(buffer)));
+    expect(eq(Strings::byte_size(buffer.data()), Strings::max_byte_size));
+};
+
+}
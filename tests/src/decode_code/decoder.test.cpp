@@ -0,0 +1,56 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <vector>
+#include <boost/ut.hpp>
+#include "../../message.hpp"
+
+using namespace boost::ut;
+
+int main () {
+
+"Fragments of every size decode to the message"_test = [] {
+    std::vector<test::MessageBuffer<Message>> messages = test::make_messages(20);
+    test::MessageBuffer<Message>& message = messages[19];
+    const size_t byte_size = Message::byte_size(message.data());
+
+    for (size_t fragment_size = 1; fragment_size <= byte_size; fragment_size++) {
+        Message::Decoder decoder;
+        size_t received = 0;
+        while (!decoder.done()) {
+            // Until the fixed region has arrived only it is needed, afterwards the whole message.
+            expect(le(received + decoder.bytes_needed(), byte_size));
+            const size_t count = std::min(fragment_size, byte_size - received);
+            received += decoder.feed(std::span<const std::byte>{message.data() + received, count});
+        }
+        expect(eq(received, byte_size));
+        expect(eq(decoder.bytes_needed(), size_t{0}));
+        expect(eq(reinterpret_cast<size_t>(decoder.data()) % Message::alignment, size_t{0}));
+        expect(std::memcmp(decoder.data(), message.data(), byte_size) == 0);
+        expect(test::is_message(decoder.view(), 19));
+    }
+};
+
+"Feed takes no bytes behind the message"_test = [] {
+    std::vector<test::MessageBuffer<Message>> messages = test::make_messages(8);
+    const size_t first_size = Message::byte_size(messages[5].data());
+    const size_t second_size = Message::byte_size(messages[7].data());
+    std::vector<std::byte> bytes (first_size + second_size);
+    std::memcpy(bytes.data(), messages[5].data(), first_size);
+    std::memcpy(bytes.data() + first_size, messages[7].data(), second_size);
+
+    Message::Decoder decoder;
+    expect(eq(decoder.feed(bytes), first_size));
+    expect(decoder.done());
+    expect(test::is_message(decoder.view(), 5));
+
+    decoder.reset();
+    expect(!decoder.done());
+    expect(eq(decoder.feed(std::span<const std::byte>{bytes}.subspan(first_size)), second_size));
+    expect(decoder.done());
+    expect(test::is_message(decoder.view(), 7));
+};
+
+}
@@ -0,0 +1,91 @@
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <boost/ut.hpp>
+#include "../../generated.hpp"
+#include "strings.generated.hpp"
+
+using namespace boost::ut;
+
+namespace {
+
+bool has_strings (Strings view, const std::string& name, const std::string& note) {
+    return std::string{view.name().c_str()} == name && size_t{view.name().size()} == name.size() + 1
+        && std::string{view.note().c_str()} == note && size_t{view.note().size()} == note.size() + 1;
+}
+
+} // namespace
+
+int main () {
+
+"Resizing a string keeps the other one"_test = [] {
+    test::MessageBuffer<Strings> buffer;
+    Strings::Editor editor {buffer.data(), Strings::max_byte_size};
+    buffer.view().set_id(42);
+    expect(neq(editor.assign_name("static", 6), size_t{0}));
+    expect(neq(editor.assign_note("proto", 5), size_t{0}));
+    expect(has_strings(editor.view(), "static", "proto"));
+
+    const size_t size = editor.size();
+    expect(eq(editor.resize_name(20), size + 13));
+    expect(eq(editor.size(), size + 13));
+    expect(std::string{editor.view().name().c_str()} == "static");
+    expect(std::string{editor.view().note().c_str()} == "proto");
+
+    expect(neq(editor.assign_name("a longer name", 13), size_t{0}));
+    expect(has_strings(editor.view(), "a longer name", "proto"));
+    expect(neq(editor.assign_note("", 0), size_t{0}));
+    expect(has_strings(editor.view(), "a longer name", ""));
+    expect(neq(editor.assign_name("abc", 3), size_t{0}));
+    expect(neq(editor.assign_note("note", 4), size_t{0}));
+    expect(has_strings(editor.view(), "abc", "note"));
+    expect(eq(editor.size(), Strings::byte_size(buffer.data())));
+    expect(eq(editor.view().id(), 42u));
+};
+
+"Sizes out of range fail and leave the message alone"_test = [] {
+    test::MessageBuffer<Strings> buffer;
+    Strings::Editor editor {buffer.data(), Strings::max_byte_size};
+    expect(neq(editor.assign_name("static", 6), size_t{0}));
+    expect(neq(editor.assign_note("proto", 5), size_t{0}));
+    const test::MessageBuffer<Strings> before = buffer;
+
+    expect(eq(editor.resize_name(3), size_t{0}));
+    expect(eq(editor.resize_name(33), size_t{0}));
+    expect(eq(editor.resize_note(0), size_t{0}));
+    expect(eq(editor.assign_note("sixteen chars ok", 16), size_t{0}));
+    expect(std::memcmp(before.bytes, buffer.bytes, Strings::max_byte_size) == 0);
+};
+
+"A fixed capacity editor fails where the message does not fit"_test = [] {
+    test::MessageBuffer<Strings> buffer;
+    expect(neq(Strings::Editor{buffer.data(), Strings::max_byte_size}.assign_name("static", 6), size_t{0}));
+    const size_t size = Strings::byte_size(buffer.data());
+
+    Strings::Editor editor {buffer.data(), size};
+    expect(eq(editor.assign_note("x", 1), size_t{0}));
+    expect(eq(editor.assign_name("statics", 7), size_t{0}));
+    expect(eq(editor.assign_name("stat", 4), size - 2));
+    expect(eq(editor.assign_note("xy", 2), size));
+    expect(has_strings(editor.view(), "stat", "xy"));
+};
+
+"An editor with slack grows its own copy"_test = [] {
+    test::MessageBuffer<Strings> buffer;
+    expect(neq(Strings::Editor{buffer.data(), Strings::max_byte_size}.assign_name("static", 6), size_t{0}));
+    const test::MessageBuffer<Strings> before = buffer;
+
+    Strings::Editor editor = Strings::Editor::with_slack(buffer.data(), 0);
+    const std::string name (31, 'n');
+    const std::string note (15, 'o');
+    expect(neq(editor.assign_name(name.data(), name.size()), size_t{0}));
+    expect(neq(editor.assign_note(note.data(), note.size()), size_t{0}));
+    expect(has_strings(editor.view(), name, note));
+    expect(eq(editor.size(), Strings::byte_size(editor.data())));
+    expect(eq(reinterpret_cast<size_t>(editor.data()) % Strings::alignment, size_t{0}));
+
+    expect(editor.data() != buffer.data());
+    expect(std::memcmp(before.bytes, buffer.bytes, Strings::max_byte_size) == 0);
+};
+
+}
@@ -0,0 +1,111 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <boost/ut.hpp>
+#include "../../generated.hpp"
+#include "delta_array.generated.hpp"
+#include "for_array.generated.hpp"
+
+using namespace boost::ut;
+
+namespace {
+
+template <typename T>
+std::vector<std::byte> message_bytes (test::MessageBuffer<T>& buffer) {
+    return {buffer.data(), buffer.data() + T::max_byte_size};
+}
+
+} // namespace
+
+int main () {
+
+"Delta encoded arrays decode to the prefix sums"_test = [] {
+    // 37 elements, 4 blocks of 8 and a tail behind the first one.
+    std::vector<int64_t> values {-1000};
+    for (int64_t i = 1; i < 37; i++) values.push_back(values.back() + ((i * 1237) % 65536));
+    test::MessageBuffer<Ticks> buffer;
+    Ticks view = buffer.view();
+    expect(view.ticks().encode(values.data()));
+
+    expect(eq(size_t{view.ticks().length()}, size_t{37}));
+    for (uint32_t i = 0; i < 37; i++) expect(eq(view.ticks().get(i), values[i]));
+
+    std::vector<int64_t> decoded (37);
+    view.ticks().decode(decoded.data());
+    expect(decoded == values);
+
+    size_t i = 0;
+    for (const int64_t value : view.ticks()) expect(eq(value, values[i++]));
+    expect(eq(i, size_t{37}));
+};
+
+"Delta encoding writes inside the message and refuses differences it can not store"_test = [] {
+    std::vector<int64_t> values (37, INT64_MIN);
+    values.back() = INT64_MIN + 65535;
+    const auto [first, end] = test::written_range<Ticks>([&values](Ticks view) {
+        expect(view.ticks().encode(values.data()));
+    });
+    expect(lt(first, end));
+    expect(le(end, Ticks::max_byte_size));
+
+    test::MessageBuffer<Ticks> buffer;
+    Ticks view = buffer.view();
+    expect(view.ticks().encode(values.data()));
+    const std::vector<std::byte> encoded = message_bytes(buffer);
+
+    std::vector<int64_t> too_wide = values;
+    too_wide.back() = INT64_MIN + 65536;
+    expect(!view.ticks().encode(too_wide.data()));
+    std::vector<int64_t> decreasing = values;
+    decreasing[10] = INT64_MIN + 1;
+    expect(!view.ticks().encode(decreasing.data()));
+    std::vector<int64_t> overflowing = values;
+    overflowing.back() = INT64_MAX;
+    expect(!view.ticks().encode(overflowing.data()));
+
+    expect(message_bytes(buffer) == encoded);
+    for (uint32_t i = 0; i < 37; i++) expect(eq(view.ticks().get(i), values[i]));
+};
+
+"Frame of reference encoded arrays decode to the reference plus the differences"_test = [] {
+    std::vector<uint32_t> values;
+    for (uint32_t i = 0; i < 20; i++) values.push_back(1000000 + ((i * 13) % 256));
+    test::MessageBuffer<Levels> buffer;
+    Levels view = buffer.view();
+    expect(view.levels().encode(values.data()));
+
+    expect(eq(size_t{view.levels().length()}, size_t{20}));
+    for (uint32_t i = 0; i < 20; i++) expect(eq(view.levels().get(i), values[i]));
+
+    std::vector<uint32_t> decoded (20);
+    view.levels().decode(decoded.data());
+    expect(decoded == values);
+
+    size_t i = 0;
+    for (const uint32_t value : view.levels()) expect(eq(value, values[i++]));
+    expect(eq(i, size_t{20}));
+};
+
+"Frame of reference encoding takes the smallest element as the reference"_test = [] {
+    std::vector<uint32_t> values (20, UINT32_MAX);
+    values[7] = UINT32_MAX - 255;
+    const auto [first, end] = test::written_range<Levels>([&values](Levels view) {
+        expect(view.levels().encode(values.data()));
+    });
+    expect(lt(first, end));
+    expect(le(end, Levels::max_byte_size));
+
+    test::MessageBuffer<Levels> buffer;
+    Levels view = buffer.view();
+    expect(view.levels().encode(values.data()));
+    for (uint32_t i = 0; i < 20; i++) expect(eq(view.levels().get(i), values[i]));
+    const std::vector<std::byte> encoded = message_bytes(buffer);
+
+    std::vector<uint32_t> too_wide = values;
+    too_wide[3] = *std::ranges::min_element(values) - 1;
+    expect(!view.levels().encode(too_wide.data()));
+    expect(message_bytes(buffer) == encoded);
+};
+
+}
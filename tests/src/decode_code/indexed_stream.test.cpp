@@ -0,0 +1,99 @@
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <boost/ut.hpp>
+#include "../../message.hpp"
+
+using namespace boost::ut;
+
+namespace {
+
+uint64_t ordered_key (Message view) {
+    return view.seq() * 10;
+}
+
+// Visits every key below 100 once, out of order.
+uint64_t unordered_key (Message view) {
+    return (view.seq() * 37) % 100;
+}
+
+template <typename KeyOf>
+void write_indexed (const test::TempFile& file, std::vector<test::MessageBuffer<Message>>& messages, KeyOf&& key_of) {
+    stream::IndexedWriter<Message> writer {file.fd, 8};
+    for (test::MessageBuffer<Message>& message : messages) expect(writer.write_with_key(message.data(), key_of));
+    expect(writer.finish());
+}
+
+} // namespace
+
+int main () {
+
+"Seek by message number and key in a key ordered file"_test = [] {
+    std::vector<test::MessageBuffer<Message>> messages = test::make_messages(100);
+    test::TempFile file;
+    write_indexed(file, messages, ordered_key);
+
+    stream::IndexedReader<Message> reader {file.path};
+    expect(reader.ok());
+    expect(reader.key_ordered());
+    expect(eq(reader.message_count(), uint64_t{100}));
+    expect(eq(reader.index().size(), size_t{13}));
+
+    expect(reader.seek(37));
+    expect(test::is_message(Message{reinterpret_cast<size_t>(reader.next())}, 37));
+    expect(!reader.seek(100));
+
+    // Key 375 lies between messages 37 and 38, the entry of messages 32 to 39 holds the first key above it.
+    expect(eq(reader.seek_key(375), uint64_t{32}));
+    expect(test::is_message(Message{reinterpret_cast<size_t>(reader.next())}, 32));
+    expect(eq(reader.seek_key(5000), uint64_t{100}));
+    expect(reader.next() == nullptr);
+};
+
+"Range queries of a key ordered file"_test = [] {
+    std::vector<test::MessageBuffer<Message>> messages = test::make_messages(100);
+    test::TempFile file;
+    write_indexed(file, messages, ordered_key);
+
+    stream::IndexedReader<Message> reader {file.path};
+    std::vector<uint64_t> seqs;
+    const size_t count = reader.for_each_in_range(200, 455, [&](Message view) { seqs.push_back(view.seq()); }, ordered_key);
+    expect(eq(count, size_t{26}));
+    for (size_t i = 0; i < seqs.size(); i++) expect(eq(seqs[i], 20 + i));
+
+    // Without key_of every message of the entries overlapping the range reaches f, messages 16 to 47.
+    expect(eq(reader.for_each_in_range(200, 455, [](Message /*unused*/) {}), size_t{32}));
+};
+
+"Range queries of an unordered file"_test = [] {
+    std::vector<test::MessageBuffer<Message>> messages = test::make_messages(100);
+    test::TempFile file;
+    write_indexed(file, messages, unordered_key);
+
+    stream::IndexedReader<Message> reader {file.path};
+    expect(reader.ok());
+    expect(!reader.key_ordered());
+    const size_t count = reader.for_each_in_range(10, 19, [](Message view) {
+        const uint64_t key = unordered_key(view);
+        expect(key >= 10 && key <= 19);
+    }, unordered_key);
+    expect(eq(count, size_t{10}));
+};
+
+"Seek behind a header with length prefix framing"_test = [] {
+    std::vector<test::MessageBuffer<Message>> messages = test::make_messages(20);
+    test::TempFile file;
+    {
+        stream::IndexedWriter<Message> writer {file.fd, 4, stream::Framing::LENGTH_PREFIX};
+        expect(writer.write_header("idx", 3));
+        for (uint64_t i = 0; i < messages.size(); i++) expect(writer.write(messages[i].data(), i));
+    }
+
+    stream::IndexedReader<Message> reader {file.path, 3, stream::Framing::LENGTH_PREFIX};
+    expect(reader.ok());
+    expect(reader.seek(13));
+    expect(test::is_message(Message{reinterpret_cast<size_t>(reader.next())}, 13));
+    expect(test::is_message(Message{reinterpret_cast<size_t>(reader.next())}, 14));
+};
+
+}
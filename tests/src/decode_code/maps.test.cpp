@@ -0,0 +1,116 @@
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <boost/ut.hpp>
+#include "../../generated.hpp"
+#include "scalar_map.generated.hpp"
+#include "string_map.generated.hpp"
+
+using namespace boost::ut;
+
+namespace {
+
+using PriceMap = decltype(std::declval<Prices>().prices());
+
+bool same_price (const double* const found, const double price) {
+    return found != nullptr && std::bit_cast<uint64_t>(*found) == std::bit_cast<uint64_t>(price);
+}
+
+bool has_id (Symbols view, const std::string_view key, const uint32_t id) {
+    const uint32_t* const found = view.ids().find(key);
+    return found != nullptr && *found == id;
+}
+
+} // namespace
+
+int main () {
+
+"An empty map finds nothing"_test = [] {
+    test::MessageBuffer<Prices> buffer;
+    expect(eq(buffer.view().prices().size(), 0u));
+    expect(buffer.view().prices().find(0) == nullptr);
+    expect(!buffer.view().prices().contains(7));
+};
+
+"find follows the probe sequence past full groups"_test = [] {
+    // 12 keys of the first group spill into the next one, the other 8 fill the table to capacity.
+    std::vector<uint32_t> keys;
+    for (uint32_t key = 1; keys.size() < 12; key++) {
+        if (PriceMap::group(PriceMap::hash(key)) == 0) keys.push_back(key);
+    }
+    for (uint32_t key = 1; keys.size() < 20; key++) {
+        if (PriceMap::group(PriceMap::hash(key)) != 0) keys.push_back(key);
+    }
+
+    test::MessageBuffer<Prices> buffer;
+    Prices view = buffer.view();
+    for (const uint32_t key : keys) expect(view.prices().insert(key, key * 0.5));
+
+    expect(eq(view.prices().size(), 20u));
+    for (const uint32_t key : keys) {
+        expect(same_price(view.prices().find(key), key * 0.5));
+        expect(view.prices().contains(key));
+    }
+    for (uint32_t key = 0; key < 2000; key++) {
+        if (std::find(keys.begin(), keys.end(), key) == keys.end()) expect(view.prices().find(key) == nullptr);
+    }
+};
+
+"String keys match whole keys only"_test = [] {
+    test::MessageBuffer<Symbols> buffer;
+    Symbols view = buffer.view();
+    expect(view.ids().insert("AAPL", 1));
+    expect(view.ids().insert("MSFT", 2));
+    expect(view.ids().insert("ABCDEFGH", 3));
+    expect(view.ids().insert("A", 4));
+
+    expect(eq(view.ids().size(), 4u));
+    expect(has_id(view, "AAPL", 1));
+    expect(has_id(view, "MSFT", 2));
+    expect(has_id(view, "ABCDEFGH", 3));
+    expect(has_id(view, "A", 4));
+    expect(view.ids().contains("MSFT"));
+
+    expect(view.ids().find("AAP") == nullptr);
+    expect(view.ids().find("AAPLX") == nullptr);
+    expect(view.ids().find("ABCDEFG") == nullptr);
+    expect(view.ids().find("ABCDEFGHI") == nullptr);
+    expect(!view.ids().contains("B"));
+};
+
+"insert overwrites present keys and stops at the capacity"_test = [] {
+    test::MessageBuffer<Prices> buffer;
+    Prices view = buffer.view();
+    for (uint32_t key = 0; key < PriceMap::capacity(); key++) expect(view.prices().insert(key, 1.0));
+    expect(view.prices().insert(3, 2.5));
+    expect(eq(view.prices().size(), PriceMap::capacity()));
+    expect(same_price(view.prices().find(3), 2.5));
+
+    expect(!view.prices().insert(PriceMap::capacity(), 1.0));
+    expect(view.prices().find(PriceMap::capacity()) == nullptr);
+    expect(eq(view.prices().size(), PriceMap::capacity()));
+};
+
+"insert writes inside the message and refuses keys longer than the slots"_test = [] {
+    const auto [first, end] = test::written_range<Symbols>([](Symbols view) { expect(view.ids().insert("ABCDEFGH", 1)); });
+    expect(lt(first, end));
+    expect(le(end, Symbols::max_byte_size));
+
+    test::MessageBuffer<Symbols> buffer;
+    Symbols view = buffer.view();
+    expect(!view.ids().insert("ABCDEFGHI", 1));
+    expect(eq(view.ids().size(), 0u));
+
+    // A prefix of a present key is a key of its own.
+    expect(view.ids().insert("ABCDEFGH", 2));
+    expect(view.ids().insert("ABC", 3));
+    expect(eq(view.ids().size(), 2u));
+    expect(has_id(view, "ABCDEFGH", 2));
+    expect(has_id(view, "ABC", 3));
+};
+
+}
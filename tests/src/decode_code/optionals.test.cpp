@@ -0,0 +1,161 @@
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <boost/ut.hpp>
+#include "../../generated.hpp"
+#include "optionals.generated.hpp"
+
+using namespace boost::ut;
+
+namespace {
+
+// Optionals a to f of tests/schemas/optionals.fbs
+constexpr size_t optional_count = 6;
+constexpr size_t value_sizes[optional_count] {8, 1, 4, 1, 2, 8};
+constexpr uint32_t pattern_count = 1u << optional_count;
+
+bool in_pattern (const uint32_t pattern, const size_t i) {
+    return ((pattern >> i) & 1) != 0;
+}
+
+size_t set_optional (Sparse::Editor& editor, const size_t i) {
+    switch (i) {
+        case 0:  return editor.set_a(0x0102030405060708);
+        case 1:  return editor.set_b(0x11);
+        case 2:  return editor.set_c(0x21222324);
+        case 3:  return editor.set_d(true);
+        case 4:  return editor.set_e(0x3132);
+        default: return editor.set_f(2.5);
+    }
+}
+
+size_t clear_optional (Sparse::Editor& editor, const size_t i) {
+    switch (i) {
+        case 0:  return editor.clear_a();
+        case 1:  return editor.clear_b();
+        case 2:  return editor.clear_c();
+        case 3:  return editor.clear_d();
+        case 4:  return editor.clear_e();
+        default: return editor.clear_f();
+    }
+}
+
+bool has_optional (Sparse view, const size_t i) {
+    switch (i) {
+        case 0:  return view.has_a();
+        case 1:  return view.has_b();
+        case 2:  return view.has_c();
+        case 3:  return view.has_d();
+        case 4:  return view.has_e();
+        default: return view.has_f();
+    }
+}
+
+bool holds_value (Sparse view, const size_t i) {
+    switch (i) {
+        case 0:  return view.a() == 0x0102030405060708;
+        case 1:  return view.b() == 0x11;
+        case 2:  return view.c() == 0x21222324;
+        case 3:  return view.d();
+        case 4:  return view.e() == 0x3132;
+        default: return std::bit_cast<uint64_t>(view.f()) == std::bit_cast<uint64_t>(2.5);
+    }
+}
+
+// A message with every optional absent.
+void fill_sparse (test::MessageBuffer<Sparse>& buffer) {
+    Sparse view = buffer.view();
+    view.set_id(7);
+    view.counts().set(0, 41);
+    view.counts().set(1, 42);
+    Sparse::Editor editor {buffer.data(), Sparse::max_byte_size};
+    static_cast<void>(editor.assign_name("sparse", 6));
+}
+
+// The optionals of the pattern hold their values, the others are absent and the leafs around them are unchanged.
+bool holds_pattern (const std::byte* const message, const uint32_t pattern) {
+    Sparse view {reinterpret_cast<size_t>(message)};
+    size_t values_size = 0;
+    for (size_t i = 0; i < optional_count; i++) {
+        if (has_optional(view, i) != in_pattern(pattern, i)) return false;
+        if (!in_pattern(pattern, i)) continue;
+        if (!holds_value(view, i)) return false;
+        values_size += value_sizes[i];
+    }
+    // The counts behind the values are aligned to 4 bytes.
+    return Sparse::optionals_size(reinterpret_cast<size_t>(message)) == ((values_size + 3) & ~size_t{3})
+        && view.id() == 7
+        && view.counts().length() == 2
+        && view.counts().get(0) == 41
+        && view.counts().get(1) == 42
+        && std::string{view.name().c_str()} == "sparse";
+}
+
+} // namespace
+
+int main () {
+
+"Every presence pattern reads back, whatever order the values are set in"_test = [] {
+    for (uint32_t pattern = 0; pattern < pattern_count; pattern++) {
+        test::MessageBuffer<Sparse> forward;
+        test::MessageBuffer<Sparse> backward;
+        fill_sparse(forward);
+        fill_sparse(backward);
+        Sparse::Editor forward_editor {forward.data(), Sparse::max_byte_size};
+        Sparse::Editor backward_editor {backward.data(), Sparse::max_byte_size};
+        for (size_t i = 0; i < optional_count; i++) {
+            if (in_pattern(pattern, i)) expect(neq(set_optional(forward_editor, i), size_t{0}));
+            if (in_pattern(pattern, optional_count - 1 - i)) expect(neq(set_optional(backward_editor, optional_count - 1 - i), size_t{0}));
+        }
+
+        expect(holds_pattern(forward.data(), pattern)) << "pattern " << pattern;
+        expect(holds_pattern(backward.data(), pattern)) << "pattern " << pattern;
+        expect(eq(Sparse::byte_size(forward.data()), Sparse::byte_size(backward.data())));
+    }
+};
+
+"Clearing takes out the values of every presence pattern"_test = [] {
+    for (uint32_t pattern = 0; pattern < pattern_count; pattern++) {
+        test::MessageBuffer<Sparse> buffer;
+        fill_sparse(buffer);
+        const size_t empty_size = Sparse::byte_size(buffer.data());
+        Sparse::Editor editor {buffer.data(), Sparse::max_byte_size};
+        for (size_t i = 0; i < optional_count; i++) static_cast<void>(set_optional(editor, i));
+        expect(holds_pattern(buffer.data(), pattern_count - 1));
+
+        size_t size = Sparse::byte_size(buffer.data());
+        for (size_t i = 0; i < optional_count; i++) {
+            if (!in_pattern(pattern, i)) size = clear_optional(editor, i);
+        }
+        expect(holds_pattern(buffer.data(), pattern)) << "pattern " << pattern;
+        expect(eq(size, Sparse::byte_size(buffer.data())));
+
+        for (size_t i = 0; i < optional_count; i++) size = clear_optional(editor, i);
+        expect(holds_pattern(buffer.data(), 0));
+        expect(eq(size, empty_size));
+    }
+};
+
+"Setting a present value keeps the byte size"_test = [] {
+    test::MessageBuffer<Sparse> buffer;
+    fill_sparse(buffer);
+    Sparse::Editor editor {buffer.data(), Sparse::max_byte_size};
+    const size_t size = editor.set_c(1);
+    expect(eq(editor.set_c(0x21222324), size));
+    expect(eq(editor.set_c(0x21222324), size));
+    expect(holds_pattern(buffer.data(), 1u << 2));
+};
+
+"A value which does not fit is not inserted"_test = [] {
+    test::MessageBuffer<Sparse> buffer;
+    fill_sparse(buffer);
+    Sparse::Editor editor {buffer.data(), Sparse::byte_size(buffer.data())};
+    expect(eq(editor.set_a(1), size_t{0}));
+    expect(holds_pattern(buffer.data(), 0));
+    // A clear never needs more room.
+    expect(eq(editor.clear_a(), Sparse::byte_size(buffer.data())));
+};
+
+}
@@ -0,0 +1,37 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <span>
+#include <vector>
+#include <boost/ut.hpp>
+#include "../../message.hpp"
+
+using namespace boost::ut;
+
+int main () {
+
+"for_each visits every message in order at any distance"_test = [] {
+    std::vector<test::MessageBuffer<Message>> messages = test::make_messages(20);
+    std::vector<const std::byte*> pointers;
+    for (test::MessageBuffer<Message>& message : messages) pointers.push_back(message.data());
+
+    for (const size_t distance : {size_t{0}, size_t{1}, size_t{3}, size_t{8}, size_t{19}, size_t{100}}) {
+        uint64_t i = 0;
+        Message::for_each(pointers, [&](Message view) { expect(test::is_message(view, i++)); }, distance);
+        expect(eq(i, uint64_t{20}));
+    }
+
+    uint64_t count = 0;
+    Message::for_each(std::span<const std::byte* const>{}, [&](Message /*unused*/) { count++; });
+    expect(eq(count, uint64_t{0}));
+};
+
+"prefetch leaves the message alone"_test = [] {
+    std::vector<test::MessageBuffer<Message>> messages = test::make_messages(4);
+    const test::MessageBuffer<Message> before = messages[3];
+    Message::prefetch(messages[3].data());
+    expect(std::memcmp(before.bytes, messages[3].bytes, Message::max_byte_size) == 0);
+};
+
+}
@@ -0,0 +1,166 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include <boost/ut.hpp>
+#include "../../message.hpp"
+
+using namespace boost::ut;
+
+namespace {
+
+constexpr uint64_t message_count = 10;
+
+void copy_message (std::byte* const slot, test::MessageBuffer<Message>& message) {
+    std::memcpy(slot, message.data(), Message::byte_size(message.data()));
+}
+
+Message view_of (const std::byte* const message) {
+    return Message{reinterpret_cast<size_t>(message)};
+}
+
+} // namespace
+
+int main () {
+
+"Spsc delivers messages in order across the wraparound"_test = [] {
+    using Ring = ring::Spsc<Message, 4>;
+    std::vector<test::MessageBuffer<Message>> messages = test::make_messages(message_count);
+    int fd = -1;
+    Ring* const producer = ring::create<Ring>("spc_test_spsc", fd);
+    expect(producer != nullptr);
+    // The consumer maps the ring a second time, as another process would.
+    Ring* const consumer = ring::attach<Ring>(fd);
+    expect(consumer != nullptr);
+
+    uint64_t produced = 0;
+    uint64_t consumed = 0;
+    while (consumed < message_count) {
+        for (std::byte* slot = producer->try_claim(); slot != nullptr && produced < message_count; slot = producer->try_claim()) {
+            expect(eq(reinterpret_cast<size_t>(slot) % Message::alignment, size_t{0}));
+            copy_message(slot, messages[produced++]);
+            producer->publish();
+        }
+        expect(produced - consumed == 4 || produced == message_count);
+        // Three at a time, so the indices wrap at a different slot every round.
+        for (int i = 0; i < 3; i++) {
+            const std::byte* const message = consumer->try_peek();
+            if (message == nullptr) break;
+            expect(test::is_message(view_of(message), consumed++));
+            consumer->consume();
+        }
+    }
+    expect(consumer->try_peek() == nullptr);
+
+    ring::detach(consumer);
+    ring::detach(producer);
+    ::close(fd);
+};
+
+"Mpsc delivers messages in ticket order across the wraparound"_test = [] {
+    using Ring = ring::Mpsc<Message, 4>;
+    std::vector<test::MessageBuffer<Message>> messages = test::make_messages(message_count);
+    int fd = -1;
+    Ring* const producer = ring::create<Ring>("spc_test_mpsc", fd);
+    expect(producer != nullptr);
+    Ring* const consumer = ring::attach<Ring>(fd);
+    expect(consumer != nullptr);
+
+    uint64_t produced = 0;
+    uint64_t consumed = 0;
+    while (consumed < message_count) {
+        uint64_t ticket = 0;
+        for (std::byte* slot = producer->try_claim(ticket); slot != nullptr && produced < message_count; slot = producer->try_claim(ticket)) {
+            expect(eq(ticket, produced));
+            copy_message(slot, messages[produced++]);
+            producer->publish(ticket);
+        }
+        expect(produced - consumed == 4 || produced == message_count);
+        for (int i = 0; i < 3; i++) {
+            const std::byte* const message = consumer->try_peek();
+            if (message == nullptr) break;
+            expect(test::is_message(view_of(message), consumed++));
+            consumer->consume();
+        }
+    }
+    expect(consumer->try_peek() == nullptr);
+
+    ring::detach(consumer);
+    ring::detach(producer);
+    ::close(fd);
+};
+
+"Mpsc holds back messages behind an unpublished ticket"_test = [] {
+    using Ring = ring::Mpsc<Message, 4>;
+    std::vector<test::MessageBuffer<Message>> messages = test::make_messages(2);
+    int fd = -1;
+    Ring* const mpsc = ring::create<Ring>("spc_test_mpsc", fd);
+    expect(mpsc != nullptr);
+
+    uint64_t first = 0;
+    uint64_t second = 0;
+    std::byte* const first_slot = mpsc->try_claim(first);
+    std::byte* const second_slot = mpsc->try_claim(second);
+    copy_message(second_slot, messages[1]);
+    mpsc->publish(second);
+    expect(mpsc->try_peek() == nullptr);
+
+    copy_message(first_slot, messages[0]);
+    mpsc->publish(first);
+    expect(test::is_message(view_of(mpsc->try_peek()), 0));
+    mpsc->consume();
+    expect(test::is_message(view_of(mpsc->try_peek()), 1));
+    mpsc->consume();
+    expect(mpsc->try_peek() == nullptr);
+
+    ring::detach(mpsc);
+    ::close(fd);
+};
+
+"Mpsc keeps the order of every producer"_test = [] {
+    using Ring = ring::Mpsc<Message, 8>;
+    constexpr uint32_t producer_count = 3;
+    constexpr uint64_t per_producer = 2000;
+    int fd = -1;
+    Ring* const mpsc = ring::create<Ring>("spc_test_mpsc", fd);
+    expect(mpsc != nullptr);
+
+    std::vector<std::thread> producers;
+    for (uint32_t p = 0; p < producer_count; p++) {
+        producers.emplace_back([mpsc, p] {
+            for (uint64_t i = 0; i < per_producer; i++) {
+                uint64_t ticket = 0;
+                std::byte* slot = mpsc->try_claim(ticket);
+                while (slot == nullptr) {
+                    std::this_thread::yield();
+                    slot = mpsc->try_claim(ticket);
+                }
+                Message view = view_of(slot);
+                view.set_seq(i);
+                view.set_qty(p);
+                mpsc->publish(ticket);
+            }
+        });
+    }
+
+    std::vector<uint64_t> next_seqs (producer_count, 0);
+    for (uint64_t received = 0; received < producer_count * per_producer;) {
+        const std::byte* const message = mpsc->try_peek();
+        if (message == nullptr) {
+            std::this_thread::yield();
+            continue;
+        }
+        Message view = view_of(message);
+        expect(eq(view.seq(), next_seqs[view.qty()]++));
+        mpsc->consume();
+        received++;
+    }
+    for (std::thread& producer : producers) producer.join();
+
+    ring::detach(mpsc);
+    ::close(fd);
+};
+
+}
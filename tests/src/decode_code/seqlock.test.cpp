@@ -0,0 +1,69 @@
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <thread>
+#include <boost/ut.hpp>
+#include "../../message.hpp"
+
+using namespace boost::ut;
+
+int main () {
+
+"A read sees the last write"_test = [] {
+    Message::Seqlock lock;
+    uint64_t seq = 1;
+    expect(lock.try_read([&](Message view) { seq = view.seq(); }));
+    expect(eq(seq, uint64_t{0}));
+
+    lock.write([](Message view) {
+        view.set_seq(5);
+        view.set_price(2.5);
+    });
+    lock.write([](Message view) { view.set_qty(3); });
+
+    uint32_t qty = 0;
+    double price = 0;
+    expect(lock.try_read([&](Message view) {
+        seq = view.seq();
+        qty = view.qty();
+        price = view.price();
+    }));
+    expect(eq(seq, uint64_t{5}));
+    expect(eq(qty, 3u));
+    expect(eq(std::bit_cast<uint64_t>(price), std::bit_cast<uint64_t>(2.5)));
+};
+
+"Readers never see a torn write"_test = [] {
+    constexpr uint64_t write_count = 20000;
+    Message::Seqlock lock;
+    std::atomic<bool> done {false};
+
+    std::thread writer {[&] {
+        for (uint64_t i = 1; i <= write_count; i++) {
+            lock.write([i](Message view) {
+                view.set_seq(i);
+                view.set_qty(static_cast<uint32_t>(i));
+                view.set_venue(static_cast<uint16_t>(i));
+            });
+        }
+        done.store(true, std::memory_order_release);
+    }};
+
+    uint64_t torn = 0;
+    uint64_t last_seq = 0;
+    while (!done.load(std::memory_order_acquire)) {
+        static_cast<void>(lock.try_read([&](Message view) {
+            const uint64_t seq = view.seq();
+            if (view.qty() != static_cast<uint32_t>(seq) || view.venue() != static_cast<uint16_t>(seq)) torn++;
+            if (seq < last_seq) torn++;
+            last_seq = seq;
+        }));
+    }
+    writer.join();
+
+    expect(eq(torn, uint64_t{0}));
+    expect(lock.try_read([&](Message view) { last_seq = view.seq(); }));
+    expect(eq(last_seq, write_count));
+};
+
+}
@@ -0,0 +1,102 @@
+#include <bit>
+#include <cstdint>
+#include <boost/ut.hpp>
+#include "../../generated.hpp"
+#include "bit_fields.generated.hpp"
+
+using namespace boost::ut;
+
+namespace {
+
+struct Values {
+    uint32_t id;
+    bool active;
+    uint8_t level;
+    bool hidden;
+    uint16_t count;
+    uint32_t wide;
+    bool locked;
+};
+
+// What a zeroed message holds, ranged integers store their distance to min.
+constexpr Values zeroed_values {0, false, 3, false, 0, 1, false};
+
+bool has_values (Flags view, const Values& values) {
+    return view.id() == values.id
+        && view.active() == values.active
+        && view.level() == values.level
+        && view.hidden() == values.hidden
+        && view.count() == values.count
+        && view.wide() == values.wide
+        && view.locked() == values.locked;
+}
+
+} // namespace
+
+int main () {
+
+"Zeroed message holds the min of every bit field"_test = [] {
+    test::MessageBuffer<Flags> buffer;
+    expect(has_values(buffer.view(), zeroed_values));
+};
+
+"Bit field setters keep their neighbours"_test = [] {
+    test::MessageBuffer<Flags> buffer;
+    Flags view = buffer.view();
+    Values values = zeroed_values;
+    // Every field goes to its min or max in every combination, all fields are checked after each single set.
+    for (uint32_t pattern = 0; pattern < 128; pattern++) {
+        const auto pick = [&](const uint32_t bit) { return ((pattern >> bit) & 1) != 0; };
+
+        values.id = pick(0) ? UINT32_MAX : 0;
+        view.set_id(values.id);
+        expect(has_values(view, values));
+        values.active = pick(1);
+        view.set_active(values.active);
+        expect(has_values(view, values));
+        values.level = pick(2) ? uint8_t{10} : uint8_t{3};
+        view.set_level(values.level);
+        expect(has_values(view, values));
+        values.hidden = pick(3);
+        view.set_hidden(values.hidden);
+        expect(has_values(view, values));
+        values.count = pick(4) ? uint16_t{1000} : uint16_t{0};
+        view.set_count(values.count);
+        expect(has_values(view, values));
+        values.wide = pick(5) ? UINT32_MAX : 1;
+        view.set_wide(values.wide);
+        expect(has_values(view, values));
+        values.locked = pick(6);
+        view.set_locked(values.locked);
+        expect(has_values(view, values));
+    }
+};
+
+"Emplace sets the id and zeroes only its alternative"_test = [] {
+    test::MessageBuffer<Flags> buffer;
+    Flags view = buffer.view();
+    const Values values {7, true, 9, false, 513, 123456789, true};
+    view.set_id(values.id);
+    view.set_active(values.active);
+    view.set_level(values.level);
+    view.set_hidden(values.hidden);
+    view.set_count(values.count);
+    view.set_wide(values.wide);
+    view.set_locked(values.locked);
+
+    view.kind().emplace_1();
+    view.kind().set_as_1(2.5);
+    expect(eq(view.kind().id(), 1));
+    view.kind().emplace_0();
+    expect(eq(view.kind().id(), 0));
+    expect(eq(view.kind().as_0(), 0));
+    expect(has_values(view, values));
+
+    view.kind().set_as_0(-7);
+    view.kind().emplace_1();
+    expect(eq(view.kind().id(), 1));
+    expect(eq(std::bit_cast<uint64_t>(view.kind().as_1()), uint64_t{0}));
+    expect(has_values(view, values));
+};
+
+}
@@ -0,0 +1,93 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <boost/ut.hpp>
+#include "../../generated.hpp"
+#include "sorted_arrays.generated.hpp"
+
+using namespace boost::ut;
+
+namespace {
+
+constexpr uint32_t length = 13;
+
+std::vector<uint32_t> sorted_ids () {
+    std::vector<uint32_t> ids;
+    for (uint32_t i = 1; i <= length; i++) ids.push_back(i * 10);
+    return ids;
+}
+
+// In-order walk of the implicit tree, the children of k are 2k and 2k + 1.
+void eytzinger_order (const std::vector<uint32_t>& sorted, std::vector<uint32_t>& out, size_t& next, const size_t k) {
+    if (k > sorted.size()) return;
+    eytzinger_order(sorted, out, next, 2 * k);
+    out[k - 1] = sorted[next++];
+    eytzinger_order(sorted, out, next, (2 * k) + 1);
+}
+
+void fill_book (Book view) {
+    const std::vector<uint32_t> sorted = sorted_ids();
+    std::vector<uint32_t> eytzinger (length);
+    size_t next = 0;
+    eytzinger_order(sorted, eytzinger, next, 1);
+    for (uint32_t i = 0; i < length; i++) {
+        view.asks().get(i).set_id(sorted[i]);
+        view.asks().get(i).set_qty(-static_cast<int64_t>(sorted[i]));
+        view.bids().get(i).set_id(eytzinger[i]);
+        view.bids().get(i).set_qty(-static_cast<int64_t>(eytzinger[i]));
+    }
+}
+
+} // namespace
+
+int main () {
+
+"lower_bound and find agree with std::lower_bound in sorted order"_test = [] {
+    test::MessageBuffer<Book> buffer;
+    Book view = buffer.view();
+    fill_book(view);
+    const std::vector<uint32_t> sorted = sorted_ids();
+
+    for (uint32_t key = 0; key <= 140; key++) {
+        const uint32_t expected = static_cast<uint32_t>(std::lower_bound(sorted.begin(), sorted.end(), key) - sorted.begin());
+        expect(eq(view.asks().lower_bound(key), expected));
+        const bool found = expected != length && sorted[expected] == key;
+        expect(eq(view.asks().find(key), found ? expected : length));
+    }
+    expect(eq(view.asks().get(view.asks().find(70)).qty(), int64_t{-70}));
+};
+
+"lower_bound and find reach the same elements in Eytzinger order"_test = [] {
+    test::MessageBuffer<Book> buffer;
+    Book view = buffer.view();
+    fill_book(view);
+    const std::vector<uint32_t> sorted = sorted_ids();
+
+    for (uint32_t key = 0; key <= 140; key++) {
+        const auto expected = std::lower_bound(sorted.begin(), sorted.end(), key);
+        const uint32_t idx = view.bids().lower_bound(key);
+        if (expected == sorted.end()) {
+            expect(eq(idx, length));
+        } else {
+            expect(lt(idx, length));
+            if (idx < length) expect(eq(view.bids().get(idx).id(), *expected));
+        }
+        const uint32_t found = view.bids().find(key);
+        if (expected != sorted.end() && *expected == key) {
+            expect(lt(found, length));
+            if (found < length) expect(eq(view.bids().get(found).qty(), -static_cast<int64_t>(key)));
+        } else {
+            expect(eq(found, length));
+        }
+    }
+};
+
+"The keys of a sorted array lie back to back"_test = [] {
+    const size_t first = test::written_offset<Book>([](Book view) { view.bids().get(0).set_id(1); });
+    for (uint32_t i = 1; i < length; i++) {
+        expect(eq(test::written_offset<Book>([i](Book view) { view.bids().get(i).set_id(1); }), first + (4 * size_t{i})));
+    }
+};
+
+}
@@ -0,0 +1,110 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <unistd.h>
+#include <boost/ut.hpp>
+#include "../../message.hpp"
+
+using namespace boost::ut;
+
+int main () {
+
+"Messages read back in order with byte size framing"_test = [] {
+    // More than one batch of the writer.
+    std::vector<test::MessageBuffer<Message>> messages = test::make_messages(300);
+    test::TempFile file;
+    {
+        stream::Writer<Message> writer {file.fd};
+        for (test::MessageBuffer<Message>& message : messages) expect(writer.write(message.data()));
+    }
+
+    stream::Reader<Message> reader {file.path};
+    expect(reader.ok());
+    uint64_t i = 0;
+    const size_t count = reader.for_each([&](Message view) {
+        expect(test::is_message(view, i));
+        i++;
+    });
+    expect(eq(count, size_t{300}));
+};
+
+"Messages and header read back with length prefix framing"_test = [] {
+    std::vector<test::MessageBuffer<Message>> messages = test::make_messages(40);
+    test::TempFile file;
+    {
+        stream::Writer<Message> writer {file.fd, stream::Framing::LENGTH_PREFIX};
+        expect(writer.write_header("spc", 3));
+        for (test::MessageBuffer<Message>& message : messages) expect(writer.write(message.data()));
+    }
+
+    stream::Reader<Message> reader {file.path, 3, stream::Framing::LENGTH_PREFIX};
+    expect(reader.ok());
+    expect(std::memcmp(reader.header().data(), "spc", 3) == 0);
+    uint64_t i = 0;
+    for (const std::byte* message = reader.next(); message != nullptr; message = reader.next()) {
+        expect(eq(reinterpret_cast<size_t>(message) % Message::alignment, size_t{0}));
+        expect(test::is_message(Message{reinterpret_cast<size_t>(message)}, i));
+        i++;
+    }
+    expect(eq(i, uint64_t{40}));
+};
+
+"Reader stops in front of a truncated message"_test = [] {
+    std::vector<test::MessageBuffer<Message>> messages = test::make_messages(3);
+    test::TempFile file;
+    {
+        stream::Writer<Message> writer {file.fd};
+        for (test::MessageBuffer<Message>& message : messages) expect(writer.write(message.data()));
+    }
+    const size_t truncated_size = stream::padded(Message::byte_size(messages[0].data()), Message::alignment)
+        + stream::padded(Message::byte_size(messages[1].data()), Message::alignment)
+        + Message::byte_size(messages[2].data()) - 1;
+    expect(::ftruncate(file.fd, static_cast<off_t>(truncated_size)) == 0);
+
+    stream::Reader<Message> reader {file.path};
+    expect(test::is_message(Message{reinterpret_cast<size_t>(reader.next())}, 0));
+    expect(test::is_message(Message{reinterpret_cast<size_t>(reader.next())}, 1));
+    expect(reader.next() == nullptr);
+};
+
+"Reader stops in front of a message truncated inside its fixed region"_test = [] {
+    std::vector<test::MessageBuffer<Message>> messages = test::make_messages(3);
+    test::TempFile file;
+    {
+        stream::Writer<Message> writer {file.fd};
+        for (test::MessageBuffer<Message>& message : messages) expect(writer.write(message.data()));
+    }
+    const size_t truncated_size = stream::padded(Message::byte_size(messages[0].data()), Message::alignment)
+        + stream::padded(Message::byte_size(messages[1].data()), Message::alignment)
+        + Message::fixed_byte_size - 1;
+    expect(::ftruncate(file.fd, static_cast<off_t>(truncated_size)) == 0);
+
+    stream::Reader<Message> reader {file.path};
+    uint64_t i = 0;
+    const size_t count = reader.for_each([&](Message view) {
+        expect(test::is_message(view, i));
+        i++;
+    });
+    expect(eq(count, size_t{2}));
+    expect(reader.next() == nullptr);
+};
+
+"Reader stops at a length prefix that runs past the end of the stream"_test = [] {
+    std::vector<test::MessageBuffer<Message>> messages = test::make_messages(3);
+    test::TempFile file;
+    {
+        stream::Writer<Message> writer {file.fd, stream::Framing::LENGTH_PREFIX};
+        for (test::MessageBuffer<Message>& message : messages) expect(writer.write(message.data()));
+    }
+    // Added to the prefix size, this length wraps around to a frame smaller than the stream.
+    const uint64_t length = UINT64_MAX - stream::prefix_size<Message> + 1;
+    const size_t second = stream::prefix_size<Message> + stream::padded(Message::byte_size(messages[0].data()), Message::alignment);
+    expect(::pwrite(file.fd, &length, sizeof(length), static_cast<off_t>(second)) == static_cast<ssize_t>(sizeof(length)));
+
+    stream::Reader<Message> reader {file.path, 0, stream::Framing::LENGTH_PREFIX};
+    expect(test::is_message(Message{reinterpret_cast<size_t>(reader.next())}, 0));
+    expect(reader.next() == nullptr);
+};
+
+}
@@ -0,0 +1,145 @@
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include <boost/ut.hpp>
+#include "../../generated.hpp"
+#include "vectors.generated.hpp"
+
+using namespace boost::ut;
+
+namespace {
+
+std::string name_of (const uint32_t i) {
+    return std::string(1 + (i % 30), static_cast<char>('a' + (i % 26)));
+}
+
+void fill_features (test::MessageBuffer<Features>& buffer, const uint32_t i) {
+    Features view = buffer.view();
+    view.set_id(i);
+    for (uint16_t k = 0; k < Features::weights_length(); k++) view.data_weights()[k] = static_cast<float>(i * 8 + k);
+    for (uint16_t k = 0; k < Features::scores_length(); k++) view.data_scores()[k] = i + (k / 8.0);
+    const std::string name = name_of(i);
+    Features::Editor editor {buffer.data(), Features::max_byte_size};
+    static_cast<void>(editor.assign_name(name.data(), name.size()));
+}
+
+std::vector<test::MessageBuffer<Features>> make_features (const uint32_t count) {
+    std::vector<test::MessageBuffer<Features>> messages (count);
+    for (uint32_t i = 0; i < count; i++) fill_features(messages[i], i);
+    return messages;
+}
+
+bool is_aligned (const void* const pointer, const size_t alignment) {
+    return reinterpret_cast<size_t>(pointer) % alignment == 0;
+}
+
+// Both vectors point to aligned storage and hold the values fill_features wrote for message i.
+bool has_vectors (Features view, const uint32_t i) {
+    if (!is_aligned(view.weights(), 32) || !is_aligned(view.scores(), 64)) return false;
+    for (uint16_t k = 0; k < Features::weights_length(); k++) {
+        if (std::bit_cast<uint32_t>(view.weights()[k]) != std::bit_cast<uint32_t>(static_cast<float>(i * 8 + k))) return false;
+    }
+    for (uint16_t k = 0; k < Features::scores_length(); k++) {
+        if (std::bit_cast<uint64_t>(view.scores()[k]) != std::bit_cast<uint64_t>(i + (k / 8.0))) return false;
+    }
+    return true;
+}
+
+bool is_features (Features view, const uint32_t i) {
+    return view.id() == i && std::string{view.name().c_str()} == name_of(i) && has_vectors(view, i);
+}
+
+} // namespace
+
+int main () {
+
+"Vectors raise the message alignment to theirs"_test = [] {
+    static_assert(Features::alignment == 64);
+    static_assert(Features::weights_length() == 8);
+    static_assert(Features::scores_length() == 8);
+
+    test::MessageBuffer<Features> buffer;
+    Features view = buffer.view();
+    expect(is_aligned(view.weights(), 32));
+    expect(is_aligned(view.scores(), 64));
+    expect(static_cast<const void*>(view.data_weights()) == view.weights());
+    expect(static_cast<const void*>(view.data_scores()) == view.scores());
+};
+
+"Vectors keep their values and alignment in the Decoder"_test = [] {
+    std::vector<test::MessageBuffer<Features>> messages = make_features(3);
+    const size_t byte_size = Features::byte_size(messages[2].data());
+
+    Features::Decoder decoder;
+    size_t received = 0;
+    while (!decoder.done()) {
+        const size_t count = std::min<size_t>(7, byte_size - received);
+        received += decoder.feed(std::span<const std::byte>{messages[2].data() + received, count});
+    }
+    expect(is_features(decoder.view(), 2));
+};
+
+"Vectors keep their values and alignment while the Editor resizes the name"_test = [] {
+    test::MessageBuffer<Features> buffer;
+    fill_features(buffer, 4);
+
+    Features::Editor editor = Features::Editor::with_slack(buffer.data(), 0);
+    const std::string name = name_of(29);
+    expect(neq(editor.assign_name(name.data(), name.size()), size_t{0}));
+    Features view = editor.view();
+    expect(std::string{view.name().c_str()} == name);
+    expect(eq(view.id(), 4u));
+    expect(has_vectors(view, 4));
+};
+
+"Vectors keep their values and alignment through a stream"_test = [] {
+    std::vector<test::MessageBuffer<Features>> messages = make_features(40);
+    test::TempFile file;
+    {
+        stream::Writer<Features> writer {file.fd};
+        for (test::MessageBuffer<Features>& message : messages) expect(writer.write(message.data()));
+    }
+
+    stream::Reader<Features> reader {file.path};
+    expect(reader.ok());
+    uint32_t i = 0;
+    const size_t count = reader.for_each([&](Features view) {
+        expect(is_features(view, i)) << "message " << i;
+        i++;
+    });
+    expect(eq(count, size_t{40}));
+};
+
+"Vectors keep their values and alignment through a ring"_test = [] {
+    using Ring = ring::Spsc<Features, 4>;
+    std::vector<test::MessageBuffer<Features>> messages = make_features(10);
+    int fd = -1;
+    Ring* const producer = ring::create<Ring>("spc_test_vectors", fd);
+    expect(producer != nullptr);
+    Ring* const consumer = ring::attach<Ring>(fd);
+    expect(consumer != nullptr);
+
+    for (uint32_t i = 0; i < messages.size(); i++) {
+        std::byte* const slot = producer->try_claim();
+        expect(slot != nullptr);
+        std::memcpy(slot, messages[i].data(), Features::byte_size(messages[i].data()));
+        producer->publish();
+
+        const std::byte* const message = consumer->try_peek();
+        expect(message != nullptr);
+        expect(is_features(Features{reinterpret_cast<size_t>(message)}, i)) << "message " << i;
+        consumer->consume();
+    }
+
+    ring::detach(consumer);
+    ring::detach(producer);
+    ::close(fd);
+};
+
+}
@@ -0,0 +1,66 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <utility>
+#include <boost/ut.hpp>
+#include "../../generated.hpp"
+#include "bit_fields.generated.hpp"
+
+using namespace boost::ut;
+
+namespace {
+
+bool overlap (const std::pair<size_t, size_t> a, const std::pair<size_t, size_t> b) {
+    return a.first < b.second && b.first < a.second;
+}
+
+// The 8 byte word at offset after write(Flags) on a zeroed message.
+template <typename F>
+uint64_t written_word (const size_t offset, F&& write) {
+    test::MessageBuffer<Flags> buffer;
+    write(buffer.view());
+    uint64_t word = 0;
+    std::memcpy(&word, buffer.bytes + offset, sizeof(word));
+    return word;
+}
+
+} // namespace
+
+int main () {
+
+// 3 bools and ranged integers of 3, 10 and 32 bits take 48 bits, one word of 8 bytes.
+"Bit fields share one word without sharing bits"_test = [] {
+    const size_t offset = test::written_offset<Flags>([](Flags view) { view.set_wide(UINT32_MAX); }) / 8 * 8;
+    const uint64_t bits[] {
+        written_word(offset, [](Flags view) { view.set_active(true); }),
+        written_word(offset, [](Flags view) { view.set_level(10); }),
+        written_word(offset, [](Flags view) { view.set_hidden(true); }),
+        written_word(offset, [](Flags view) { view.set_count(1000); }),
+        written_word(offset, [](Flags view) { view.set_wide(UINT32_MAX); }),
+        written_word(offset, [](Flags view) { view.set_locked(true); })
+    };
+    for (size_t i = 0; i < std::size(bits); i++) {
+        expect(neq(bits[i], uint64_t{0}));
+        for (size_t j = i + 1; j < std::size(bits); j++) expect(eq(bits[i] & bits[j], uint64_t{0}));
+    }
+
+    // Setting every bit field at once changes nothing outside the word.
+    const auto all = test::written_range<Flags>([](Flags view) {
+        view.set_active(true);
+        view.set_level(10);
+        view.set_hidden(true);
+        view.set_count(1000);
+        view.set_wide(UINT32_MAX);
+        view.set_locked(true);
+    });
+    expect(ge(all.first, offset));
+    expect(le(all.second, offset + 8));
+
+    const auto id = test::written_range<Flags>([](Flags view) { view.set_id(UINT32_MAX); });
+    const auto kind = test::written_range<Flags>([](Flags view) { view.kind().set_as_1(-1.0); });
+    expect(!overlap(id, {offset, offset + 8}));
+    expect(!overlap(kind, {offset, offset + 8}));
+};
+
+}
@@ -0,0 +1,45 @@
+#include <cstdint>
+#include <boost/ut.hpp>
+#include "../../generated.hpp"
+#include "cacheline_fields.generated.hpp"
+
+using namespace boost::ut;
+
+namespace {
+
+constexpr size_t cache_line = 64;
+
+} // namespace
+
+int main () {
+
+// The array of uint32 is queued for an alignment of 4, it used to be placed by the subset sum solver without padding.
+"A cacheline unit of a smaller alignment does not straddle a line"_test = [] {
+    const size_t first = test::written_offset<Lines>([](Lines view) { view.pair().set(0, UINT32_MAX); });
+    const size_t last = test::written_range<Lines>([](Lines view) { view.pair().set(2, UINT32_MAX); }).second - 1;
+    expect(eq(last - first, size_t{11}));
+    expect(eq(first / cache_line, last / cache_line));
+};
+
+"A cacheline unit bigger than a line starts one"_test = [] {
+    const size_t first = test::written_offset<Lines>([](Lines view) { view.big().set(0, UINT64_MAX); });
+    expect(eq(first % cache_line, 0u));
+};
+
+"Fields around cacheline fields keep their values"_test = [] {
+    test::MessageBuffer<Lines> buffer;
+    Lines view = buffer.view();
+    for (uint32_t i = 0; i < 62; i++) view.head().set(i, static_cast<uint8_t>(i));
+    for (uint32_t i = 0; i < 3; i++) view.pair().set(i, 1000 + i);
+    for (uint32_t i = 0; i < 10; i++) view.big().set(i, uint64_t{1} << i);
+    view.set_note(7);
+    view.set_flag(9);
+
+    for (uint32_t i = 0; i < 62; i++) expect(eq(view.head().get(i), static_cast<uint8_t>(i)));
+    for (uint32_t i = 0; i < 3; i++) expect(eq(view.pair().get(i), 1000u + i));
+    for (uint32_t i = 0; i < 10; i++) expect(eq(view.big().get(i), uint64_t{1} << i));
+    expect(eq(view.note(), uint16_t{7}));
+    expect(eq(view.flag(), uint8_t{9}));
+};
+
+}
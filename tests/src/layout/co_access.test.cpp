@@ -0,0 +1,59 @@
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <boost/ut.hpp>
+#include "../../generated.hpp"
+#include "co_access.generated.hpp"
+
+using namespace boost::ut;
+
+int main () {
+
+// tests/schemas/co_access.profile counts a 100, b 90, c 80 and d 10 calls, and d right after a 20 + 30 times.
+"Fields accessed together are placed next to each other"_test = [] {
+    const size_t a = test::written_offset<Paired>([](Paired view) { view.set_a(UINT64_MAX); });
+    const size_t b = test::written_offset<Paired>([](Paired view) { view.set_b(UINT64_MAX); });
+    const size_t c = test::written_offset<Paired>([](Paired view) { view.set_c(UINT64_MAX); });
+    const size_t d = test::written_offset<Paired>([](Paired view) { view.set_d(UINT64_MAX); });
+
+    expect(eq(a, size_t{0}));
+    expect(eq(d, a + sizeof(uint64_t)));
+    // Without a partner of d the most called remaining field follows.
+    expect(lt(d, b));
+    expect(lt(b, c));
+};
+
+"Instrumented accessors count their calls and their followers"_test = [] {
+    test::TempFile file;
+    const std::string path = file.path;
+
+    // A fresh thread starts with no counters.
+    bool dumped = false;
+    std::thread{[&path, &dumped] {
+        test::MessageBuffer<Paired> buffer;
+        Paired view = buffer.view();
+        for (size_t i = 0; i < 3; i++) {
+            static_cast<void>(view.a());
+            static_cast<void>(view.c());
+        }
+        static_cast<void>(view.b());
+        dumped = layout_profile::dump(path.c_str());
+    }}.join();
+    expect(dumped);
+
+    std::ifstream dumped_file {path};
+    const std::string profile {std::istreambuf_iterator<char>{dumped_file}, std::istreambuf_iterator<char>{}};
+
+    expect(profile.contains("Paired.a 3\n"));
+    expect(profile.contains("Paired.c 3\n"));
+    expect(profile.contains("Paired.b 1\n"));
+    expect(profile.contains("Paired.a>Paired.c 3\n"));
+    expect(profile.contains("Paired.c>Paired.a 2\n"));
+    expect(profile.contains("Paired.c>Paired.b 1\n"));
+    expect(!profile.contains("Paired.d"));
+};
+
+}
@@ -0,0 +1,48 @@
+#include <cstdint>
+#include <boost/ut.hpp>
+#include "../../generated.hpp"
+#include "hot_fields.generated.hpp"
+
+using namespace boost::ut;
+
+namespace {
+
+constexpr size_t cache_line = 64;
+
+} // namespace
+
+int main () {
+
+"Hot fields lie in the first cache line"_test = [] {
+    const auto price = test::written_range<Hot>([](Hot view) { view.set_price(UINT64_MAX); });
+    const auto qty = test::written_range<Hot>([](Hot view) { view.set_qty(UINT32_MAX); });
+    expect(le(price.second, cache_line));
+    expect(le(qty.second, cache_line));
+};
+
+"A cacheline field does not straddle a line"_test = [] {
+    const size_t first = test::written_offset<Hot>([](Hot view) { view.window().set(0, UINT64_MAX); });
+    const size_t last = test::written_range<Hot>([](Hot view) { view.window().set(3, UINT64_MAX); }).second - 1;
+    expect(eq(last - first, size_t{31}));
+    expect(eq(first / cache_line, last / cache_line));
+};
+
+"Fields keep their values wherever they are placed"_test = [] {
+    test::MessageBuffer<Hot> buffer;
+    Hot view = buffer.view();
+    view.set_price(1);
+    view.set_qty(2);
+    view.set_note(3);
+    view.set_level(4);
+    for (uint32_t i = 0; i < 12; i++) view.history().set(i, 100 + i);
+    for (uint32_t i = 0; i < 4; i++) view.window().set(i, 200 + i);
+
+    expect(eq(view.price(), uint64_t{1}));
+    expect(eq(view.qty(), 2u));
+    expect(eq(view.note(), 3u));
+    expect(eq(view.level(), uint16_t{4}));
+    for (uint32_t i = 0; i < 12; i++) expect(eq(view.history().get(i), uint64_t{100} + i));
+    for (uint32_t i = 0; i < 4; i++) expect(eq(view.window().get(i), uint64_t{200} + i));
+};
+
+}
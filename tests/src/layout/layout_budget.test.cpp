@@ -0,0 +1,54 @@
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <boost/ut.hpp>
+#include "../../generated.hpp"
+#include "layout_budget.generated.hpp"
+
+using namespace boost::ut;
+
+namespace {
+
+bool overlap (const std::pair<size_t, size_t> a, const std::pair<size_t, size_t> b) {
+    return a.first < b.second && b.first < a.second;
+}
+
+} // namespace
+
+int main () {
+
+// The array can not end where the uint64 does, so the variant falls back to greedy packing, which the one millisecond
+// budget in layout_budget.options forces anyway.
+"The greedy fallback keeps the leafs apart and aligned"_test = [] {
+    const auto id = test::written_range<Budget>([](Budget view) { view.set_id(UINT32_MAX); });
+    const auto values = test::written_range<Budget>([](Budget view) {
+        view.choice().emplace_0();
+        for (uint32_t i = 0; i < 3; i++) view.choice().as_0().set(i, UINT32_MAX);
+    });
+    const auto value = test::written_range<Budget>([](Budget view) { view.choice().set_as_1(UINT64_MAX); });
+
+    expect(!overlap(id, value));
+    expect(eq(values.first % alignof(uint32_t), 0u));
+    expect(eq(value.first % alignof(uint64_t), 0u));
+    expect(eq(value.second - value.first, sizeof(uint64_t)));
+    expect(le(value.second, Budget::max_byte_size));
+};
+
+"Both alternatives round trip"_test = [] {
+    test::MessageBuffer<Budget> buffer;
+    Budget view = buffer.view();
+    view.set_id(42);
+
+    view.choice().emplace_0();
+    for (uint32_t i = 0; i < 3; i++) view.choice().as_0().set(i, 1000 + i);
+    expect(eq(view.choice().id(), 0));
+    for (uint32_t i = 0; i < 3; i++) expect(eq(view.choice().as_0().get(i), 1000u + i));
+
+    view.choice().emplace_1();
+    view.choice().set_as_1(0x0123456789ABCDEF);
+    expect(eq(view.choice().id(), 1));
+    expect(eq(view.choice().as_1(), uint64_t{0x0123456789ABCDEF}));
+    expect(eq(view.id(), 42u));
+};
+
+}
@@ -0,0 +1,30 @@
+#include <cstddef>
+#include <cstdint>
+#include <boost/ut.hpp>
+#include "../../generated.hpp"
+#include "layout_profile.generated.hpp"
+
+using namespace boost::ut;
+
+int main () {
+
+// tests/schemas/layout_profile.profile counts hottest 1000, warm 6 + 4, cold 9, early 5 and late 5 calls.
+"Fields are placed by descending profile counts"_test = [] {
+    const size_t hottest = test::written_offset<Profiled>([](Profiled view) { view.set_hottest(UINT64_MAX); });
+    const size_t warm = test::written_offset<Profiled>([](Profiled view) { view.set_warm(UINT64_MAX); });
+    const size_t cold = test::written_offset<Profiled>([](Profiled view) { view.set_cold(UINT64_MAX); });
+    const size_t early = test::written_offset<Profiled>([](Profiled view) { view.set_early(UINT64_MAX); });
+    const size_t late = test::written_offset<Profiled>([](Profiled view) { view.set_late(UINT64_MAX); });
+    const size_t unused = test::written_offset<Profiled>([](Profiled view) { view.set_unused(UINT64_MAX); });
+
+    expect(eq(hottest, size_t{0}));
+    // The counts of warm add up over its two lines.
+    expect(lt(hottest, warm));
+    expect(lt(warm, cold));
+    // Equal counts keep the declaration order, fields without a count come last.
+    expect(lt(cold, early));
+    expect(lt(early, late));
+    expect(lt(late, unused));
+};
+
+}
@@ -0,0 +1,65 @@
+#include <cstdint>
+#include <vector>
+#include <boost/ut.hpp>
+#include "../../../src/layout/LayoutReport.hpp"
+
+using namespace boost::ut;
+using layout::LayoutReport;
+
+namespace {
+
+AlignSizes pack_sizes (const uint64_t size_8, const uint64_t size_1) {
+    AlignSizes sizes = AlignSizes::zero();
+    sizes.get<SIZE::SIZE_8>() = size_8;
+    sizes.get<SIZE::SIZE_1>() = size_1;
+    return sizes;
+}
+
+} // namespace
+
+int main () {
+
+"Scopes build the field path and take it back"_test = [] {
+    LayoutReport report;
+    {
+        const auto field = LayoutReport::enter(&report, "orders");
+        const auto element = LayoutReport::enter_element(&report);
+        const auto alternative = LayoutReport::enter(&report, "as_", 1);
+        expect(report.path == "orders[].as_1");
+    }
+    expect(report.path.empty());
+
+    const auto none = LayoutReport::enter(nullptr, "ignored");
+    expect(none.report == nullptr);
+};
+
+"Variants are found by their field path, not the order they were added in"_test = [] {
+    LayoutReport report;
+    {
+        const auto outer = LayoutReport::enter(&report, "outer");
+        {
+            const auto alternative = LayoutReport::enter(&report, "as_", 0);
+            const auto inner = LayoutReport::enter(&report, "inner");
+            report.add_variant({1, 2}, pack_sizes(0, 2), 32);
+        }
+        report.add_variant({8, 3}, pack_sizes(8, 0), 32);
+    }
+    {
+        const auto other = LayoutReport::enter(&report, "other");
+        report.add_variant({4, 4}, pack_sizes(0, 4), 32);
+    }
+
+    const LayoutReport::Variant* const outer = report.find_variant("outer");
+    const LayoutReport::Variant* const inner = report.find_variant("outer.as_0.inner");
+    const LayoutReport::Variant* const other = report.find_variant("other");
+    expect(outer != nullptr && inner != nullptr && other != nullptr);
+    if (outer == nullptr || inner == nullptr || other == nullptr) return;
+
+    expect(eq(outer->size, 8u));
+    expect(outer->alternative_sizes == std::vector<uint64_t>{8, 3});
+    expect(eq(inner->size, 2u));
+    expect(eq(other->size, 4u));
+    expect(report.find_variant("inner") == nullptr);
+};
+
+}
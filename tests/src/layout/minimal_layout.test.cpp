@@ -0,0 +1,190 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <span>
+#include <utility>
+#include <vector>
+#include <boost/ut.hpp>
+#include "../../../src/layout/generation/variant_layout/minimal_layout.hpp"
+
+using namespace boost::ut;
+using layout::FixedOffset;
+using layout::generation::LayoutBudget;
+using layout::generation::PendingVariantFieldPacks;
+using layout::generation::QueuedField;
+using layout::generation::SimpleField;
+using layout::generation::SizeOptimization;
+using layout::generation::VariantLeafMeta;
+
+namespace {
+
+struct Field {
+    uint64_t size;
+    SIZE alignment;
+};
+
+using Variant = std::vector<Field>;
+
+constexpr SIZE pack_alignments[] {SIZE::SIZE_8, SIZE::SIZE_4, SIZE::SIZE_2, SIZE::SIZE_1};
+
+struct Group {
+    std::vector<QueuedField> queued_fields;
+    std::vector<VariantLeafMeta> metas;
+    std::vector<FixedOffset> fixed_offsets;
+    std::vector<uint16_t> variant_of;           // Indexed by map_idx
+    std::vector<Field> fields;                  // Indexed by map_idx
+
+    explicit Group (const std::vector<Variant>& variants) {
+        for (const Variant& variant : variants) {
+            VariantLeafMeta meta;
+            meta.used_space = 0;
+            const auto begin = static_cast<uint16_t>(queued_fields.size());
+            for (const Field& field : variant) {
+                const auto map_idx = static_cast<uint16_t>(queued_fields.size());
+                queued_fields.emplace_back(field.size, SimpleField{map_idx, field.alignment});
+                meta.required_spaces.get<estd::discouraged>(field.alignment) += field.size;
+                meta.left_fields.get<estd::discouraged>(field.alignment)++;
+                meta.used_space += field.size;
+                variant_of.push_back(static_cast<uint16_t>(metas.size()));
+                fields.push_back(field);
+            }
+            meta.field_idxs = {begin, static_cast<uint16_t>(queued_fields.size())};
+            metas.push_back(meta);
+        }
+        std::ranges::stable_sort(metas, [](const VariantLeafMeta& a, const VariantLeafMeta& b) { return a.used_space > b.used_space; });
+        fixed_offsets.assign(queued_fields.size(), FixedOffset::empty());
+    }
+
+    PendingVariantFieldPacks minimal_layout (SizeOptimization& size_optimization) {
+        LayoutBudget layout_budget = LayoutBudget::unbounded();
+        return layout::generation::variant_layout::minimal::apply_layout(
+            queued_fields,
+            fixed_offsets,
+            {},
+            metas,
+            0,
+            layout_budget,
+            size_optimization
+        );
+    }
+
+    // Every field is placed once, aligned, inside its pack and apart from the other fields of its variant.
+    [[nodiscard]] bool is_valid (const PendingVariantFieldPacks& packs) const {
+        std::vector<size_t> placements (fields.size(), 0);
+        for (const SIZE pack_alignment : pack_alignments) {
+            const auto& [pack_size, fixed_offset_idxs] = packs.get<estd::discouraged>(pack_alignment);
+            const std::span<const FixedOffset> pack = fixed_offset_idxs.access_subspan(fixed_offsets.data());
+            for (const FixedOffset& a : pack) {
+                const Field& field = fields[a.map_idx];
+                placements[a.map_idx]++;
+                if (a.pack_align != pack_alignment || field.alignment > pack_alignment) return false;
+                if (a.offset % field.alignment.byte_size() != 0 || a.offset + field.size > pack_size) return false;
+                for (const FixedOffset& b : pack) {
+                    if (a.map_idx == b.map_idx || variant_of[a.map_idx] != variant_of[b.map_idx]) continue;
+                    if (a.offset < b.offset + fields[b.map_idx].size && b.offset < a.offset + field.size) return false;
+                }
+            }
+        }
+        return std::ranges::all_of(placements, [](const size_t count) { return count == 1; });
+    }
+};
+
+// Smallest size over every placement of the fields into packs, fields of a pack are placed by decreasing alignment.
+uint64_t brute_force_size (const std::vector<Variant>& variants) {
+    std::vector<const Field*> fields;
+    std::vector<size_t> variant_of;
+    for (size_t v = 0; v < variants.size(); v++) {
+        for (const Field& field : variants[v]) {
+            fields.push_back(&field);
+            variant_of.push_back(v);
+        }
+    }
+
+    uint64_t best = static_cast<uint64_t>(-1);
+    std::vector<uint8_t> packs (fields.size(), 0);
+    while (true) {
+        uint64_t size = 0;
+        for (uint8_t pack = 0; pack < 4; pack++) {
+            std::vector<uint64_t> loads (variants.size(), 0);
+            for (const SIZE alignment : pack_alignments) {
+                for (size_t i = 0; i < fields.size(); i++) {
+                    if (packs[i] != pack || fields[i]->alignment != alignment) continue;
+                    loads[variant_of[i]] = math::next_multiple(loads[variant_of[i]], alignment) + fields[i]->size;
+                }
+            }
+            size += math::next_multiple(std::ranges::max(loads), pack_alignments[pack]);
+        }
+        best = std::min(best, size);
+
+        // Next placement, a field only goes into packs of at least its alignment.
+        size_t i = 0;
+        while (i < packs.size() && pack_alignments[packs[i]] == fields[i]->alignment) packs[i++] = 0;
+        if (i == packs.size()) return best;
+        packs[i]++;
+    }
+}
+
+std::vector<Variant> random_variants (std::mt19937& rng) {
+    std::vector<Variant> variants (2 + (rng() % 3));
+    size_t left_fields = 8 - variants.size();
+    for (Variant& variant : variants) {
+        const size_t extra_fields = left_fields == 0 ? 0 : rng() % std::min<size_t>(left_fields + 1, 3);
+        left_fields -= extra_fields;
+        for (size_t i = 0; i <= extra_fields; i++) {
+            const SIZE alignment = pack_alignments[rng() % 4];
+            const uint64_t count = rng() % 3 == 0 ? 1 + (rng() % 5) : 1;
+            variant.push_back({alignment.byte_size() * count, alignment});
+        }
+    }
+    return variants;
+}
+
+} // namespace
+
+int main () {
+
+"Variants without a perfect layout share the biggest pack"_test = [] {
+    // The array does not fit next to the uint64, the greedy layout takes 8 + 12 + 1 bytes.
+    Group group {{
+        {{12, SIZE::SIZE_4}},
+        {{8, SIZE::SIZE_8}, {1, SIZE::SIZE_1}}
+    }};
+    SizeOptimization size_optimization;
+    const PendingVariantFieldPacks packs = group.minimal_layout(size_optimization);
+
+    expect(group.is_valid(packs));
+    expect(eq(layout::generation::variant_layout::minimal::aligned_packs_size(packs), 16u));
+    expect(eq(size_optimization.bytes_saved, 5u));
+    expect(eq(size_optimization.unfinished_layouts, 0u));
+};
+
+"Variants which fit their biggest variant reach the lower bound"_test = [] {
+    Group group {{
+        {{8, SIZE::SIZE_8}, {4, SIZE::SIZE_4}, {2, SIZE::SIZE_2}, {2, SIZE::SIZE_2}},
+        {{4, SIZE::SIZE_4}, {4, SIZE::SIZE_4}, {1, SIZE::SIZE_1}, {1, SIZE::SIZE_1}},
+        {{16, SIZE::SIZE_8}}
+    }};
+    SizeOptimization size_optimization;
+    const PendingVariantFieldPacks packs = group.minimal_layout(size_optimization);
+
+    expect(group.is_valid(packs));
+    expect(eq(layout::generation::variant_layout::minimal::aligned_packs_size(packs), 16u));
+    expect(eq(size_optimization.lower_bound_layouts, 1u));
+};
+
+"The search matches a brute force over every placement"_test = [] {
+    std::mt19937 rng {29};
+    for (size_t i = 0; i < 300; i++) {
+        const std::vector<Variant> variants = random_variants(rng);
+        Group group {variants};
+        SizeOptimization size_optimization;
+        const PendingVariantFieldPacks packs = group.minimal_layout(size_optimization);
+
+        expect(group.is_valid(packs)) << "case " << i;
+        expect(eq(layout::generation::variant_layout::minimal::aligned_packs_size(packs), brute_force_size(variants))) << "case " << i;
+        expect(eq(size_optimization.unfinished_layouts, 0u));
+    }
+};
+
+}
@@ -0,0 +1,88 @@
+#include <bit>
+#include <cstdint>
+#include <utility>
+#include <boost/ut.hpp>
+#include "../../generated.hpp"
+#include "separate_variants.generated.hpp"
+#include "shared_variants.generated.hpp"
+
+using namespace boost::ut;
+
+namespace {
+
+bool overlap (const std::pair<size_t, size_t> a, const std::pair<size_t, size_t> b) {
+    return a.first < b.second && b.first < a.second;
+}
+
+} // namespace
+
+int main () {
+
+"Variants sharing an id take less space than separate ones"_test = [] {
+    static_assert(Shared::max_byte_size < Separate::max_byte_size);
+};
+
+"Variants sharing an id overlay their alternatives"_test = [] {
+    const auto a = test::written_range<Shared>([](Shared view) { view.a().set_as_0(-1); });
+    const auto b = test::written_range<Shared>([](Shared view) { view.b().set_as_0(-1); });
+    expect(overlap(a, b));
+
+    const auto separate_a = test::written_range<Separate>([](Separate view) { view.a().set_as_0(-1); });
+    const auto separate_b = test::written_range<Separate>([](Separate view) { view.b().set_as_0(-1); });
+    expect(!overlap(separate_a, separate_b));
+};
+
+"Variants sharing an id overlay whole members, not packs of the same alignment"_test = [] {
+    // c only fills a pack of 8 and d one of 1, both start the region.
+    const auto c = test::written_range<Shared>([](Shared view) { view.c().set_as_0(UINT64_MAX); });
+    const auto d = test::written_range<Shared>([](Shared view) {
+        view.d().emplace_0();
+        for (uint32_t i = 0; i < 8; i++) view.d().as_0().set(i, UINT8_MAX);
+        view.c().set_id(0);     // Back to the zeroed id, so only the region is written
+    });
+    expect(c == d);
+    expect(eq(c.second - c.first, sizeof(uint64_t)));
+};
+
+"Variants sharing an id have one id for the group"_test = [] {
+    test::MessageBuffer<Shared> buffer;
+    Shared view = buffer.view();
+
+    view.b().emplace_1();
+    expect(view.b().is_live());
+    expect(!view.a().is_live());
+    expect(eq(view.b().id(), 1));
+    expect(eq(view.a().group_id(), view.b().group_id()));
+
+    view.a().emplace_0();
+    expect(view.a().is_live());
+    expect(!view.b().is_live());
+    expect(eq(view.a().id(), 0));
+
+    view.d().emplace_1();
+    expect(view.d().is_live());
+    expect(!view.c().is_live());
+    expect(view.a().is_live());
+};
+
+"The live member of a shared id round trips"_test = [] {
+    test::MessageBuffer<Shared> buffer;
+    Shared view = buffer.view();
+    view.set_id(9);
+
+    view.a().emplace_1();
+    view.a().set_as_1(-123456);
+    expect(eq(view.a().id(), 1));
+    expect(eq(view.a().as_1(), -123456));
+
+    view.b().emplace_1();
+    view.b().set_as_1(0.75);
+    expect(eq(view.b().id(), 1));
+    expect(eq(std::bit_cast<uint64_t>(view.b().as_1()), std::bit_cast<uint64_t>(0.75)));
+    view.b().emplace_0();
+    view.b().set_as_0(INT64_MIN);
+    expect(eq(view.b().as_0(), INT64_MIN));
+    expect(eq(view.id(), 9u));
+};
+
+}
@@ -0,0 +1,63 @@
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <boost/ut.hpp>
+#include "../../generated.hpp"
+#include "soa_arrays.generated.hpp"
+
+using namespace boost::ut;
+
+namespace {
+
+bool overlap (const std::pair<size_t, size_t> a, const std::pair<size_t, size_t> b) {
+    return a.first < b.second && b.first < a.second;
+}
+
+} // namespace
+
+int main () {
+
+"Members of consecutive elements lie back to back"_test = [] {
+    const size_t x = test::written_offset<Cloud>([](Cloud view) { view.points().get(0).set_x(-1); });
+    const size_t y = test::written_offset<Cloud>([](Cloud view) { view.points().get(0).set_y(-1); });
+    const size_t z = test::written_offset<Cloud>([](Cloud view) { view.points().get(0).set_z(-1); });
+    for (uint32_t i = 1; i < 10; i++) {
+        expect(eq(test::written_offset<Cloud>([i](Cloud view) { view.points().get(i).set_x(-1); }), x + (4 * i)));
+        expect(eq(test::written_offset<Cloud>([i](Cloud view) { view.points().get(i).set_y(-1); }), y + (4 * i)));
+        expect(eq(test::written_offset<Cloud>([i](Cloud view) { view.points().get(i).set_z(-1); }), z + (2 * i)));
+    }
+    expect(!overlap({x, x + 40}, {y, y + 40}));
+    expect(!overlap({x, x + 40}, {z, z + 20}));
+    expect(!overlap({y, y + 40}, {z, z + 20}));
+
+    test::MessageBuffer<Cloud> buffer;
+    Cloud view = buffer.view();
+    expect(eq(reinterpret_cast<size_t>(view.points().column_x().data()) - buffer.base(), x));
+    expect(eq(reinterpret_cast<size_t>(view.points().column_y().data()) - buffer.base(), y));
+    expect(eq(reinterpret_cast<size_t>(view.points().column_z().data()) - buffer.base(), z));
+};
+
+"Columns hold the members of every element"_test = [] {
+    test::MessageBuffer<Cloud> buffer;
+    Cloud view = buffer.view();
+    view.set_id(77);
+    for (uint32_t i = 0; i < 10; i++) {
+        view.points().get(i).set_x(static_cast<int32_t>(i) * 3);
+        view.points().get(i).set_y(-static_cast<int32_t>(i));
+        view.points().get(i).set_z(static_cast<int16_t>(i + 100));
+    }
+
+    const std::span<const int32_t, 10> xs = view.points().column_x();
+    const std::span<const int32_t, 10> ys = view.points().column_y();
+    const std::span<const int16_t, 10> zs = view.points().column_z();
+    for (uint32_t i = 0; i < 10; i++) {
+        expect(eq(xs[i], static_cast<int32_t>(i) * 3));
+        expect(eq(ys[i], -static_cast<int32_t>(i)));
+        expect(eq(zs[i], static_cast<int16_t>(i + 100)));
+        expect(eq(view.points().get(i).x(), xs[i]));
+    }
+    expect(eq(view.id(), 77u));
+};
+
+}
@@ -0,0 +1,167 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include <boost/ut.hpp>
+#include "../../../src/layout/generation/variant_layout/variant_layout.hpp"
+
+using namespace boost::ut;
+using layout::FixedOffset;
+using layout::generation::LayoutBudget;
+using layout::generation::PendingVariantFieldPacks;
+using layout::generation::QueuedField;
+using layout::generation::SimpleField;
+using layout::generation::VariantLeafMeta;
+using layout::generation::variant_layout::LayoutUndo;
+
+namespace {
+
+struct Field {
+    uint64_t size;
+    SIZE alignment;
+};
+
+using Variant = std::vector<Field>;
+
+constexpr SIZE pack_alignments[] {SIZE::SIZE_8, SIZE::SIZE_4, SIZE::SIZE_2, SIZE::SIZE_1};
+
+struct Group {
+    std::vector<QueuedField> queued_fields;
+    std::vector<VariantLeafMeta> metas;
+    std::vector<FixedOffset> fixed_offsets;
+    std::vector<uint16_t> variant_of;           // Indexed by map_idx
+    std::vector<Field> fields;                  // Indexed by map_idx
+
+    explicit Group (const std::vector<Variant>& variants) {
+        for (const Variant& variant : variants) {
+            VariantLeafMeta meta;
+            meta.used_space = 0;
+            const auto begin = static_cast<uint16_t>(queued_fields.size());
+            for (const Field& field : variant) {
+                const auto map_idx = static_cast<uint16_t>(queued_fields.size());
+                queued_fields.emplace_back(field.size, SimpleField{map_idx, field.alignment});
+                meta.required_spaces.get<estd::discouraged>(field.alignment) += field.size;
+                meta.left_fields.get<estd::discouraged>(field.alignment)++;
+                meta.used_space += field.size;
+                variant_of.push_back(static_cast<uint16_t>(metas.size()));
+                fields.push_back(field);
+            }
+            meta.field_idxs = {begin, static_cast<uint16_t>(queued_fields.size())};
+            metas.push_back(meta);
+        }
+        std::ranges::stable_sort(metas, [](const VariantLeafMeta& a, const VariantLeafMeta& b) { return a.used_space > b.used_space; });
+        fixed_offsets.assign(queued_fields.size(), FixedOffset::empty());
+    }
+
+    PendingVariantFieldPacks layout (LayoutBudget& layout_budget) {
+        return layout::generation::variant_layout::apply_layout(queued_fields, fixed_offsets, {}, metas, 0, layout_budget);
+    }
+
+    // Every field is placed once, aligned, inside its pack and apart from the other fields of its variant.
+    [[nodiscard]] bool is_valid (const PendingVariantFieldPacks& packs) const {
+        std::vector<size_t> placements (fields.size(), 0);
+        for (const SIZE pack_alignment : pack_alignments) {
+            const auto& [pack_size, fixed_offset_idxs] = packs.get<estd::discouraged>(pack_alignment);
+            const std::span<const FixedOffset> pack = fixed_offset_idxs.access_subspan(fixed_offsets.data());
+            for (const FixedOffset& a : pack) {
+                const Field& field = fields[a.map_idx];
+                placements[a.map_idx]++;
+                if (a.pack_align != pack_alignment || field.alignment > pack_alignment) return false;
+                if (a.offset % field.alignment.byte_size() != 0 || a.offset + field.size > pack_size) return false;
+                for (const FixedOffset& b : pack) {
+                    if (a.map_idx == b.map_idx || variant_of[a.map_idx] != variant_of[b.map_idx]) continue;
+                    if (a.offset < b.offset + fields[b.map_idx].size && b.offset < a.offset + field.size) return false;
+                }
+            }
+        }
+        return std::ranges::all_of(placements, [](const size_t count) { return count == 1; });
+    }
+};
+
+bool same_metas (const std::span<const VariantLeafMeta> a, const std::span<const VariantLeafMeta> b) {
+    return std::ranges::equal(a, b, [](const VariantLeafMeta& x, const VariantLeafMeta& y) {
+        return std::ranges::all_of(pack_alignments, [&](const SIZE alignment) {
+                return x.required_spaces.get<estd::discouraged>(alignment) == y.required_spaces.get<estd::discouraged>(alignment)
+                    && x.left_fields.get<estd::discouraged>(alignment) == y.left_fields.get<estd::discouraged>(alignment);
+            })
+            && x.used_space == y.used_space
+            && *x.field_idxs.begin() == *y.field_idxs.begin()
+            && *x.field_idxs.end() == *y.field_idxs.end();
+    });
+}
+
+// Both variants fill 16 bytes exactly from their uint64 on.
+const std::vector<Variant> perfect_variants {
+    {{8, SIZE::SIZE_8}, {4, SIZE::SIZE_4}, {4, SIZE::SIZE_4}},
+    {{8, SIZE::SIZE_8}, {8, SIZE::SIZE_8}}
+};
+
+// The array can not end where the uint64 does, so no section of 8 fits both.
+const std::vector<Variant> imperfect_variants {
+    {{12, SIZE::SIZE_4}},
+    {{8, SIZE::SIZE_8}}
+};
+
+} // namespace
+
+int main () {
+
+"A perfect layout within the budget does not fall back"_test = [] {
+    Group group {perfect_variants};
+    LayoutBudget layout_budget = LayoutBudget::unbounded();
+    const PendingVariantFieldPacks packs = group.layout(layout_budget);
+
+    expect(group.is_valid(packs));
+    expect(eq(layout::generation::variant_layout::packs_size(packs), 16u));
+    expect(eq(layout_budget.greedy_layouts, 0u));
+};
+
+"An exhausted budget lays out the greedy incumbent"_test = [] {
+    Group group {perfect_variants};
+    const uint64_t greedy_size = layout::generation::variant_layout::greedy_layout_size(group.metas);
+    LayoutBudget layout_budget {LayoutBudget::clock::now()};
+    expect(layout_budget.exhausted());
+    const PendingVariantFieldPacks packs = group.layout(layout_budget);
+
+    expect(group.is_valid(packs));
+    expect(eq(layout::generation::variant_layout::packs_size(packs), greedy_size));
+    expect(eq(layout_budget.greedy_layouts, 1u));
+    expect(eq(layout_budget.bytes_above_lower_bound, greedy_size - 16));
+};
+
+"Variants without a perfect layout fall back to greedy packing"_test = [] {
+    Group group {imperfect_variants};
+    LayoutBudget layout_budget = LayoutBudget::unbounded();
+    const PendingVariantFieldPacks packs = group.layout(layout_budget);
+
+    expect(group.is_valid(packs));
+    expect(eq(layout::generation::variant_layout::packs_size(packs), 20u));
+    expect(eq(layout_budget.greedy_layouts, 1u));
+    expect(eq(layout_budget.bytes_above_lower_bound, 8u));
+};
+
+"Undo takes back a layout"_test = [] {
+    Group group {perfect_variants};
+    const std::vector<QueuedField> queued_fields = group.queued_fields;
+    const std::vector<VariantLeafMeta> metas = group.metas;
+
+    LayoutUndo undo {group.queued_fields, group.fixed_offsets, {}, group.metas};
+    const LayoutUndo::Mark initial = undo.mark(0);
+    LayoutBudget layout_budget = LayoutBudget::unbounded();
+    const PendingVariantFieldPacks packs = group.layout(layout_budget);
+    expect(group.is_valid(packs));
+
+    undo.undo(initial);
+    undo.release(initial);
+    expect(std::ranges::equal(group.queued_fields, queued_fields, [](const QueuedField& a, const QueuedField& b) { return a.size == b.size; }));
+    expect(std::ranges::all_of(group.fixed_offsets, [](const FixedOffset& offset) { return offset == FixedOffset::empty(); }));
+    expect(same_metas(group.metas, metas));
+
+    // The same fields lay out again from the restored state.
+    const PendingVariantFieldPacks again = group.layout(layout_budget);
+    expect(group.is_valid(again));
+    expect(eq(layout::generation::variant_layout::packs_size(again), 16u));
+};
+
+}
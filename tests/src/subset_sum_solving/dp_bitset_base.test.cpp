@@ -0,0 +1,59 @@
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <vector>
+#include <boost/ut.hpp>
+#include "../../../src/subset_sum_solving/dp_bitset_base.hpp"
+
+using namespace boost::ut;
+using dp_bitset_base::num_t, dp_bitset_base::word_t;
+
+namespace {
+
+bool batched_matches_sequential (const std::vector<num_t>& nums, const num_t target) {
+    const num_t word_count = dp_bitset_base::bitset_word_count(target);
+
+    std::vector<word_t> sequential (word_count);
+    std::vector<word_t> batched (word_count);
+    dp_bitset_base::init_bits(sequential.data(), word_count);
+    dp_bitset_base::init_bits(batched.data(), word_count);
+
+    for (const num_t num : nums) {
+        dp_bitset_base::apply_num_unsafe(num, sequential.data(), word_count);
+    }
+    dp_bitset_base::apply_nums_unsafe(nums, batched.data(), word_count);
+
+    return std::memcmp(sequential.data(), batched.data(), word_count * sizeof(word_t)) == 0;
+}
+
+} // namespace
+
+int main () {
+
+"Batched nums within a single tile"_test = [] {
+    expect(batched_matches_sequential({1, 3, 7, 64, 65}, 200));
+};
+
+"Batched nums carry across tile boundaries"_test = [] {
+    const num_t tile_bits = dp_bitset_base::TILE_WORDS * dp_bitset_base::WORD_BITS;
+    expect(batched_matches_sequential({1, 63, 64, 255, 256, tile_bits - 1}, tile_bits * 5));
+};
+
+"Batched nums reaching back more than one tile"_test = [] {
+    const num_t tile_bits = dp_bitset_base::TILE_WORDS * dp_bitset_base::WORD_BITS;
+    expect(batched_matches_sequential({tile_bits, tile_bits * 2 + 5, 17}, tile_bits * 4));
+};
+
+"Batched nums match sequential application for random inputs"_test = [] {
+    std::mt19937_64 rng {42};
+    for (int i = 0; i < 200; i++) {
+        const num_t target = (rng() % 100000) + 1;
+        std::vector<num_t> nums ((rng() % 12) + 1);
+        for (num_t& num : nums) {
+            num = (rng() % 2 == 0) ? (rng() % target) + 1 : (rng() % std::min<num_t>(target, 600)) + 1;
+        }
+        expect(batched_matches_sequential(nums, target));
+    }
+};
+
+}